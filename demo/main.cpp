@@ -5,13 +5,16 @@
 #include <libconfig.h++>
 #include <src/simulation.hpp>
 #include <src/utils/cfg_reader.hpp>
+#include <src/utils/pilot_io.hpp>
+#include <src/utils/transition_dataset.hpp>
 
 using namespace L2Fsim;
 
 /**
  * @brief Create environment
  *
- * Create an environment and save it at the specified location.
+ * Create an environment and save it at the specified location. The scenario is shared with the
+ * zones later built from the same location, which do not read the saved files back.
  * @param {bool} save; if true, save the scenario for vizualization
  * @param {double} dt; thermal refreshment rate (s)
  * @param {int} model; thermal model selection
@@ -20,8 +23,9 @@ using namespace L2Fsim;
  * 3: Lenschow
  * 4: Geodon
  * 5: Lawrance
+ * @return {std::shared_ptr<const thermal_scenario>} created scenario, to be kept while it is shared
  */
-void create_environment(bool save, double dt=1., int model=1) {
+std::shared_ptr<const thermal_scenario> create_environment(bool save, double dt=1., int model=1) {
     double t_start = -500.;
     double t_limit = 1000.;
     double windx = 0.;
@@ -69,9 +73,12 @@ void create_environment(bool save, double dt=1., int model=1) {
         fz.save_updraft_values(dx,dy,z_vec,t_vec,"data/updraft_field.dat");
     }
 
-    // 4. Save the scenario
+    // 4. Save and share the scenario
     fz.save_scenario("config/fz_scenario.csv");
     fz.save_fz_cfg("config/fz_config.csv");
+    std::shared_ptr<const thermal_scenario> scenario = fz.share_scenario();
+    thermal_scenario::share("config/fz_scenario.csv","config/fz_config.csv",scenario);
+    return scenario;
 }
 
 /**
@@ -102,27 +109,45 @@ void run_with_config(const char *cfg_path) {
 
     // 5. Stepper
 	mysim.st = cfgr.read_stepper(cfg,Dt/nb_dt);
+	cfgr.read_event_locator(cfg,mysim.st->evl);
 
     // 6. Pilot
 	mysim.pl = cfgr.read_pilot(cfg);
-
-	// 7. Run the simulation
+    std::string pl_load_path, pl_save_path;
+    double pl_save_period = 0., next_save = 0.;
+    cfgr.read_pilot_io(cfg,pl_load_path,pl_save_path,pl_save_period);
+    if(!pl_load_path.empty()) {load_pilot_parameters(*mysim.pl,pl_load_path);}
+    next_save = pl_save_period;
+
+    // 7. Transition dataset
+    std::string ds_prefix;
+    unsigned int ds_chunk_size = 1<<16;
+    cfgr.read_dataset(cfg,ds_prefix,ds_chunk_size);
+    if(!ds_prefix.empty()) {mysim.recorder.reset(new transition_writer(ds_prefix,0,ds_chunk_size));}
+
+	// 8. Run the simulation
 	bool eos = false;
 	mysim.clear_saves();
     while(!(is_greater_than(t,t_lim)) && !eos) {
         std::cout << t << std::endl;
         mysim.save();
         mysim.step(t,Dt,eos);
+        if(!pl_save_path.empty() && pl_save_period > 0. && !is_less_than(t,next_save)) {
+            save_pilot_parameters(*mysim.pl,pl_save_path);
+            next_save += pl_save_period;
+        }
     }
 
-	// 8. End of simulation
+	// 9. End of simulation
 	std::cout << "End of simulation\n";
+    if(!pl_save_path.empty()) {save_pilot_parameters(*mysim.pl,pl_save_path);}
+	mysim.pl->print_decision_stats(std::cout);
 }
 
 int main() {
     try {
         srand(time(NULL));
-        create_environment(false);
+        std::shared_ptr<const thermal_scenario> scenario = create_environment(false);
         run_with_config("config/main.cfg");
     }
     catch(const std::exception &e) {
@@ -5,6 +5,7 @@
 #include <state.hpp>
 #include <command.hpp>
 #include <vector>
+#include <string>
 #include <iostream>
 
 /**
@@ -50,6 +51,32 @@ public:
      */
     virtual bool is_in_model() = 0;
 
+    /**
+     * @brief Number of event functions
+     *
+     * Event functions are positive while the state is in the model's range of validity; a
+     * terminal event occurs when one of them crosses zero. They allow the steppers to locate
+     * the exact time of the events within a time step.
+     */
+    virtual unsigned int nb_events() {return 0;}
+
+    /**
+     * @brief Evaluate an event function
+     * @param {unsigned int} i; indice of the event function
+     * @param {state &} s; evaluated state
+     * @return {double} value of the event function, non-positive values are out of the model
+     */
+    virtual double event_function(unsigned int i, state &s) {
+        (void) i; (void) s; // no event by default
+        return 1.;
+    }
+
+    /** @brief Get the name of an event function */
+    virtual std::string event_name(unsigned int i) {
+        (void) i;
+        return "";
+    }
+
     /** @brief Return the saved data at each time step */
     virtual std::vector<double> get_save() = 0;
 };
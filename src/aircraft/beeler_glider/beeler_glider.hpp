@@ -33,66 +33,70 @@
  *
  * @note the earth frame corresponds to the directions of the north, east and downward for the x, y and z axis. However the z notation used in the code corresponds to the altitude i.e. '-z'
  * @note khi, gamma and sigma form an euler sequence leading to the velocity frame
+ * @note the template parameter T is the scalar type of the state, of the command and of the aerodynamic
+ * computations ('double', 'float' or a dual number of 'dual.hpp' for the forward-mode differentiation),
+ * 'beeler_glider' is the double precision model
  */
 
 namespace L2Fsim {
 
-class beeler_glider : public aircraft {
+template <class T>
+class basic_beeler_glider : public aircraft {
 public:
     /**
      * Attributes
-     * @param {beeler_glider_state} s; the state of the aircraft
-     * @param {beeler_glider_command} u; the command of the aircraft
-     * @param {double} mass; mass in [0.23kg; 5.44kg]
-     * @param {double} wingspan; wing span in [1.52m; 3.55m]
-     * @param {double} aspect_ratio; aspect ratio in [6; 16]
-     * @param {double} AR_V; aspect ratio of vertical tail
-     * @param {double} lt; fuselage moment arm length
-     * @param {double} V_H; horizontal tail volume ratio
-     * @param {double} V_V; vertical tail volume ratio
-     * @param {double} c_; mean aerodynamic cord
-     * @param {double} S; wing surface area
-     * @param {double} S_F; fuselage area
-     * @param {double} S_T; horizontal tail surface
-     * @param {double} S_V; vertical tail surface
-     * @param {double} e; Oswald efficiency number
-     * @param {double} Re; Reynolds number
-     * @param {double} a0; lift curve slope
-     * @param {double} alpha0; zero point
-     * @param {double} C_d_0, C_d_L; wing profile drag coefficients
-     * @param {double} C_L_min, C_L_alpha, C_C_beta; minimum lift
-     * @param {double} C_D_F; fuselage drag coefficient
-     * @param {double} C_D_T; tail drag coefficient
-     * @param {double} C_D_E; miscellaneous "extra drag" coefficient
-     * @param {double} C_D_0; constant part of the drag coefficient with wind
+     * @param {basic_beeler_glider_state<T>} s; the state of the aircraft
+     * @param {basic_beeler_glider_command<T>} u; the command of the aircraft
+     * @param {T} mass; mass in [0.23kg; 5.44kg]
+     * @param {T} wingspan; wing span in [1.52m; 3.55m]
+     * @param {T} aspect_ratio; aspect ratio in [6; 16]
+     * @param {T} AR_V; aspect ratio of vertical tail
+     * @param {T} lt; fuselage moment arm length
+     * @param {T} V_H; horizontal tail volume ratio
+     * @param {T} V_V; vertical tail volume ratio
+     * @param {T} c_; mean aerodynamic cord
+     * @param {T} S; wing surface area
+     * @param {T} S_F; fuselage area
+     * @param {T} S_T; horizontal tail surface
+     * @param {T} S_V; vertical tail surface
+     * @param {T} e; Oswald efficiency number
+     * @param {T} Re; Reynolds number
+     * @param {T} a0; lift curve slope
+     * @param {T} alpha0; zero point
+     * @param {T} C_d_0, C_d_L; wing profile drag coefficients
+     * @param {T} C_L_min, C_L_alpha, C_C_beta; minimum lift
+     * @param {T} C_D_F; fuselage drag coefficient
+     * @param {T} C_D_T; tail drag coefficient
+     * @param {T} C_D_E; miscellaneous "extra drag" coefficient
+     * @param {T} C_D_0; constant part of the drag coefficient with wind
      */
-    beeler_glider_state s;
-    beeler_glider_command u;
-    double mass;
-    double wingspan;
-    double aspect_ratio;
-    double AR_V = .5*aspect_ratio;
-    double lt = .28*wingspan;
-    double V_H = .4;
-    double V_V = .02;
-    double c_ = 1.03 * wingspan / aspect_ratio;
-    double S = wingspan * wingspan / aspect_ratio;
-	double S_F = .01553571429*wingspan*wingspan + .01950357142*wingspan - .01030412685;
-    double S_T = V_H * c_ * S / lt;
-    double S_V = V_V * wingspan * S / lt;
-    double e = .95;
+    basic_beeler_glider_state<T> s;
+    basic_beeler_glider_command<T> u;
+    T mass;
+    T wingspan;
+    T aspect_ratio;
+    T AR_V = .5*aspect_ratio;
+    T lt = .28*wingspan;
+    T V_H = .4;
+    T V_V = .02;
+    T c_ = 1.03 * wingspan / aspect_ratio;
+    T S = wingspan * wingspan / aspect_ratio;
+	T S_F = .01553571429*wingspan*wingspan + .01950357142*wingspan - .01030412685;
+    T S_T = V_H * c_ * S / lt;
+    T S_V = V_V * wingspan * S / lt;
+    T e = .95;
     //double Re = 150000.; //unused
-    double a0 = .1*(180./M_PI);
-    double alpha0 = -2.5*(M_PI/180.);
-    double C_d_0 = .01;
-    double C_d_L = .05;
-    double C_L_min = .4;
-    double C_L_alpha = a0/(1.+a0/(M_PI*e*aspect_ratio));
-    double C_C_beta = (a0/(1.+a0/(M_PI*e*AR_V))) * (S_V/S);
-	double C_D_F = .008;
-	double C_D_T = .01;
-	double C_D_E = .002;
-	double C_D_0 = C_D_F * S_F / S + C_D_T * (S_T + S_V) / S + C_D_E + C_d_0;
+    T a0 = .1*(180./M_PI);
+    T alpha0 = -2.5*(M_PI/180.);
+    T C_d_0 = .01;
+    T C_d_L = .05;
+    T C_L_min = .4;
+    T C_L_alpha = a0/(1.+a0/(M_PI*e*aspect_ratio));
+    T C_C_beta = (a0/(1.+a0/(M_PI*e*AR_V))) * (S_V/S);
+	T C_D_F = .008;
+	T C_D_T = .01;
+	T C_D_E = .002;
+	T C_D_0 = C_D_F * S_F / S + C_D_T * (S_T + S_V) / S + C_D_E + C_d_0;
 
     /**
      * Constructor
@@ -102,12 +106,12 @@ public:
      * @param {double} ws; wing span
      * @param {double} ar; aspect ratio
      */
-    beeler_glider(
-        beeler_glider_state _s,
-        beeler_glider_command _u,
-        double m=1.36,
-        double ws=1.524,
-        double ar=16.) :
+    basic_beeler_glider(
+        basic_beeler_glider_state<T> _s,
+        basic_beeler_glider_command<T> _u,
+        T m=1.36,
+        T ws=1.524,
+        T ar=16.) :
         s(_s),
         u(_u),
         mass(m),
@@ -120,21 +124,21 @@ public:
 
 	/**
 	 * @brief Set the state of the aircraft
-	 * @param {const beeler_glider_state &} _s; input state
+	 * @param {const basic_beeler_glider_state<T> &} _s; input state
 	 */
-	void set_state(const beeler_glider_state &_s) {s = _s;}
+	void set_state(const basic_beeler_glider_state<T> &_s) {s = _s;}
 
     /** @brief Get a reference on the command */
     command & get_command() override {return u;}
 
 	/**
 	 * @brief Set the command of the aircraft
-	 * @param {const beeler_glider_command &} _u; input command
+	 * @param {const basic_beeler_glider_command<T> &} _u; input command
 	 */
-	void set_command(const beeler_glider_command &_u) {u = _u;}
+	void set_command(const basic_beeler_glider_command<T> &_u) {u = _u;}
 
     double get_distance_to_center() override {
-        return sqrt(s.x * s.x + s.y * s.y);
+        return value_of(sqrt(s.x * s.x + s.y * s.y));
     }
 
     /** @brief Apply the command i.e. modify the state attribute of the aircraft accordingly to the command */
@@ -150,27 +154,27 @@ public:
      * @param {const flight_zone &} fz; flight zone
      * @param {const double} t; current time
      * @param {state &} _s; updated state
-     * @warning dynamic cast from state to beeler_glider_state
+     * @warning dynamic cast from state to basic_beeler_glider_state
      */
     aircraft & update_state_dynamic(flight_zone &fz, const double t, state &_s) override {
-        beeler_glider_state &s = dynamic_cast <beeler_glider_state &> (_s);
-        double lift=0., drag=0., sideforce=0.;
-        double V = s.V;
-        double gamma = s.gamma;
-        double khi = s.khi;
-        double sigma = s.sigma;
-
-		double cosgamma = cos(gamma);
-		double singamma = sin(gamma);
-		double cossigma = cos(sigma);
-		double sinsigma = sin(sigma);
-
-        calc_aero_forces(fz, t, lift, drag, sideforce);
+        basic_beeler_glider_state<T> &s = dynamic_cast <basic_beeler_glider_state<T> &> (_s);
+        T lift=0, drag=0, sideforce=0;
+        T V = s.V;
+        T gamma = s.gamma;
+        T khi = s.khi;
+        T sigma = s.sigma;
+
+		T cosgamma = cos(gamma);
+		T singamma = sin(gamma);
+		T cossigma = cos(sigma);
+		T sinsigma = sin(sigma);
+
+        calc_aero_forces(fz, t, s, lift, drag, sideforce);
         s.xdot = V * cosgamma * cos(khi);
         s.ydot = V * cosgamma * sin(khi);
         s.zdot = V * singamma;
-        s.Vdot = - drag / mass - 9.81 * singamma;
-        s.gammadot = (lift * cossigma + sideforce * sinsigma) / (mass * V) - 9.81 * cosgamma / V;
+        s.Vdot = - drag / mass - T(9.81) * singamma;
+        s.gammadot = (lift * cossigma + sideforce * sinsigma) / (mass * V) - T(9.81) * cosgamma / V;
         s.khidot = (lift * sinsigma - sideforce * cossigma) / (mass * V * cosgamma);
         return *this;
     }
@@ -180,9 +184,9 @@ public:
      * @return true if the aircraft still is in its validity model
      */
     bool is_in_model() override {
-        double gm = s.gamma;
-        double alpgm = s.alpha + gm;
-        double mam = s.max_angle_magnitude;
+        T gm = s.gamma;
+        T alpgm = s.alpha + gm;
+        T mam = s.max_angle_magnitude;
         if(s.z < 0.) {
             std::cout << "STOP: altitude 'z' < 0" << std::endl;
             return false;
@@ -206,6 +210,44 @@ public:
         return true;
     }
 
+    /**
+     * @brief Number of event functions
+     *
+     * The conditions checked by 'is_in_model': altitude, elevation angle and inclination angle
+     * bounds.
+     */
+    unsigned int nb_events() override {return 5;}
+
+    /**
+     * @brief Evaluate an event function
+     * @param {unsigned int} i; indice of the event function
+     * @param {state &} _s; evaluated state
+     * @return {double} value of the event function, non-positive values are out of the model
+     * @warning dynamic cast from state to basic_beeler_glider_state
+     */
+    double event_function(unsigned int i, state &_s) override {
+        basic_beeler_glider_state<T> &s = dynamic_cast <basic_beeler_glider_state<T> &> (_s);
+        T mam = s.max_angle_magnitude;
+        switch(i) {
+            case 0: return value_of(s.z);
+            case 1: return value_of(mam - s.gamma);
+            case 2: return value_of(s.gamma + mam);
+            case 3: return value_of(mam - (s.alpha + s.gamma));
+            default: return value_of((s.alpha + s.gamma) + mam);
+        }
+    }
+
+    /** @brief Get the name of an event function */
+    std::string event_name(unsigned int i) override {
+        switch(i) {
+            case 0: return "altitude 'z' < 0";
+            case 1: return "elevation angle 'gamma' > max_angle_magnitude";
+            case 2: return "elevation angle 'gamma' < -max_angle_magnitude";
+            case 3: return "inclination angle 'gamma+alpha' > max_angle_magnitude";
+            default: return "inclination angle 'gamma+alpha' < -max_angle_magnitude";
+        }
+    }
+
     /** @brief Return the saved data at each time step */
     std::vector<double> get_save() override {
         return s.get_save();
@@ -217,62 +259,55 @@ protected:
      * @brief Compute lift, drag and sideforce
      * @param {flight_zone &} fz; flight zone
      * @param {const double} t; current time
-     * @param {double &} lift, drag, sideforce; aerodynamic forces
+     * @param {const basic_beeler_glider_state<T> &} s; state at which the forces are evaluated (e.g. an integrator's stage)
+     * @param {T &} lift, drag, sideforce; aerodynamic forces
      */
     void calc_aero_forces(flight_zone &fz,
                         const double t,
-                        double &lift,
-                        double &drag,
-                        double &sideforce) {
-        double x = s.x;
-        double y = s.y;
-        double z = s.z;
-        double V = s.V;
-        double gamma = s.gamma;
-        double khi = s.khi;
-        double alpha = s.alpha;
-        double beta = s.beta;
-        double sigma = s.sigma;
-		double cos_gamma = cos(gamma);
-		double cos_alpha = cos(alpha);
-		double sin_alpha = sin(alpha);
-		double cos_beta = cos(beta);
-		double sin_beta = sin(beta);
+                        const basic_beeler_glider_state<T> &s,
+                        T &lift,
+                        T &drag,
+                        T &sideforce) {
+        T x = s.x;
+        T y = s.y;
+        T z = s.z;
+        T V = s.V;
+        T gamma = s.gamma;
+        T khi = s.khi;
+        T alpha = s.alpha;
+        T beta = s.beta;
+        T sigma = s.sigma;
+		T cos_gamma = cos(gamma);
 
         /** Relative wind */
-        std::vector<double> w(3);
-        fz.wind(x, y, z, t, w);
+        std::vector<T> w(3);
+        wind_at(fz, x, y, z, t, w); // the flight zones are in double precision, see 'flight_zone.hpp'
 
         /** Wind relative velocity */
-        std::vector<double> V_w(3);
-        std::vector<double> X_w(3);
+        std::vector<T> V_w(3);
+        std::vector<T> X_w(3);
 
         /** Wind relative angles */
-        double alpha_w=0., beta_w=0., gamma_w=0., khi_w=0., sigma_w=0.;
+        T alpha_w=0, beta_w=0, gamma_w=0, khi_w=0, sigma_w=0;
 
         /** Rotation matrices and quaternions */
-        quaternion rviq; // quaternion version of the Euler rotation sequence {khi,gamma,sigma}
-        quaternion rwiq; // quaternion version of the Euler rotation sequence {khi_w,gamma_w,sigma_w}
-
-        std::vector<double> rbv(9); // rotation from velocity frame to body frame R_BV
-        std::vector<double> rbv1(9); // rotation of alpha
-        std::vector<double> rbv2(9); // rotation of beta
-        quaternion rbvq; //quaternion version R_BV
-        quaternion rbv1q;
-        quaternion rbv2q;
-
-        std::vector<double> m(9); // M matrix, used to retrieve wind relative angles
-        std::vector<double> m11(9);
-        std::vector<double> m12(9);
-        quaternion mq; // quaternion version of M
-        quaternion m11q;
-        quaternion m12q;
+        basic_quaternion<T> rviq; // quaternion version of the Euler rotation sequence {khi,gamma,sigma}
+        basic_quaternion<T> rwiq; // quaternion version of the Euler rotation sequence {khi_w,gamma_w,sigma_w}
+
+        basic_quaternion<T> rbvq; // quaternion version of the rotation from velocity frame to body frame R_BV
+        basic_quaternion<T> rbv1q; // rotation of alpha
+        basic_quaternion<T> rbv2q; // rotation of beta
+
+        std::vector<T> m(9); // M matrix, used to retrieve wind relative angles
+        basic_quaternion<T> mq; // quaternion version of M
+        basic_quaternion<T> m11q;
+        basic_quaternion<T> m12q;
 
         V_w.at(0) = V * cos_gamma * cos(khi) - w.at(0);
         V_w.at(1) = V * cos_gamma * sin(khi) - w.at(1);
         V_w.at(2) = V * sin(gamma) - w.at(2);
 
-		double V_w_2norm = sqrt(V_w.at(0)*V_w.at(0) + V_w.at(1)*V_w.at(1) + V_w.at(2)*V_w.at(2));
+		T V_w_2norm = sqrt(V_w.at(0)*V_w.at(0) + V_w.at(1)*V_w.at(1) + V_w.at(2)*V_w.at(2));
 
         X_w.at(0) = V_w.at(0) / V_w_2norm;
         X_w.at(1) = V_w.at(1) / V_w_2norm;
@@ -280,58 +315,24 @@ protected:
 
         // Calculation of gamma_w and khi_w
         gamma_w = asin(X_w.at(2)); // taking into account the signe change
-		double cos_gamma_w = cos(gamma_w);
-		double sin_gamma_w = sin(gamma_w);
-
-        if(X_w.at(0) / cos_gamma_w > 1.) {
-            khi_w = 0.;
-        } else if (X_w.at(0) / cos_gamma_w < -1.) {
-            khi_w = M_1_PI;
-        } else {
-            khi_w = sign(X_w.at(1) / cos_gamma_w) * acos(X_w.at(0) / cos_gamma_w);
-        }
-		double cos_khi_w = cos(khi_w);
-		double sin_khi_w = sin(khi_w);
+
+        khi_w = atan2(X_w.at(1), X_w.at(0)); // cos(gamma_w) >= 0, smooth at khi_w = 0 unlike the arc cosine
 
         // Calculation of alpha_w, beta_w and sigma_w : use of rotation matrices and quaternions
 
         rviq.fromEuler(khi, gamma, sigma);
 
-        rbv1.at(0) = cos_alpha;
-        rbv1.at(2) = sin_alpha;
-        rbv1.at(4) = 1.;
-        rbv1.at(6) = -sin_alpha;
-        rbv1.at(8) = cos_alpha;
-        rbv1.at(1) = rbv1.at(3) = rbv1.at(5) = rbv1.at(7) = 0.;
-
-        rbv2.at(0) = cos_beta;
-        rbv2.at(1) = sin_beta;
-        rbv2.at(3) = -sin_beta;
-        rbv2.at(4) = cos_beta;
-        rbv2.at(8) = 1.;
-        rbv2.at(2) = rbv2.at(5) = rbv2.at(6) = rbv2.at(7) = 0.;
-
-        rbv1q.fromRotationMatrix(rbv1);
-        rbv2q.fromRotationMatrix(rbv2);
+        // Elementary rotations built from their axis and angle: same rotations as the matrices
+        // [cos 0 sin; 0 1 0; -sin 0 cos] of alpha and -gamma_w and [cos sin 0; -sin cos 0; 0 0 1]
+        // of beta and khi_w, without the square roots of 'fromRotationMatrix' which amplify the
+        // rounding errors and are not differentiable at the identity
+        rbv1q.fromAxisAngle(0, 1, 0, alpha);
+        rbv2q.fromAxisAngle(0, 0, 1, -beta);
         rbvq = rbv1q;
         rbvq.multRight(rbv2q);
 
-        m11.at(0) = cos_gamma_w;
-        m11.at(2) = -sin_gamma_w;
-        m11.at(4) = 1.;
-        m11.at(6) = sin_gamma_w;
-        m11.at(8) = cos_gamma_w;
-        m11.at(1) = m11.at(3) = m11.at(5) = m11.at(7) = 0.;
-
-        m12.at(0) = cos_khi_w;
-        m12.at(1) = sin_khi_w;
-        m12.at(3) = -sin_khi_w;
-        m12.at(4) = cos_khi_w;
-        m12.at(8) = 1.;
-        m12.at(2) = m12.at(5) = m12.at(6) = m12.at(7) = 0.;
-
-        m11q.fromRotationMatrix(m11);
-        m12q.fromRotationMatrix(m12);
+        m11q.fromAxisAngle(0, 1, 0, -gamma_w);
+        m12q.fromAxisAngle(0, 0, 1, -khi_w);
         mq = m11q;
         mq.multRight(m12q);
         mq.multRight(rviq);
@@ -339,38 +340,23 @@ protected:
         mq.toRotationMatrix(m);
 
         alpha_w = asin(m.at(2));
-		double cos_alpha_w = cos(alpha_w);
-
-        if(m.at(8) / cos_alpha_w > 1.) {
-            sigma_w = 0.;
-        }else if(m.at(8) / cos_alpha_w < -1.){
-            sigma_w = M_1_PI;
-        }else{
-            sigma_w = sign(-m.at(5) / cos_alpha_w) * acos(m.at(8) / cos_alpha_w);
-        }
-
-        if(m.at(0) / cos_alpha_w > 1.) {
-            beta_w = 0.;
-        }else if(m.at(0) / cos_alpha_w < -1.){
-            beta_w = M_1_PI;
-        }else{
-            beta_w = sign(m.at(1) / cos_alpha_w) * acos(m.at(0) / cos_alpha_w);
-        }
+        sigma_w = atan2(-m.at(5), m.at(8)); // cos(alpha_w) >= 0
+        beta_w = atan2(m.at(1), m.at(0));
 
         /** Calc of the aerodynamic force coefficients with wind */
-        double C_C_w = C_C_beta * beta_w;
-        double C_L_w = C_L_alpha * (alpha_w - alpha0);
-        double C_D_w = C_D_0 + C_d_L * (C_L_w - C_L_min) * (C_L_w - C_L_min) + (C_L_w*C_L_w + C_C_w*C_C_w*(S / S_V)) / (M_PI*e*aspect_ratio);
+        T C_C_w = C_C_beta * beta_w;
+        T C_L_w = C_L_alpha * (alpha_w - alpha0);
+        T C_D_w = C_D_0 + C_d_L * (C_L_w - C_L_min) * (C_L_w - C_L_min) + (C_L_w*C_L_w + C_C_w*C_C_w*(S / S_V)) / (T(M_PI)*e*aspect_ratio);
 
         // Dynamic pressure
-        double q = .5 * 1.225 * V_w_2norm * V_w_2norm;
-		double qS = q*S;
+        T q = T(.5 * 1.225) * V_w_2norm * V_w_2norm;
+		T qS = q*S;
 
         // Calc of the aerodynamic forces in wind frame
-        double drag_w = qS * C_D_w;
-        double sideforce_w = qS * C_C_w;
-        double lift_w = qS * C_L_w;
-		std::vector<double> forces_w = {-drag_w, -sideforce_w, -lift_w};
+        T drag_w = qS * C_D_w;
+        T sideforce_w = qS * C_C_w;
+        T lift_w = qS * C_L_w;
+		std::vector<T> forces_w = {-drag_w, -sideforce_w, -lift_w};
 
 		// Transformation to the velocity frame
         rwiq.fromEuler(khi_w, gamma_w, sigma_w);
@@ -384,6 +370,9 @@ protected:
     }
 };
 
+/** @brief Beeler's glider in double precision */
+typedef basic_beeler_glider<double> beeler_glider;
+
 }
 
 #endif
@@ -0,0 +1,416 @@
+#ifndef L2FSIM_BEELER_GLIDER_BATCH_HPP_
+#define L2FSIM_BEELER_GLIDER_BATCH_HPP_
+
+#include <beeler_glider/beeler_glider.hpp>
+#include <flight_zone.hpp>
+#include <utils.hpp>
+#include <simd.hpp>
+#include <vector>
+#include <cmath>
+
+/**
+ * @file beeler_glider_batch.hpp
+ * @brief Batch propagation of many Beeler's glider states
+ * @version 1.1
+ * @since 1.1
+ *
+ * K independent states of a same 'beeler_glider' are stored in structure-of-arrays form
+ * (one array per variable, one lane per state) and propagated together.
+ * The dynamics are those of 'beeler_glider::update_state_dynamic'; the rotations between the
+ * inertial, velocity, body and wind frames are expanded into fixed 3x3 products instead of
+ * temporary vectors and quaternions, and the wind-relative angles that are only used through
+ * their cosine and sine are not computed. Everything but the wind is evaluated on packs of
+ * lanes with SIMD instructions (see 'simd.hpp').
+ * No allocation is performed once the batch is resized.
+ * @note the wind is evaluated lane by lane through the 'flight_zone' interface
+ * @note the arrays are padded to a multiple of the pack width, the padding lanes are computed but never read
+ * @note the template parameter T is the scalar type of the lanes: a pack holds 2 lanes in double
+ * precision and 4 lanes in single precision; the times of the lanes stay in double precision
+ */
+
+namespace L2Fsim {
+
+/**
+ * @brief Integrated variables and rates of a set of lanes
+ */
+template <class T>
+struct basic_beeler_glider_lanes {
+    std::vector<T> x, y, z, V, gamma, khi; ///< Integrated variables
+    std::vector<T> xdot, ydot, zdot, Vdot, gammadot, khidot; ///< Rates
+
+    /** @brief Set the number of lanes */
+    void resize(unsigned int n) {
+        for(auto v : {&x,&y,&z,&V,&gamma,&khi,&xdot,&ydot,&zdot,&Vdot,&gammadot,&khidot}) {
+            v->resize(n);
+        }
+    }
+};
+
+template <class T>
+class basic_beeler_glider_batch {
+public:
+    /**
+     * @brief Attributes
+     * @param {basic_beeler_glider_lanes<T>} s; integrated variables and rates of the states
+     * @param {std::vector<T>} alpha, beta, sigma, max_angle_magnitude; static variables of the states
+     * @param {std::vector<double>} time; times of the states
+     * @param {std::vector<T>} dalpha, dbeta, dsigma; commands of the lanes
+     * @param {T} mass, S, S_V, e, aspect_ratio, alpha0, C_L_alpha, C_C_beta, C_D_0, C_d_L, C_L_min; glider parameters, see 'beeler_glider'
+     */
+    basic_beeler_glider_lanes<T> s;
+    std::vector<T> alpha, beta, sigma, max_angle_magnitude;
+    std::vector<double> time;
+    std::vector<T> dalpha, dbeta, dsigma;
+    T mass;
+    T S;
+    T S_V;
+    T e;
+    T aspect_ratio;
+    T alpha0;
+    T C_L_alpha;
+    T C_C_beta;
+    T C_D_0;
+    T C_d_L;
+    T C_L_min;
+
+    /**
+     * @brief Constructor
+     * @param {const basic_beeler_glider<U> &} ac; glider whose parameters are used, of any scalar type
+     * @param {unsigned int} n; number of lanes
+     */
+    template <class U>
+    basic_beeler_glider_batch(const basic_beeler_glider<U> &ac, unsigned int n=0) :
+        mass(ac.mass),
+        S(ac.S),
+        S_V(ac.S_V),
+        e(ac.e),
+        aspect_ratio(ac.aspect_ratio),
+        alpha0(ac.alpha0),
+        C_L_alpha(ac.C_L_alpha),
+        C_C_beta(ac.C_C_beta),
+        C_D_0(ac.C_D_0),
+        C_d_L(ac.C_d_L),
+        C_L_min(ac.C_L_min)
+    {
+        resize(n);
+    }
+
+    /** @brief Number of lanes */
+    unsigned int size() const {return nb_lanes;}
+
+    /**
+     * @brief Set the number of lanes
+     *
+     * Allocation only occurs if the number of lanes exceeds the largest one used so far.
+     * @param {unsigned int} n; number of lanes
+     */
+    void resize(unsigned int n) {
+        const unsigned int W = simd<T>::width;
+        nb_lanes = n;
+        nb_padded = W * ((n + W - 1) / W);
+        s.resize(nb_padded);
+        stg.resize(nb_padded);
+        for(auto v : {&alpha,&beta,&sigma,&max_angle_magnitude,&dalpha,&dbeta,&dsigma,&w0,&w1,&w2}) {
+            v->resize(nb_padded);
+        }
+        time.resize(nb_padded);
+        for(auto &a : acc) {a.resize(nb_padded);}
+    }
+
+    /**
+     * @brief Set the state of a lane
+     * @param {unsigned int} i; lane
+     * @param {const basic_beeler_glider_state<U> &} st; state, of any scalar type
+     */
+    template <class U>
+    void set_state(unsigned int i, const basic_beeler_glider_state<U> &st) {
+        s.x[i] = st.x;
+        s.y[i] = st.y;
+        s.z[i] = st.z;
+        s.V[i] = st.V;
+        s.gamma[i] = st.gamma;
+        s.khi[i] = st.khi;
+        s.xdot[i] = st.xdot;
+        s.ydot[i] = st.ydot;
+        s.zdot[i] = st.zdot;
+        s.Vdot[i] = st.Vdot;
+        s.gammadot[i] = st.gammadot;
+        s.khidot[i] = st.khidot;
+        alpha[i] = st.alpha;
+        beta[i] = st.beta;
+        sigma[i] = st.sigma;
+        max_angle_magnitude[i] = st.max_angle_magnitude;
+        time[i] = st.time;
+    }
+
+    /**
+     * @brief Get the state of a lane
+     * @param {unsigned int} i; lane
+     * @param {basic_beeler_glider_state<U> &} st; output state, of any scalar type
+     */
+    template <class U>
+    void get_state(unsigned int i, basic_beeler_glider_state<U> &st) const {
+        st.x = s.x[i];
+        st.y = s.y[i];
+        st.z = s.z[i];
+        st.V = s.V[i];
+        st.gamma = s.gamma[i];
+        st.khi = s.khi[i];
+        st.xdot = s.xdot[i];
+        st.ydot = s.ydot[i];
+        st.zdot = s.zdot[i];
+        st.Vdot = s.Vdot[i];
+        st.gammadot = s.gammadot[i];
+        st.khidot = s.khidot[i];
+        st.alpha = alpha[i];
+        st.beta = beta[i];
+        st.sigma = sigma[i];
+        st.max_angle_magnitude = max_angle_magnitude[i];
+        st.time = time[i];
+    }
+
+    /**
+     * @brief Set the command of a lane
+     * @param {unsigned int} i; lane
+     * @param {const beeler_glider_command &} u; command
+     */
+    void set_command(unsigned int i, const beeler_glider_command &u) {
+        dalpha[i] = u.dalpha;
+        dbeta[i] = u.dbeta;
+        dsigma[i] = u.dsigma;
+    }
+
+    /** @brief Apply the commands of every lane, see 'beeler_glider::apply_command' */
+    void apply_command() {
+        for(unsigned int i=0; i<nb_lanes; ++i) {
+            alpha[i] += dalpha[i];
+            beta[i] += dbeta[i];
+            sigma[i] += dsigma[i];
+        }
+    }
+
+    /**
+     * @brief Compute the rates of every lane, see 'beeler_glider::update_state_dynamic'
+     * @param {flight_zone &} fz; flight zone
+     * @param {const double} toff; time offset added to the time of the lanes
+     * @param {basic_beeler_glider_lanes<T> &} l; lanes whose rates are computed from their integrated variables
+     */
+    void update_state_dynamic(flight_zone &fz, const double toff, basic_beeler_glider_lanes<T> &l) {
+        typedef typename simd<T>::type V;
+        const unsigned int W = simd<T>::width;
+
+        // Wind, lane by lane
+        for(unsigned int i=0; i<nb_lanes; ++i) {
+            fz.wind(l.x[i],l.y[i],l.z[i],time[i]+toff,w);
+            w0[i] = w[0];
+            w1[i] = w[1];
+            w2[i] = w[2];
+        }
+
+        const V zero = simd_set<T>(0);
+        const V one = simd_set<T>(1);
+        const T k_ind = 1. / (M_PI*e*aspect_ratio);
+        const T S_S_V = S / S_V;
+        const T qS_vw2 = .5 * 1.225 * S;
+        const T g = 9.81;
+        const T imass = 1. / mass;
+        const T pi = M_PI;
+        for(unsigned int i=0; i<nb_padded; i+=W) {
+            V cg, sg, ck, sk, cs, ss, ca, sa, cb, sb;
+            simd_sincos<T>(simd_load(&l.gamma[i]),sg,cg);
+            simd_sincos<T>(simd_load(&l.khi[i]),sk,ck);
+            simd_sincos<T>(simd_load(&sigma[i]),ss,cs);
+            simd_sincos<T>(simd_load(&alpha[i]),sa,ca);
+            simd_sincos<T>(simd_load(&beta[i]),sb,cb);
+            V V_ = simd_load(&l.V[i]);
+
+            // Wind relative velocity, heading and elevation
+            V vw0 = V_ * cg * ck - simd_load(&w0[i]);
+            V vw1 = V_ * cg * sk - simd_load(&w1[i]);
+            V vw2 = V_ * sg - simd_load(&w2[i]);
+            V vw = simd_sqrt<T>(vw0*vw0 + vw1*vw1 + vw2*vw2);
+            V sgw = vw2 / vw;
+            V cgw = simd_sqrt<T>(simd_max<T>(zero,one - sgw*sgw)); // gamma_w in [-pi/2,pi/2]
+            V ivc = one / (vw * cgw);
+            V ckw = simd_min<T>(one,simd_max<T>(-one,vw0 * ivc));
+            V skw = simd_sign<T>(vw1 * ivc) * simd_sqrt<T>(one - ckw*ckw);
+
+            // R_VI = Rz(khi) Ry(gamma) Rx(sigma)
+            V r00 = ck*cg;
+            V r10 = sk*cg;
+            V r20 = -sg;
+            V r01 = -sk*cs + ck*sg*ss;
+            V r11 = ck*cs + sk*sg*ss;
+            V r21 = cg*ss;
+            V r02 = sk*ss + ck*sg*cs;
+            V r12 = -ck*ss + sk*sg*cs;
+            V r22 = cg*cs;
+
+            // A = [cgw 0 -sgw; 0 1 0; sgw 0 cgw] [ckw skw 0; -skw ckw 0; 0 0 1] and B = A R_VI
+            V a00 = cgw*ckw, a01 = cgw*skw, a02 = -sgw;
+            V a10 = -skw, a11 = ckw;
+            V a20 = sgw*ckw, a21 = sgw*skw, a22 = cgw;
+            V b00 = a00*r00 + a01*r10 + a02*r20;
+            V b01 = a00*r01 + a01*r11 + a02*r21;
+            V b02 = a00*r02 + a01*r12 + a02*r22;
+            V b10 = a10*r00 + a11*r10;
+            V b12 = a10*r02 + a11*r12;
+            V b20 = a20*r00 + a21*r10 + a22*r20;
+            V b22 = a20*r02 + a21*r12 + a22*r22;
+
+            // M = B R_BV with R_BV = [ca*cb ca*sb sa; -sb cb 0; -sa*cb -sa*sb ca]
+            V m0 = b00*ca*cb - b01*sb - b02*sa*cb;
+            V m1 = b00*ca*sb + b01*cb - b02*sa*sb;
+            V m2 = b00*sa + b02*ca;
+            V m5 = b10*sa + b12*ca;
+            V m8 = b20*sa + b22*ca;
+
+            // Wind relative angles: alpha_w = asin(m2), beta_w = sign(m1)*acos(m0/cos(alpha_w)), sigma_w through its cosine and sine
+            V caw = simd_sqrt<T>(simd_max<T>(zero,one - m2*m2));
+            V icaw = one / caw;
+            V alpha_w = simd_atan<T>(m2 * icaw);
+            V abw = simd_atan<T>(((m1 < zero) ? -m1 : m1) / ((m0 < zero) ? -m0 : m0));
+            V beta_w = simd_sign<T>(m1 * icaw) * ((m0 < zero) ? pi - abw : abw);
+            V csw = simd_min<T>(one,simd_max<T>(-one,m8 * icaw));
+            V ssw = simd_sign<T>(-m5 * icaw) * simd_sqrt<T>(one - csw*csw);
+
+            // Aerodynamic forces in the wind frame
+            V C_C_w = C_C_beta * beta_w;
+            V C_L_w = C_L_alpha * (alpha_w - alpha0);
+            V dC = C_L_w - C_L_min;
+            V C_D_w = C_D_0 + C_d_L * dC * dC + (C_L_w*C_L_w + C_C_w*C_C_w*S_S_V) * k_ind;
+            V qS = qS_vw2 * vw * vw;
+            V f0 = -qS * C_D_w;
+            V f1 = -qS * C_C_w;
+            V f2 = -qS * C_L_w;
+
+            // Velocity frame forces: transposed R_VI applied to R_WI = Rz(khi_w) Ry(gamma_w) Rx(sigma_w) applied to the forces
+            V u1 = csw*f1 - ssw*f2;
+            V u2 = ssw*f1 + csw*f2;
+            V v0 = cgw*f0 + sgw*u2;
+            V v2 = -sgw*f0 + cgw*u2;
+            V g0 = ckw*v0 - skw*u1;
+            V g1 = skw*v0 + ckw*u1;
+            V h0 = ck*g0 + sk*g1;
+            V h1 = -sk*g0 + ck*g1;
+            V p0 = cg*h0 - sg*v2;
+            V p2 = sg*h0 + cg*v2;
+            V drag = -p0;
+            V sideforce = -(cs*h1 + ss*p2);
+            V lift = ss*h1 - cs*p2;
+
+            simd_store(&l.xdot[i],V_ * cg * ck);
+            simd_store(&l.ydot[i],V_ * cg * sk);
+            simd_store(&l.zdot[i],V_ * sg);
+            V imV = one / (mass * V_);
+            simd_store(&l.Vdot[i],- drag * imass - g * sg);
+            simd_store(&l.gammadot[i],(lift * cs + sideforce * ss) * imV - g * mass * cg * imV);
+            simd_store(&l.khidot[i],(lift * ss - sideforce * cs) * imV / cg);
+        }
+    }
+
+    /**
+     * @brief Euler transition of every lane, see 'optimistic_pilot::transition_function'
+     *
+     * The command is applied at each sub-step.
+     * @param {flight_zone &} fz; flight zone
+     * @param {const double} time_step_width; time-step-width
+     * @param {const double} sdt; sub-time-step-width
+     */
+    void euler_transition(flight_zone &fz, const double time_step_width, const double sdt) {
+        for(unsigned int k=0; k<(unsigned int)(time_step_width/sdt); ++k) {
+            apply_command();
+            update_state_dynamic(fz,0.,s);
+            apply_dynamic(s,s,sdt,s);
+            for(unsigned int i=0; i<nb_lanes; ++i) {time[i] += sdt;}
+        }
+    }
+
+    /**
+     * @brief RK4 transition of every lane, see 'rk4_integrator::step'
+     *
+     * The command is applied at each sub-step.
+     * @param {flight_zone &} fz; flight zone
+     * @param {const double} time_step_width; time-step-width
+     * @param {const double} sdt; sub-time-step-width
+     */
+    void rk4_transition(flight_zone &fz, const double time_step_width, const double sdt) {
+        const unsigned int n = nb_lanes;
+        for(unsigned int k=0; k<(unsigned int)(time_step_width/sdt); ++k) {
+            apply_command();
+            update_state_dynamic(fz,0.,s); // k1 in s
+            for(unsigned int i=0; i<n; ++i) {
+                acc_clear(i);
+                acc_add(i,s,1./6.);
+            }
+            apply_dynamic(s,s,.5*sdt,stg);
+            update_state_dynamic(fz,.5*sdt,stg); // k2
+            for(unsigned int i=0; i<n; ++i) {acc_add(i,stg,1./3.);}
+            apply_dynamic(s,stg,.5*sdt,stg);
+            update_state_dynamic(fz,.5*sdt,stg); // k3
+            for(unsigned int i=0; i<n; ++i) {acc_add(i,stg,1./3.);}
+            apply_dynamic(s,stg,sdt,stg);
+            update_state_dynamic(fz,sdt,stg); // k4
+            for(unsigned int i=0; i<n; ++i) {
+                acc_add(i,stg,1./6.);
+                s.xdot[i] = acc[0][i];
+                s.ydot[i] = acc[1][i];
+                s.zdot[i] = acc[2][i];
+                s.Vdot[i] = acc[3][i];
+                s.gammadot[i] = acc[4][i];
+                s.khidot[i] = acc[5][i];
+            }
+            apply_dynamic(s,s,sdt,s);
+            for(unsigned int i=0; i<n; ++i) {time[i] += sdt;}
+        }
+    }
+
+protected:
+    unsigned int nb_lanes = 0; ///< Number of lanes
+    unsigned int nb_padded = 0; ///< Number of lanes rounded up to a multiple of the pack width
+    basic_beeler_glider_lanes<T> stg; ///< RK4 stage
+    std::vector<T> acc[6]; ///< RK4 weighted sum of the rates
+    std::vector<double> w = std::vector<double>(3); ///< Wind buffer
+    std::vector<T> w0, w1, w2; ///< Wind of the lanes
+
+    /**
+     * @brief First order transition, see 'beeler_glider_state::apply_dynamic'
+     * @param {const basic_beeler_glider_lanes<T> &} x0; lanes holding the integrated variables at the beginning of the transition
+     * @param {const basic_beeler_glider_lanes<T> &} r; lanes holding the applied rates
+     * @param {const double} dt; time step
+     * @param {basic_beeler_glider_lanes<T> &} out; lanes receiving the integrated variables (may alias 'x0' or 'r')
+     */
+    void apply_dynamic(const basic_beeler_glider_lanes<T> &x0, const basic_beeler_glider_lanes<T> &r, const double dt, basic_beeler_glider_lanes<T> &out) {
+        for(unsigned int i=0; i<nb_lanes; ++i) {
+            out.x[i] = x0.x[i] + dt * r.xdot[i];
+            out.y[i] = x0.y[i] + dt * r.ydot[i];
+            out.z[i] = x0.z[i] + dt * r.zdot[i];
+            out.V[i] = x0.V[i] + dt * r.Vdot[i];
+            out.gamma[i] = wrap_angle(x0.gamma[i] + dt * r.gammadot[i]);
+            out.khi[i] = wrap_angle(x0.khi[i] + dt * r.khidot[i]);
+        }
+    }
+
+    /** @brief Reset the RK4 sum of a lane */
+    void acc_clear(unsigned int i) {
+        for(auto &a : acc) {a[i] = 0;}
+    }
+
+    /** @brief Add the weighted rates of a lane to the RK4 sum */
+    void acc_add(unsigned int i, const basic_beeler_glider_lanes<T> &l, const double coef) {
+        acc[0][i] += coef * l.xdot[i];
+        acc[1][i] += coef * l.ydot[i];
+        acc[2][i] += coef * l.zdot[i];
+        acc[3][i] += coef * l.Vdot[i];
+        acc[4][i] += coef * l.gammadot[i];
+        acc[5][i] += coef * l.khidot[i];
+    }
+};
+
+/** @brief Lanes and batch in double precision */
+typedef basic_beeler_glider_lanes<double> beeler_glider_lanes;
+typedef basic_beeler_glider_batch<double> beeler_glider_batch;
+
+}
+
+#endif // L2FSIM_BEELER_GLIDER_BATCH_HPP_
@@ -2,27 +2,42 @@
 #define L2FSIM_BEELER_GLIDER_COMMAND_HPP_
 
 #include <command.hpp>
+#include <utils.hpp>
 
 namespace L2Fsim {
 
 /**
  * @brief Beeler's glider command
- * @version 1.0
+ * @version 1.1
  * @since 1.0
+ * @note the template parameter T is the scalar type of the variations, a dual number of 'dual.hpp'
+ * seeds the derivatives with respect to the command (see 'beeler_glider_jacobian.hpp')
  */
-class beeler_glider_command : public command {
+template <class T>
+class basic_beeler_glider_command : public command {
 public:
-    double dalpha; ///< Variation of angle of attack
-    double dbeta; ///< Variation of sideslip angle
-    double dsigma; ///< Variation of bank angle
+    T dalpha; ///< Variation of angle of attack
+    T dbeta; ///< Variation of sideslip angle
+    T dsigma; ///< Variation of bank angle
 
     /** @brief Constructor */
-    beeler_glider_command(double _dalpha=0., double _dbeta=0., double _dsigma=0.) :
+    basic_beeler_glider_command(T _dalpha=0., T _dbeta=0., T _dsigma=0.) :
         dalpha(_dalpha),
         dbeta(_dbeta),
         dsigma(_dsigma)
     {}
 
+    /**
+     * @brief Conversion from a command of another scalar type
+     * @param {const basic_beeler_glider_command<U> &} u; converted command
+     */
+    template <class U>
+    explicit basic_beeler_glider_command(const basic_beeler_glider_command<U> &u) :
+        dalpha(value_of(u.dalpha)),
+        dbeta(value_of(u.dbeta)),
+        dsigma(value_of(u.dsigma))
+    {}
+
     /**
      * @brief Set command
      *
@@ -30,7 +45,7 @@ public:
      * @param {command &} _u; copied command
      */
     void set_command(command &_u) override {
-        beeler_glider_command &u = dynamic_cast <beeler_glider_command &> (_u);
+        basic_beeler_glider_command &u = dynamic_cast <basic_beeler_glider_command &> (_u);
         dalpha = u.dalpha;
         dbeta = u.dbeta;
         dsigma = u.dsigma;
@@ -49,10 +64,10 @@ public:
      * @brief Equality comparison
      *
      * Compare this command with the given command.
-     * @param {const beeler_glider_command &} a; the compared command
+     * @param {const basic_beeler_glider_command &} a; the compared command
      * @return Return true if this action is equal to the argument
      */
-    bool equals(const beeler_glider_command &a) {
+    bool equals(const basic_beeler_glider_command &a) {
         if(are_equal(dalpha,a.dalpha)
         && are_equal(dbeta,a.dbeta)
         && are_equal(dsigma,a.dsigma)) {
@@ -63,6 +78,9 @@ public:
     }
 };
 
+/** @brief Beeler's glider command in double precision */
+typedef basic_beeler_glider_command<double> beeler_glider_command;
+
 }
 
 #endif
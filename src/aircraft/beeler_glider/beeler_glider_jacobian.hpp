@@ -0,0 +1,166 @@
+#ifndef L2FSIM_BEELER_GLIDER_JACOBIAN_HPP_
+#define L2FSIM_BEELER_GLIDER_JACOBIAN_HPP_
+
+#include <beeler_glider/beeler_glider.hpp>
+#include <euler_integrator.hpp>
+#include <rk4_integrator.hpp>
+#include <dual.hpp>
+#include <vector>
+
+/**
+ * @file beeler_glider_jacobian.hpp
+ * @version 1.0
+ * @since 1.1
+ *
+ * Jacobians of Beeler's glider by forward-mode automatic differentiation
+ * The glider model is evaluated with dual numbers (see 'dual.hpp') seeded on the 9 state variables
+ * (x, y, z, V, gamma, khi, alpha, beta, sigma) and on the 3 command variables (dalpha, dbeta,
+ * dsigma). A single evaluation of the dynamics, or a single transition with the integrators of
+ * 'euler_integrator.hpp' and 'rk4_integrator.hpp', yields the result and its exact Jacobians
+ * instead of the 2 x 12 evaluations of central finite differences. The wind derivatives are given by
+ * the flight zone (see 'flight_zone::wind_derivatives').
+ * @note the Jacobians are row-major: 'A[i*nx+j]' is the derivative of the i-th state variable with respect to the j-th one
+ */
+
+namespace L2Fsim {
+
+class beeler_glider_jacobian {
+public:
+    typedef dual<12> scalar;
+    static constexpr unsigned int nx = 9; ///< Number of state variables
+    static constexpr unsigned int nu = 3; ///< Number of command variables
+
+    /**
+     * Attributes
+     * @param {basic_beeler_glider<scalar>} model; glider model evaluated with dual numbers
+     * @param {unsigned int} integrator_selector; 0: Euler; 1: RK4
+     * @param {rk4_stages} stages; stage storage of the RK4 integrator
+     */
+    basic_beeler_glider<scalar> model;
+    unsigned int integrator_selector;
+    rk4_stages stages;
+
+    /**
+     * Constructor
+     * @param {const beeler_glider &} ac; differentiated glider, its mass, wing span and aspect ratio are copied
+     * @param {unsigned int} _integrator_selector; 0: Euler; 1: RK4
+     */
+    beeler_glider_jacobian(const beeler_glider &ac, unsigned int _integrator_selector=1) :
+        model(
+            basic_beeler_glider_state<scalar>(),
+            basic_beeler_glider_command<scalar>(),
+            ac.mass,
+            ac.wingspan,
+            ac.aspect_ratio),
+        integrator_selector(_integrator_selector)
+    {}
+
+    /**
+     * @brief Jacobian of the dynamics
+     *
+     * Compute the time derivatives of (x, y, z, V, gamma, khi) and their Jacobian with respect to
+     * the state variables.
+     * @param {flight_zone &} fz; flight zone
+     * @param {const double} t; current time
+     * @param {const beeler_glider_state &} s; state
+     * @param {std::vector<double> &} f; time derivatives (size 6)
+     * @param {std::vector<double> &} F; Jacobian of the time derivatives (size 6 x nx)
+     */
+    beeler_glider_jacobian & dynamics(
+        flight_zone &fz,
+        const double t,
+        const beeler_glider_state &s,
+        std::vector<double> &f,
+        std::vector<double> &F)
+    {
+        seed(s,beeler_glider_command());
+        basic_beeler_glider_state<scalar> &ms = model.s;
+        model.update_state_dynamic(fz,t,ms);
+        const scalar *rates[6] = {&ms.xdot, &ms.ydot, &ms.zdot, &ms.Vdot, &ms.gammadot, &ms.khidot};
+        f.resize(6);
+        F.resize(6*nx);
+        for(unsigned int i=0; i<6; ++i) {
+            f[i] = rates[i]->v;
+            for(unsigned int j=0; j<nx; ++j) {F[i*nx+j] = rates[i]->d[j];}
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Transition with its Jacobians
+     *
+     * Perform the transition of the glider from state s under command u and compute the Jacobians
+     * of the next state with respect to s (A) and to u (B).
+     * @param {flight_zone &} fz; flight zone
+     * @param {double} t; current time
+     * @param {const double} time_step_width; time-step-width
+     * @param {const double} sdt; sub-time-step-width
+     * @param {const beeler_glider_state &} s; state
+     * @param {const beeler_glider_command &} u; command
+     * @param {beeler_glider_state &} s_next; next state
+     * @param {std::vector<double> &} A; Jacobian with respect to the state (size nx x nx)
+     * @param {std::vector<double> &} B; Jacobian with respect to the command (size nx x nu)
+     */
+    beeler_glider_jacobian & transition(
+        flight_zone &fz,
+        double t,
+        const double time_step_width,
+        const double sdt,
+        const beeler_glider_state &s,
+        const beeler_glider_command &u,
+        beeler_glider_state &s_next,
+        std::vector<double> &A,
+        std::vector<double> &B)
+    {
+        seed(s,u);
+        switch(integrator_selector) {
+            case 0: {
+                euler_integrator::transition_function(model,fz,t,time_step_width,sdt);
+                break;
+            }
+            default: {
+                rk4_integrator::transition_function(model,fz,t,time_step_width,sdt,stages);
+            }
+        }
+        s_next = beeler_glider_state(model.s);
+        scalar *v[nx];
+        variables(model.s,v);
+        A.resize(nx*nx);
+        B.resize(nx*nu);
+        for(unsigned int i=0; i<nx; ++i) {
+            for(unsigned int j=0; j<nx; ++j) {A[i*nx+j] = v[i]->d[j];}
+            for(unsigned int j=0; j<nu; ++j) {B[i*nu+j] = v[i]->d[nx+j];}
+        }
+        return *this;
+    }
+
+protected:
+    /** @brief Pointers on the differentiated state variables, in the order of the Jacobians */
+    static void variables(basic_beeler_glider_state<scalar> &s, scalar *v[nx]) {
+        v[0] = &s.x;
+        v[1] = &s.y;
+        v[2] = &s.z;
+        v[3] = &s.V;
+        v[4] = &s.gamma;
+        v[5] = &s.khi;
+        v[6] = &s.alpha;
+        v[7] = &s.beta;
+        v[8] = &s.sigma;
+    }
+
+    /** @brief Set the state and the command of the model and seed their derivatives */
+    void seed(const beeler_glider_state &s, const beeler_glider_command &u) {
+        model.s = basic_beeler_glider_state<scalar>(s);
+        scalar *v[nx];
+        variables(model.s,v);
+        for(unsigned int i=0; i<nx; ++i) {v[i]->d[i] = 1.;}
+        model.u = basic_beeler_glider_command<scalar>(
+            scalar(u.dalpha,nx),
+            scalar(u.dbeta,nx+1),
+            scalar(u.dsigma,nx+2));
+    }
+};
+
+}
+
+#endif
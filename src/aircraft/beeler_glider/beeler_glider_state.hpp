@@ -2,51 +2,56 @@
 #define L2FSIM_BEELER_GLIDER_STATE_HPP_
 
 #include <ctgmath>
+#include <algorithm>
+#include <utils.hpp>
 
 /**
  * @file beeler_glider_state.hpp
  * @brief Beeler's glider state from a Control point of view
- * @version 1.0
+ * @version 1.1
  * @since 1.0
+ * @note the template parameter T is the scalar type of the variables ('double', 'float' or a dual
+ * number of 'dual.hpp'), the interface inherited from 'state' stays in double precision
  */
 
 namespace L2Fsim {
 
-class beeler_glider_state : public state {
+template <class T>
+class basic_beeler_glider_state : public state {
 public:
     /**
      * @brief Attributes
-     * @param {double} x, y, z; the absolute position in the earth frame
-     * @param {double} gamma; elevation angle
-     * @param {double} khi; azimuth angle
-     * @param {double} alpha; angle of attack
-     * @param {double} beta; sideslip angle
-     * @param {double} sigma; bank angle
-     * @param {double} max_angle_magnitude; maximum angle magnitude
-     * @param {double} xdot, ydot, zdot, Vdot, gammadot, khidot; rates
+     * @param {T} x, y, z; the absolute position in the earth frame
+     * @param {T} gamma; elevation angle
+     * @param {T} khi; azimuth angle
+     * @param {T} alpha; angle of attack
+     * @param {T} beta; sideslip angle
+     * @param {T} sigma; bank angle
+     * @param {T} max_angle_magnitude; maximum angle magnitude
+     * @param {T} xdot, ydot, zdot, Vdot, gammadot, khidot; rates
      * @param {double} time; current time
      */
-    double x, y, z, V, gamma, khi;
-    double alpha, beta, sigma;
-    double max_angle_magnitude;
-    double xdot, ydot, zdot, Vdot, gammadot, khidot;
+    T x, y, z, V, gamma, khi;
+    T alpha, beta, sigma;
+    T max_angle_magnitude;
+    T xdot, ydot, zdot, Vdot, gammadot, khidot;
     double time;
 
     /** @brief Constructor */
-    beeler_glider_state(
-        double _x=0.,
-        double _y=0.,
-        double _z=0.,
-        double _V=0.,
-        double _gamma=0.,
-        double _khi=0.,
-        double _alpha=0.,
-        double _beta=0.,
-        double _sigma=0.,
-        double _max_angle_magnitude=.5,
-        double _Vdot=0.,
-        double _gammadot=0.,
-        double _khidot=0.,
+    basic_beeler_glider_state(
+        T _x=0,
+        T _y=0,
+        T _z=0,
+        T _V=0,
+        T _gamma=0,
+        T _khi=0,
+        T _alpha=0,
+        T _beta=0,
+        T _sigma=0,
+        T _max_angle_magnitude=.5,
+        T _Vdot=0,
+        T _gammadot=0,
+        T _khidot=0,
         double _time=0.) :
         x(_x),
         y(_y),
@@ -68,17 +73,30 @@ public:
         zdot = V * sin(gamma);
     }
 
+    /**
+     * @brief Conversion from a state of another scalar type
+     * @param {const basic_beeler_glider_state<U> &} s; converted state
+     */
+    template <class U>
+    explicit basic_beeler_glider_state(const basic_beeler_glider_state<U> &s) :
+        x(value_of(s.x)), y(value_of(s.y)), z(value_of(s.z)), V(value_of(s.V)), gamma(value_of(s.gamma)), khi(value_of(s.khi)),
+        alpha(value_of(s.alpha)), beta(value_of(s.beta)), sigma(value_of(s.sigma)),
+        max_angle_magnitude(value_of(s.max_angle_magnitude)),
+        xdot(value_of(s.xdot)), ydot(value_of(s.ydot)), zdot(value_of(s.zdot)), Vdot(value_of(s.Vdot)), gammadot(value_of(s.gammadot)), khidot(value_of(s.khidot)),
+        time(s.time)
+    {}
+
     /** @brief Set time variable */
     void set_time(double t) override {time = t;}
 
     /** @brief Get x coordinate in the earth frame */
-    double getx() {return x;}
+    double getx() {return value_of(x);}
 
     /** @brief Get y coordinate in the earth frame */
-    double gety() {return y;}
+    double gety() {return value_of(y);}
 
     /** @brief Get z coordinate in the earth frame */
-    double getz() {return z;}
+    double getz() {return value_of(z);}
 
     /** @brief Get time coordinate */
     double gett() {return time;}
@@ -89,14 +107,23 @@ public:
      * @return a pointer to the copy
      */
     state * duplicate() const override {
-        return new beeler_glider_state(*this);
+        return new basic_beeler_glider_state(*this);
+    }
+
+    /**
+     * @brief Copy every variables of the input state
+     * @param {const state &} s; copied state
+     * @warning dynamic cast from state to basic_beeler_glider_state
+     */
+    void copy(const state &_s) override {
+        *this = dynamic_cast <const basic_beeler_glider_state &> (_s);
     }
 
     bool is_out_of_bounds() override {
         if (fabs(alpha) > max_angle_magnitude ||
             fabs(beta) > max_angle_magnitude ||
             fabs(sigma) > max_angle_magnitude ||
-            z <= 0.)
+            z <= 0)
         {return true;}
         return false;
     }
@@ -117,21 +144,21 @@ public:
 
     /** @brief Set every dynamic variables to 0 */
     void clear_dynamic() override {
-        xdot = 0.;
-        ydot = 0.;
-        zdot = 0.;
-        Vdot = 0.;
-        gammadot = 0.;
-        khidot = 0.;
+        xdot = 0;
+        ydot = 0;
+        zdot = 0;
+        Vdot = 0;
+        gammadot = 0;
+        khidot = 0;
     }
 
     /**
      * @brief Set the dynamic components i.e. the time derivatives interacting with the simulation integrator
      * @param {state &} s; state from which the dynamic components are copied
-     * @warning dynamic cast from state to beeler_glider_state
+     * @warning dynamic cast from state to basic_beeler_glider_state
      */
     void set_dynamic(state &_s) override {
-        beeler_glider_state &s = dynamic_cast <beeler_glider_state &> (_s);
+        basic_beeler_glider_state &s = dynamic_cast <basic_beeler_glider_state &> (_s);
         xdot = s.xdot;
         ydot = s.ydot;
         zdot = s.zdot;
@@ -144,10 +171,10 @@ public:
      * @brief Add the dynamic of a state to the current state
      * @param {state &} s; state from which the dynamic components are added
      * @param {const double} coef; a multiplicative coefficient
-     * @warning dynamic cast from state to beeler_glider_state
+     * @warning dynamic cast from state to basic_beeler_glider_state
      */
     void add_to_dynamic(state &_s, const double coef) override {
-        beeler_glider_state &s = dynamic_cast <beeler_glider_state &> (_s);
+        basic_beeler_glider_state &s = dynamic_cast <basic_beeler_glider_state &> (_s);
         xdot += coef * s.xdot;
         ydot += coef * s.ydot;
         zdot += coef * s.zdot;
@@ -166,9 +193,32 @@ public:
         z += dt * zdot;
         V += dt * Vdot;
         gamma += dt * gammadot;
-        gamma = acos(cos(gamma))*sign(sin(gamma));
+        gamma = wrap_angle(gamma);
         khi += dt * khidot;
-        khi = acos(cos(khi))*sign(sin(khi));
+        khi = wrap_angle(khi);
+    }
+
+    /**
+     * @brief Scaled RMS norm of the local error held in the dynamic attributes
+     * @param {state &} y0, y1; states at the beginning and at the end of the step
+     * @param {const double} dt; step width
+     * @param {const double} atol, rtol; absolute and relative tolerances
+     * @return {double} the error norm, the step is acceptable if lower than 1
+     * @warning dynamic cast from state to basic_beeler_glider_state
+     */
+    double error_norm(state &_y0, state &_y1, const double dt, const double atol, const double rtol) override {
+        basic_beeler_glider_state &y0 = dynamic_cast <basic_beeler_glider_state &> (_y0);
+        basic_beeler_glider_state &y1 = dynamic_cast <basic_beeler_glider_state &> (_y1);
+        double e[6] = {value_of(xdot), value_of(ydot), value_of(zdot), value_of(Vdot), value_of(gammadot), value_of(khidot)};
+        double a[6] = {value_of(y0.x), value_of(y0.y), value_of(y0.z), value_of(y0.V), value_of(y0.gamma), value_of(y0.khi)};
+        double b[6] = {value_of(y1.x), value_of(y1.y), value_of(y1.z), value_of(y1.V), value_of(y1.gamma), value_of(y1.khi)};
+        double sum = 0.;
+        for(unsigned int i=0; i<6; ++i) {
+            double sc = atol + rtol * std::max(fabs(a[i]), fabs(b[i]));
+            double r = dt * e[i] / sc;
+            sum += r * r;
+        }
+        return sqrt(sum / 6.);
     }
 
     /**
@@ -177,21 +227,24 @@ public:
      */
     std::vector<double> get_save() override {
         return std::vector<double> {
-            x,
-            y,
-            z,
-            V,
-            gamma,
-            khi,
-            alpha,
-            beta,
-            sigma,
-            zdot + V*Vdot/9.81, // Edot
+            value_of(x),
+            value_of(y),
+            value_of(z),
+            value_of(V),
+            value_of(gamma),
+            value_of(khi),
+            value_of(alpha),
+            value_of(beta),
+            value_of(sigma),
+            value_of(zdot + V*Vdot/9.81), // Edot
             time
         };
     }
 };
 
+/** @brief Beeler's glider state in double precision */
+typedef basic_beeler_glider_state<double> beeler_glider_state;
+
 }
 
 #endif
@@ -0,0 +1,168 @@
+#ifndef L2FSIM_POINT_MASS_GLIDER_HPP_
+#define L2FSIM_POINT_MASS_GLIDER_HPP_
+
+#include <beeler_glider/beeler_glider.hpp>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+/**
+ * @file point_mass_glider.hpp
+ * @version 1.0
+ * @since 1.1
+ *
+ * Reduced-order point-mass glider
+ * The glider has the parameters, state, command and validity domain of Beeler's glider (see
+ * 'beeler_glider.hpp') but its dynamics are reduced to:
+ * - a first-order response of the airspeed V to the trim airspeed of the lift equation, given the angle of attack and the bank angle;
+ * - a sink rate read in a polar tabulated at construction from the drag polar of Beeler's glider
+ *   (steady turning glide, bilinear interpolation in airspeed and bank angle);
+ * - an energy-conserving exchange between airspeed and altitude;
+ * - a coordinated turn for the azimuth angle;
+ * - a cheap wind coupling: the wind drifts the glider and the updraft adds to its vertical speed.
+ * The elevation angle follows the air-relative flight path angle with the same time constant
+ * as the airspeed. No frame rotation is computed, which makes it suitable for planning rollouts.
+ * @note V is the airspeed in this model
+ * @note the sideslip angle is not modelled
+ */
+
+namespace L2Fsim {
+
+class point_mass_glider : public beeler_glider {
+public:
+    /**
+     * Attributes
+     * @param {double} tau; time constant of the airspeed and elevation angle responses (s)
+     * @param {double} V_min, V_max; airspeed range of the polar (m/s)
+     * @param {double} sigma_max; bank angle magnitude range of the polar (rad)
+     * @param {unsigned int} nb_V, nb_sigma; number of points of the polar along each axis
+     * @param {std::vector<double>} polar; tabulated sink rates, 'polar[j*nb_V+i]' for the i-th airspeed and the j-th bank angle magnitude (m/s)
+     */
+    double tau;
+    double V_min;
+    double V_max;
+    double sigma_max;
+    unsigned int nb_V;
+    unsigned int nb_sigma;
+    std::vector<double> polar;
+
+    /**
+     * Constructor
+     * @param {state} _s: initial state
+     * @param {command} _u: initial command
+     * @param {double} m; mass
+     * @param {double} ws; wing span
+     * @param {double} ar; aspect ratio
+     * @param {double} _tau; time constant of the airspeed and elevation angle responses
+     */
+    point_mass_glider(
+        beeler_glider_state _s,
+        beeler_glider_command _u,
+        double m=1.36,
+        double ws=1.524,
+        double ar=16.,
+        double _tau=1.) :
+        beeler_glider(_s,_u,m,ws,ar),
+        tau(_tau),
+        V_min(4.),
+        V_max(40.),
+        sigma_max(1.2),
+        nb_V(73),
+        nb_sigma(25)
+    {
+        tabulate_polar();
+    }
+
+    /**
+     * @brief Sink rate of a steady turning glide
+     *
+     * Solve the glide equations L = m*g*cos(gamma)/cos(sigma) and D = m*g*sin(gamma) for the
+     * elevation angle by fixed-point iterations, with the drag polar of Beeler's glider.
+     * @param {double} V; airspeed
+     * @param {double} sigma; bank angle
+     * @return {double} the sink rate, positive downward
+     */
+    double glide_sink_rate(double V, double sigma) const {
+        double q_S = .5 * 1.225 * V * V * S;
+        double cos_sigma = cos(sigma);
+        double sin_gamma = 0.;
+        for(unsigned int k=0; k<20; ++k) {
+            double C_L = mass * 9.81 * sqrt(1. - sin_gamma*sin_gamma) / (q_S * cos_sigma);
+            double C_D = C_D_0 + C_d_L * (C_L - C_L_min) * (C_L - C_L_min) + C_L * C_L / (M_PI*e*aspect_ratio);
+            sin_gamma = std::min(1., q_S * C_D / (mass * 9.81));
+        }
+        return V * sin_gamma;
+    }
+
+    /**
+     * @brief Sink rate read in the polar
+     * @param {double} V; airspeed, clamped to the range of the polar
+     * @param {double} sigma; bank angle, clamped to the range of the polar
+     * @return {double} the sink rate, positive downward
+     */
+    double sink_rate(double V, double sigma) const {
+        double u = (std::min(std::max(V,V_min),V_max) - V_min) / (V_max - V_min) * (nb_V - 1);
+        double v = std::min(fabs(sigma),sigma_max) / sigma_max * (nb_sigma - 1);
+        unsigned int i = std::min((unsigned int)u, nb_V - 2);
+        unsigned int j = std::min((unsigned int)v, nb_sigma - 2);
+        double fu = u - i;
+        double fv = v - j;
+        const double *p = &polar[j*nb_V + i];
+        return (1.-fv) * ((1.-fu) * p[0] + fu * p[1]) + fv * ((1.-fu) * p[nb_V] + fu * p[nb_V+1]);
+    }
+
+    /**
+     * @brief Trim airspeed
+     *
+     * Airspeed at which the lift balances the weight in a level turn.
+     * @param {double} alpha; angle of attack
+     * @param {double} sigma; bank angle
+     */
+    double trim_airspeed(double alpha, double sigma) const {
+        double C_L = std::max(.05, C_L_alpha * (alpha - alpha0)); // keep a positive lift
+        return sqrt(2. * mass * 9.81 / (1.225 * S * C_L * cos(sigma)));
+    }
+
+    /**
+     * @brief Compute the time derivative of the input state
+     * @param {const flight_zone &} fz; flight zone
+     * @param {const double} t; current time
+     * @param {state &} _s; updated state
+     * @warning dynamic cast from state to beeler_glider_state
+     */
+    aircraft & update_state_dynamic(flight_zone &fz, const double t, state &_s) override {
+        beeler_glider_state &s = dynamic_cast <beeler_glider_state &> (_s);
+        fz.wind(s.x, s.y, s.z, t, w);
+        double V = s.V;
+        double cos_gamma = cos(s.gamma);
+        double Vdot = (trim_airspeed(s.alpha,s.sigma) - V) / tau;
+        double climb_rate = - sink_rate(V,s.sigma) - V * Vdot / 9.81; // air-relative, the total energy decreases at the sink rate
+        double gamma_air = asin(std::min(1.,std::max(-1.,climb_rate / V)));
+        s.xdot = V * cos_gamma * cos(s.khi) + w[0];
+        s.ydot = V * cos_gamma * sin(s.khi) + w[1];
+        s.zdot = climb_rate + w[2];
+        s.Vdot = Vdot;
+        s.gammadot = (gamma_air - s.gamma) / tau;
+        s.khidot = 9.81 * tan(s.sigma) / V;
+        return *this;
+    }
+
+protected:
+    std::vector<double> w = std::vector<double>(3); ///< Wind buffer
+
+    /** @brief Tabulate the polar over the airspeed and bank angle ranges */
+    void tabulate_polar() {
+        polar.resize(nb_V * nb_sigma);
+        for(unsigned int j=0; j<nb_sigma; ++j) {
+            double sigma = sigma_max * j / (nb_sigma - 1);
+            for(unsigned int i=0; i<nb_V; ++i) {
+                double V = V_min + (V_max - V_min) * i / (nb_V - 1);
+                polar[j*nb_V + i] = glide_sink_rate(V,sigma);
+            }
+        }
+    }
+};
+
+}
+
+#endif
@@ -38,6 +38,14 @@ public:
      */
     virtual state * duplicate() const = 0;
 
+    /**
+     * @brief Copy every variables (static and dynamic) of the input state into the current state
+     * @param {const state &} s; copied state
+     * @note allocation-free alternative to 'duplicate' for reused buffers
+     * @warning may implement a dynamic cast from state to a derived class
+     */
+    virtual void copy(const state &_s) = 0;
+
     /** @brief Set every dynamic variables to 0 */
     virtual void clear_dynamic() = 0;
 
@@ -62,6 +70,19 @@ public:
      */
     virtual void apply_dynamic(double dt) = 0;
 
+    /**
+     * @brief Scaled RMS norm of the local error held in the dynamic attributes
+     *
+     * The dynamic attributes of the current state are interpreted as an error rate, the
+     * error being 'dt' times this rate. Each component is scaled by 'atol + rtol * max(|y0|,|y1|)'.
+     * @param {state &} y0, y1; states at the beginning and at the end of the step
+     * @param {double} dt; step width
+     * @param {double} atol, rtol; absolute and relative tolerances
+     * @return {double} the error norm, the step is acceptable if lower than 1
+     * @warning may implement a dynamic cast from state to a derived class
+     */
+    virtual double error_norm(state &_y0, state &_y1, double dt, double atol, double rtol) = 0;
+
     /**
      * @brief Get a vector containing the saved variables
      * @return {std::vector<double>}
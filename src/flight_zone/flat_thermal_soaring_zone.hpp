@@ -2,7 +2,10 @@
 #define L2FSIM_FLAT_THERMAL_SOARING_ZONE_HPP_
 
 #include <thermal/std_thermal.hpp>
+#include <thermal/thermal_scenario.hpp>
 #include <chrono>
+#include <memory>
+#include <stdexcept>
 
 /**
  * @file flat_thermal_soaring_zone.hpp
@@ -14,6 +17,9 @@
  * The abstract class flat_thermal_soaring_zone is a subclass of flat_zone.
  * Default setting is noiseless.
  * No seed selection is done - you would have to implement this if you want to re-generate matching pseudo-random sequences
+ * A zone built from a 'thermal_scenario' reads the thermals of the scenario, which may be shared
+ * with other zones (see 'thermal_scenario.hpp'); a zone built empty owns the thermals it creates
+ * until 'share_scenario' moves them to a scenario.
  */
 
 namespace L2Fsim {
@@ -30,8 +36,9 @@ public:
     double ksi_min, ksi_max; ///< Minimum and maximum roll-off parameters
     double d_min; ///< Minimum radius of a thermal
     unsigned int nbth; ///< Maximum number of thermals in the scenario
-    std::vector<thermal *> thermals; ///< List of the thermals created in the simulation
+    std::vector<thermal *> thermals; ///< List of the thermals created in the simulation, owned by 'scenario' if any
     double noise_stddev = 0.; ///< Standard deviation of the normal law whose samples are added to each component of the wind velocity vector
+    std::shared_ptr<const thermal_scenario> scenario; ///< Shared scenario of the thermals, null if the zone owns them
 
     /**
      * @brief Constructor
@@ -85,82 +92,69 @@ public:
      * @brief Constructor
      *
      * Read a pre-saved thermal scenario (method save_scenario) in order to play an identical simulation.
-     * @warning Expect same order of variables as in save_scenario and save_fz_cfg method, do not modify one without the other.
+     * The files are parsed once per process, see 'thermal_scenario::load'.
      * @param {std::string} th_sc_p; thermal scenario input path
      * @param {std::string} fz_cfg_p; flight zone configuration input path
      */
     flat_thermal_soaring_zone(std::string th_sc_p, std::string fz_cfg_p, double _noise_stddev=0.) :
-        noise_stddev(_noise_stddev)
+        flat_thermal_soaring_zone(thermal_scenario::load(th_sc_p,fz_cfg_p),_noise_stddev)
+    {}
+
+    /**
+     * @brief Constructor
+     *
+     * Zone reading a shared scenario.
+     * @param {std::shared_ptr<const thermal_scenario>} sc; scenario
+     */
+    flat_thermal_soaring_zone(std::shared_ptr<const thermal_scenario> sc, double _noise_stddev=0.) :
+        windx(sc->windx),
+        windy(sc->windy),
+        x_min(sc->x_min),
+        x_max(sc->x_max),
+        y_min(sc->y_min),
+        y_max(sc->y_max),
+        z_min(sc->z_min),
+        z_max(sc->z_max),
+        d_min(sc->d_min),
+        noise_stddev(_noise_stddev),
+        scenario(sc)
     {
-        // 1. Read flight zone configuration
-        std::ifstream cf_file(fz_cfg_p);
-        if (!cf_file.is_open()) {
-            std::cerr << "Unable to open input file ("<< fz_cfg_p <<") in flat_thermal_soaring_zone constructor" << std::endl;
-        }
-        std::string line;
-        std::getline(cf_file,line); // do not take first line into account
-        std::getline(cf_file,line); // take 2nd line
-        if(line.size()>0) { // prevent from reading empty line
-            std::vector<std::string> result;
-            std::stringstream line_stream(line);
-            std::string cell;
-            while(std::getline(line_stream,cell,';')) {
-                result.push_back(cell);
-            }
-            if (!line_stream && cell.empty()) { // This checks for a trailing comma with no data after it
-                // If there was a trailing comma then add an empty element
-                result.push_back("");
-            }
-            x_min = stod(result.at(0));
-            x_max = stod(result.at(1));
-            y_min = stod(result.at(2));
-            y_max = stod(result.at(3));
-            z_min = stod(result.at(4));
-            z_max = stod(result.at(5));
-            d_min = stod(result.at(6));
-            windx = stod(result.at(7));
-            windy = stod(result.at(8));
-        } else {std::cout << "Unable to read 2nd line in fz configuration reader in flat_thermal_soaring_zone constructor"<<std::endl;}
-        cf_file.close();
-        // 2. Read thermal scenario
-        std::ifstream sc_file(th_sc_p);
-        if (!sc_file.is_open()) {
-            std::cerr << "Unable to open input file ("<< th_sc_p <<") in flat_thermal_soaring_zone constructor" << std::endl;
-        }
-        std::getline(sc_file,line); // do not take first line into account
-        while(sc_file.good()) {
-            std::vector<std::string> result;
-            std::getline(sc_file,line);
-            if(line.size()>0) { // prevent from reading last (empty) line
-                std::stringstream line_stream(line);
-                std::string cell;
-                while(std::getline(line_stream,cell,';')) {
-                    result.push_back(cell);
-                }
-                if (!line_stream && cell.empty()) { // This checks for a trailing comma with no data after it
-                    // If there was a trailing comma then add an empty element
-                    result.push_back("");
-                }
-                int model = std::stoi(result.at(0));
-                double t_birth = std::stod(result.at(1));
-                double lifespan = std::stod(result.at(2));
-                double w_star = std::stod(result.at(3));
-                double zi = std::stod(result.at(4));
-                double x = std::stod(result.at(5));
-                double y = std::stod(result.at(6));
-                double z = std::stod(result.at(7));
-                double ksi = std::stod(result.at(8));
-                std_thermal *new_th = new std_thermal(model,w_star,zi,t_birth,lifespan,x,y,z,ksi);
-                new_th->set_horizontal_wind(windx,windy);
-                thermals.push_back(new_th);
-            }
-        }
-        sc_file.close();
+        for(auto &th : sc->thermals) {thermals.push_back(th.get());}
     }
 
+    flat_thermal_soaring_zone(const flat_thermal_soaring_zone &) = delete;
+    flat_thermal_soaring_zone & operator=(const flat_thermal_soaring_zone &) = delete;
+
     /** @brief Destructor */
     ~flat_thermal_soaring_zone() {
-        for(auto th : thermals) {delete th;}
+        if(!scenario) {
+            for(auto th : thermals) {delete th;}
+        }
+    }
+
+    /**
+     * @brief Share scenario
+     *
+     * Get the scenario of the zone, to be read by other zones. The thermals created by the zone are
+     * moved to a new scenario, after which no thermal can be created.
+     * @return Return the scenario.
+     */
+    std::shared_ptr<const thermal_scenario> share_scenario() {
+        if(!scenario) {
+            std::shared_ptr<thermal_scenario> sc(new thermal_scenario);
+            sc->x_min = x_min;
+            sc->x_max = x_max;
+            sc->y_min = y_min;
+            sc->y_max = y_max;
+            sc->z_min = z_min;
+            sc->z_max = z_max;
+            sc->d_min = d_min;
+            sc->windx = windx;
+            sc->windy = windy;
+            for(auto th : thermals) {sc->thermals.emplace_back(th);}
+            scenario = sc;
+        }
+        return scenario;
     }
 
     /**
@@ -222,25 +216,27 @@ public:
     /**
      * @brief Sink rate
      *
-     * Compute the global environment sink rate.
-     * @param {double} z, t; altitude and time
+     * Compute the global environment sink rate. Template method on the scalar type of the altitude.
+     * @param {T} z; altitude
+     * @param {double} t; time
      * @return Return the global sink rate.
      */
-    double global_sink_rate(double z, double t) {
-        double thermals_area=0., mass_flow=0.;
+    template <class T>
+    T global_sink_rate(T z, double t) {
+        T thermals_area=0., mass_flow=0.;
         for(auto &th : thermals) {
             if (th->is_alive(t)) {
-                double z_zi = z / th->get_zi();
-                double s_wd_th = ((.5 < (z_zi)) && ((z_zi) < .9)) ? 2.5*(z_zi - .5) : 0.;
-                double avg_updraft_th = th->get_w_star() * pow(z_zi,1./3.) * (1. - 1.1*z_zi);
-                double radius_th = .102 * pow((z_zi),1./3.) * (1 - .25*z_zi) * (z/z_zi);
+                T z_zi = z / th->get_zi();
+                T s_wd_th = ((.5 < (z_zi)) && ((z_zi) < .9)) ? T(2.5*(z_zi - .5)) : T(0.);
+                T avg_updraft_th = th->get_w_star() * pow(z_zi,1./3.) * (1. - 1.1*z_zi);
+                T radius_th = .102 * pow((z_zi),1./3.) * (1 - .25*z_zi) * th->get_zi();
                 if(radius_th<10.){radius_th=10.;}
-                double rsq = radius_th*radius_th;
+                T rsq = radius_th*radius_th;
                 mass_flow += avg_updraft_th*M_PI*rsq*(1.-s_wd_th) * th->lifetime_coefficient(t);
                 thermals_area += M_PI*rsq;
             }
         }
-        double w_e = - mass_flow / ((x_max-x_min)*(y_max-y_min) - thermals_area);
+        T w_e = - mass_flow / ((x_max-x_min)*(y_max-y_min) - thermals_area);
         if(w_e>0.){w_e=0.;}
         return w_e;
     }
@@ -323,6 +319,7 @@ public:
      */
     flat_thermal_soaring_zone& wind(double x, double y, double z, double t, std::vector<double> &w) override {
         w.assign({windx,windy,0.});
+        z = std::max(z,0.); // integration stages may probe below the ground, where the models are undefined
         for(auto &th : thermals) {
             if(th->is_alive(t)) {
                 th->wind(x,y,z,t,w);
@@ -331,6 +328,48 @@ public:
         if(thermals.size()!=0 && thermals[0]->get_model()==1){
             w[2] += global_sink_rate(z,t);
         }
+        add_noise(w);
+        return *this;
+    }
+
+    /**
+     * @brief Wind and its spatial derivatives
+     *
+     * Compute the wind velocity vector w and its exact derivatives dw with respect to (x,y,z), see
+     * 'flight_zone::wind_derivatives'. The noise is added to the wind only.
+     * @param {double} x, y, z, t; coordinates
+     * @param {std::vector<double> &} w; wind velocity vector [wx, wy, wz]
+     * @param {std::vector<double> &} dw; 3x3 row-major Jacobian of the wind velocity vector
+     * @return Return '*this'
+     */
+    flat_thermal_soaring_zone& wind_derivatives(double x, double y, double z, double t, std::vector<double> &w, std::vector<double> &dw) override {
+        w.assign({windx,windy,0.});
+        dw.assign(9,0.);
+        bool below_ground = z < 0.;
+        z = std::max(z,0.);
+        for(auto &th : thermals) {
+            if(th->is_alive(t)) {
+                th->wind_derivatives(x,y,z,t,w,dw);
+            }
+        }
+        if(thermals.size()!=0 && thermals[0]->get_model()==1){
+            dual<1> sink = global_sink_rate(dual<1>(z,0),t);
+            w[2] += sink.v;
+            dw[8] += sink.d[0];
+        }
+        if(below_ground) {dw[2] = dw[5] = dw[8] = 0.;} // the clamped altitude
+        add_noise(w);
+        return *this;
+    }
+
+    /**
+     * @brief Add noise
+     *
+     * Add a sample of the normal law of standard deviation 'noise_stddev' to the vertical
+     * component of the wind velocity vector.
+     * @param {std::vector<double> &} w; wind velocity vector [wx, wy, wz]
+     */
+    void add_noise(std::vector<double> &w) {
         if (!are_equal(noise_stddev,0.)) {
             unsigned seed = std::chrono::system_clock::now().time_since_epoch().count();
             std::default_random_engine generator (seed);
@@ -339,7 +378,6 @@ public:
             //w[1] += distribution(generator);
             w[2] += distribution(generator);
         }
-        return *this;
     }
 
     /**
@@ -355,6 +393,18 @@ public:
         return false;
     }
 
+    /**
+     * @brief Boundary distance
+     *
+     * Signed distance to the closest vertical boundary of the zone.
+     * @param {double} x, y, z; coordinates  in the earth frame
+     * @return Return the distance, positive inside the zone.
+     */
+    double boundary_distance(double x, double y, double z) override {
+        (void) z; //unused by default
+        return std::min(std::min(x-x_min,x_max-x),std::min(y-y_min,y_max-y));
+    }
+
     /**
      * @brief Create thermal
      *
@@ -363,6 +413,7 @@ public:
      * @param {double} t; current time, thermal's date of birth
      */
     void create_thermal(int model, double t) {
+        if(scenario) {throw std::logic_error("flat_thermal_soaring_zone: the thermals of a shared scenario cannot be modified");}
         std::vector<double> center;
         if(create_thermal_center(t,center)) {
             double w_star = pick_w_star();
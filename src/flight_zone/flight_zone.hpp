@@ -1,6 +1,7 @@
 #ifndef L2FSIM_FLIGHT_ZONE_HPP_
 #define L2FSIM_FLIGHT_ZONE_HPP_
 
+#include <dual.hpp>
 #include <vector>
 
 /**
@@ -10,6 +11,8 @@
  * A flight zone holds two important concepts:
  * - it has a characterization of the wind w in the flight zone at a given time;
  * - it has an altitude z of the ground surface at all points in the flight zone;
+ * The wind can be evaluated along with its spatial derivatives, which the dual numbers of 'dual.hpp'
+ * use through 'wind_at' to differentiate the aircraft models.
  */
 
 namespace L2Fsim {
@@ -27,6 +30,31 @@ public:
 	 */
 	virtual flight_zone& wind(double x, double y, double z, double t, std::vector<double> &w) = 0;
 
+    /**
+     * @brief Compute the wind velocity vector w and its spatial derivatives at coordinate (x,y,z,t)
+     *
+     * Default is the central finite differences of 'wind'; override it with the exact derivatives.
+     * @param {double} x, y, z, t; coordinates in earth frame
+     * @param {std::vector<double> &} w; wind velocity vector [wx, wy, wz]
+     * @param {std::vector<double> &} dw; 3x3 row-major Jacobian, 'dw[3*i+j]' is the derivative of the i-th component of w with respect to the j-th coordinate of (x,y,z)
+     */
+    virtual flight_zone& wind_derivatives(double x, double y, double z, double t, std::vector<double> &w, std::vector<double> &dw) {
+        const double h = 1e-3;
+        std::vector<double> wp(3), wm(3);
+        double p[3] = {x, y, z};
+        dw.resize(9);
+        for(unsigned int j=0; j<3; ++j) {
+            double pj = p[j];
+            p[j] = pj + h;
+            wind(p[0],p[1],p[2],t,wp);
+            p[j] = pj - h;
+            wind(p[0],p[1],p[2],t,wm);
+            p[j] = pj;
+            for(unsigned int i=0; i<3; ++i) {dw[3*i+j] = (wp[i] - wm[i]) / (2. * h);}
+        }
+        return wind(x,y,z,t,w);
+    }
+
     /**
 	 * @brief Compute the altitude at (x,y)
 	 * @param {double} x, y; coordinates in earth frame
@@ -43,8 +71,60 @@ public:
      * @return true if the input position belongs to the flight zone
      */
     virtual bool is_within_fz(double x, double y, double z) = 0;
+
+    /**
+     * @brief Signed distance to the boundaries of the flight zone
+     *
+     * Positive inside the zone and non-positive outside, used to locate boundary crossings.
+     * Default is the sign given by 'is_within_fz'; override it with a continuous function for
+     * faster event location.
+     * @param {double} x, y, z; coordinates in the earth frame
+     * @return {double} the signed distance
+     */
+    virtual double boundary_distance(double x, double y, double z) {
+        return is_within_fz(x,y,z) ? 1. : -1.;
+    }
 };
 
+/**
+ * @brief Wind at a position of any scalar type
+ *
+ * Evaluate the wind of a flight zone at a position of the scalar type of an aircraft model.
+ * @param {flight_zone &} fz; flight zone
+ * @param {const T} x, y, z; coordinates in earth frame
+ * @param {const double} t; time
+ * @param {std::vector<T> &} w; wind velocity vector [wx, wy, wz]
+ */
+template <class T>
+inline void wind_at(flight_zone &fz, const T x, const T y, const T z, const double t, std::vector<T> &w) {
+    std::vector<double> wd(3);
+    fz.wind(x,y,z,t,wd);
+    for(unsigned int i=0; i<3; ++i) {w[i] = wd[i];}
+}
+
+/** @brief Wind at a position in double precision */
+inline void wind_at(flight_zone &fz, const double x, const double y, const double z, const double t, std::vector<double> &w) {
+    fz.wind(x,y,z,t,w);
+}
+
+/**
+ * @brief Wind at a position given as dual numbers
+ *
+ * The derivatives of the wind follow from the spatial derivatives of 'wind_derivatives' and the
+ * derivatives of the position (chain rule).
+ */
+template <unsigned int N>
+inline void wind_at(flight_zone &fz, const dual<N> &x, const dual<N> &y, const dual<N> &z, const double t, std::vector<dual<N>> &w) {
+    std::vector<double> wd(3), dw(9);
+    fz.wind_derivatives(x.v,y.v,z.v,t,wd,dw);
+    for(unsigned int i=0; i<3; ++i) {
+        w[i] = dual<N>(wd[i]);
+        for(unsigned int k=0; k<N; ++k) {
+            w[i].d[k] = dw[3*i] * x.d[k] + dw[3*i+1] * y.d[k] + dw[3*i+2] * z.d[k];
+        }
+    }
+}
+
 }
 
 #endif
@@ -3,6 +3,7 @@
 
 #include <thermal/thermal.hpp>
 #include <utils.hpp>
+#include <dual.hpp>
 #include <iostream>
 #include <vector>
 #include <cmath>
@@ -13,6 +14,8 @@
  * @version 1.1
  * @since 1.0
  * @brief The abstract class std_thermal is a subclass of thermal. It is a specialization of thermal.
+ * @note the updraft models are templated on the scalar type of the position ('double', 'float' or a
+ * dual number of 'dual.hpp', which yields the spatial derivatives of the wind)
  */
 
 namespace L2Fsim {
@@ -98,8 +101,14 @@ public:
      * @note Effect of ambient winds and thermal drifting is considered
      */
     double dist_to_updraft_center(const double x, const double y, const double z) override {
-        double xcz = xc0 + windx*z; // drifted center at alttitude z
-        double ycz = yc0 + windy*z; // drifted center at alttitude z
+        return dist_to_center(x,y,z);
+    }
+
+    /** @brief Distance to updraft center, templated on the scalar type of the position */
+    template <class T>
+    T dist_to_center(const T x, const T y, const T z) {
+        T xcz = xc0 + windx*z; // drifted center at alttitude z
+        T ycz = yc0 + windy*z; // drifted center at alttitude z
         return sqrt((xcz-x)*(xcz-x) + (ycz-y)*(ycz-y));
     }
 
@@ -130,23 +139,25 @@ public:
 
     /**
      * @brief Allen's thermal model
-     * @param {const double} r, z, t; radius, altitude and time
+     * @param {const T} r, z; radius and altitude
+     * @param {const double} t; time
      * @note The time normally does not have an influence in the Allen model; However, here we compute the lifetime coefficient inside the 'allen_model' method in order to optimize the code
 	 */
-    double allen_model(const double r, const double z, const double t)
+    template <class T>
+    T allen_model(const T r, const T z, const double t)
     {
-        double z_zi = z/zi;
-        double r2 = std::max(10.,.102*pow(z_zi,1./3.)*(1.-.25*z_zi)*zi);
+        T z_zi = z/zi;
+        T r2 = std::max<T>(10.,.102*pow(z_zi,1./3.)*(1.-.25*z_zi)*zi);
         if(r > 2.*r2) {
-            return 0.;
+            return T(0.);
         } else {
             //double r1_r2 = .36;
-            double r1 = .36*r2;
-            double r_r2 = r/r2;
-            double w_ = w_star * pow(z_zi,1./3.) * (1. - 1.1*z_zi);
-            double w_peak = 3. * w_ * (r2-r1)*r2*r2 / (r2*r2*r2 - r1*r1*r1);
-            double w_l = ((r1 < r) && (r < (2.*r2))) ? -M_PI/6.*sin(M_PI*r_r2) : 0.;
-            double s_wd = ((.5 < z_zi) && (z_zi < .9)) ? 2.5*(z_zi-.5) : 0.;
+            T r1 = .36*r2;
+            T r_r2 = r/r2;
+            T w_ = w_star * pow(z_zi,1./3.) * (1. - 1.1*z_zi);
+            T w_peak = 3. * w_ * (r2-r1)*r2*r2 / (r2*r2*r2 - r1*r1*r1);
+            T w_l = ((r1 < r) && (r < (2.*r2))) ? T(-M_PI/6.*sin(M_PI*r_r2)) : T(0.);
+            T s_wd = ((.5 < z_zi) && (z_zi < .9)) ? T(2.5*(z_zi-.5)) : T(0.);
             //double w_d = s_wd*w_l;
             //double k1 = 1.4866; // ki values valid for r1/r2 = 0.36
             //double k2 = 4.8354;
@@ -158,30 +169,31 @@ public:
 
     /**
      * @brief Childress's thermal model
-     * @param {const double} r, z; radius and altitude
+     * @param {const T} r, z; radius and altitude
      * @ref An Empirical Model of thermal Updrafts Using Data Obtained From a Manned Glider, Christopher E. Childress
 	 */
-    double childress_model(const double r, const double z)
+    template <class T>
+    T childress_model(const T r, const T z)
     {
-        double w_total = 0.;
+        T w_total = 0.;
         if(z>zi) {w_total=0.;} // flight level higher than CBL
         else {
-            double z_zi = z/zi;
+            T z_zi = z/zi;
 
             //Calculation of radius of the thermal
-            double d_T = zi*(.4 * pow(z_zi,1./3.) * (1 - .5*z_zi)) + (z*z_zi*z_zi - .6*z*z_zi)/M_PI;
-            double r2 = .5*d_T;
+            T d_T = zi*(.4 * pow(z_zi,1./3.) * (1 - .5*z_zi)) + (z*z_zi*z_zi - .6*z*z_zi)/M_PI;
+            T r2 = .5*d_T;
 
             //Core downdraft radius
-            double r1 = .5*(.17*d_T + .5*(z_zi - .6)*d_T);
+            T r1 = .5*(.17*d_T + .5*(z_zi - .6)*d_T);
 
             // Calculating w_ and w_peak based on Allen model
-            double w_ = w_star * pow((z / zi),1./3.) * (1 - 1.1*z_zi);
-            double w_peak = 3.*w_*(r2-r1)*r2*r2 / (r2*r2*r2-r1*r1*r1);
+            T w_ = w_star * pow((z / zi),1./3.) * (1 - 1.1*z_zi);
+            T w_peak = 3.*w_*(r2-r1)*r2*r2 / (r2*r2*r2-r1*r1*r1);
 
             // Calculation of downdraft terms
-            double w_dec = (-zi/(1.275*w_star*w_star))*(12.192/z);
-            double wd = w_dec*(z_zi + .45) - .5*w_peak;
+            T w_dec = (-zi/(1.275*w_star*w_star))*(12.192/z);
+            T wd = w_dec*(z_zi + .45) - .5*w_peak;
 
             //Calculation of Updraft based on equations 14,15,16 from Childress
             if(z_zi<.5 && r<=r2) {
@@ -211,27 +223,28 @@ public:
 
     /**
      * @brief Lenschow's thermal model
-     * @param {const double} r, z; radius and altitude
+     * @param {const T} r, z; radius and altitude
      * @param {const bool} choice; 1: with Gaussian distribution; 2: with Geodon model
 	 */
-    double lenschow_model(const double r, const double z, const bool choice)
+    template <class T>
+    T lenschow_model(const T r, const T z, const bool choice)
     {
-        double w_total = 0.;
+        T w_total = 0.;
         if(z>zi) {w_total=0.;} // flight level higher than CBL
         else {
-            double z_zi = z/zi;
-            double z_zi_powthird = pow(z_zi,1./3.);
+            T z_zi = z/zi;
+            T z_zi_powthird = pow(z_zi,1./3.);
             // diameter of the thermal given by
-            double d = 0.16 * z_zi_powthird * (1 - .25*z_zi) * zi;
+            T d = 0.16 * z_zi_powthird * (1 - .25*z_zi) * zi;
 
             //normalized updraft velocity
-            double w_= w_star * z_zi_powthird * (1 - 1.1*z_zi);
+            T w_= w_star * z_zi_powthird * (1 - 1.1*z_zi);
 
             // variance of the updraft velocity
             //double var = 1.8*pow(z_zi,2./3.) * (1.-.8*z_zi)*(1.-.8*z_zi);
 
             // w_peak assuming a gaussian distribution is
-            double w_peak = w_; //*(2./pow(M_PI,.5));
+            T w_peak = w_; //*(2./pow(M_PI,.5));
 
             if (choice == 1) {
                 w_total = w_peak * exp(-(4.*r*r/(d*d)));
@@ -269,28 +282,30 @@ public:
 
     /**
      * @brief Lawrance's thermal model
-     * @param {std::vector<double> &} w; wind vector
-     * @param {const double} x, y, z, t; spatio-temporal coordinates
+     * @param {T *} w; wind vector
+     * @param {const T} x, y, z; spatial coordinates
+     * @param {const double} t; time
 	 */
+    template <class T>
     void lawrance_model(
-        std::vector<double> &w,
-        const double x,
-        const double y,
-        const double z,
+        T *w,
+        const T x,
+        const T y,
+        const T z,
         const double t)
     {
         (void) t; // Unused by default
         double r1_rT = .36;
         double k = 3.;
-        double z_zi = z/zi;
-        double z_zi_powthird = pow(z_zi,1./3.);
+        T z_zi = z/zi;
+        T z_zi_powthird = pow(z_zi,1./3.);
 
-        double rT = std::max(10., .102 * z_zi_powthird * (1.-.25*z_zi) * zi);
-        double r1 = r1_rT * rT;
+        T rT = std::max<T>(10., .102 * z_zi_powthird * (1.-.25*z_zi) * zi);
+        T r1 = r1_rT * rT;
 
         //Calculating w_ and W_peak using
-        double w_ = w_star * z_zi_powthird * (1.-1.1*z_zi);
-        double w_core = 3.*w_*(rT-r1)*rT*rT / (rT*rT*rT - r1*r1*r1);
+        T w_ = w_star * z_zi_powthird * (1.-1.1*z_zi);
+        T w_core = 3.*w_*(rT-r1)*rT*rT / (rT*rT*rT - r1*r1*r1);
 
         double x0=0., y0=0., z0=800.;
         if(z0<k*rT) { // The bubble has not detached from the ground yet
@@ -302,10 +317,10 @@ public:
             y0 = yc0; //+ simpsons(integral_wz_allen(z),100.0,z,1000)*windy;
         }
 
-        double xt = x-x0;
-        double yt = y-y0;
-        double zt = z-z0;
-        double dH = sqrt(xt*xt + yt*yt);
+        T xt = x-x0;
+        T yt = y-y0;
+        T zt = z-z0;
+        T dH = sqrt(xt*xt + yt*yt);
 
         //Calculation of Wz
         if(dH == 0.) {
@@ -320,12 +335,12 @@ public:
 
         //calculation of windx and windy
         if(dH!=0. || dH<rT) {
-            double coef = (w[2]*zt)/(dH*(dH-rT)*k*k);
+            T coef = (w[2]*zt)/(dH*(dH-rT)*k*k);
             w[0] -= coef*xt;
             w[1] -= coef*yt;
         }
         else if(dH == rT) {
-            double dw = w_core/(2.*k*rT) * (1. + cos(M_PI*z/(k*rT)));
+            T dw = w_core/(2.*k*rT) * (1. + cos(M_PI*z/(k*rT)));
             w[0] -= dw;
             w[1] -= dw;
         }
@@ -336,10 +351,42 @@ public:
     }
 
     std_thermal& wind(const double x, const double y, const double z, const double t, std::vector<double> &w) override
+    {
+        return wind_t(x,y,z,t,w.data());
+    }
+
+    /**
+     * @brief Wind and its exact spatial derivatives
+     *
+     * Evaluate the wind with dual numbers seeded on (x,y,z), see 'thermal::wind_derivatives'.
+     */
+    std_thermal& wind_derivatives(const double x, const double y, const double z, const double t, std::vector<double> &w, std::vector<double> &dw) override
+    {
+        dual<3> wd[3];
+        for(unsigned int i=0; i<3; ++i) {
+            wd[i].v = w[i];
+            for(unsigned int j=0; j<3; ++j) {wd[i].d[j] = dw[3*i+j];}
+        }
+        wind_t(dual<3>(x,0),dual<3>(y,1),dual<3>(z,2),t,wd);
+        for(unsigned int i=0; i<3; ++i) {
+            w[i] = wd[i].v;
+            for(unsigned int j=0; j<3; ++j) {dw[3*i+j] = wd[i].d[j];}
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Wind, templated on the scalar type of the position
+     * @param {const T} x, y, z; coordinate in the earth frame
+     * @param {const double} t; time
+     * @param {T *} w; wind velocity vector in the earth frame
+     */
+    template <class T>
+    std_thermal& wind_t(const T x, const T y, const T z, const double t, T *w)
     {
         if (z>zi || z<zc0) {w[2]=0.;}
         else {
-            double r = dist_to_updraft_center(x,y,z);
+            T r = dist_to_center(x,y,z);
             switch(model) {
                 case 1: { // Allen model
                     w[2] += allen_model(r,z,t);
@@ -110,6 +110,38 @@ public:
 	 */
 	virtual thermal& wind(const double x, const double y, const double z, const double t, std::vector<double> &w) = 0;
 
+	/**
+     * @brief Wind and its spatial derivatives
+     *
+     * Computes the wind vector w and its derivatives dw, at point (x,y,z), at time t. As with
+     * 'wind', the input vectors hold the contributions of the previous thermals and are modified
+     * accordingly. Default is the central finite differences of 'wind'.
+     * @param {double} x, y, z; coordinate in the earth frame
+     * @param {double} t; time
+     * @param {std::vector<double> &} w; wind velocity vector in the earth frame
+     * @param {std::vector<double> &} dw; 3x3 row-major Jacobian, 'dw[3*i+j]' is the derivative of w[i] with respect to the j-th coordinate of (x,y,z)
+	 */
+	virtual thermal& wind_derivatives(const double x, const double y, const double z, const double t, std::vector<double> &w, std::vector<double> &dw) {
+        const double h = 1e-3;
+        std::vector<double> wp(3), wm(3);
+        double p[3] = {x, y, z};
+        std::vector<double> dw0(dw);
+        for(unsigned int j=0; j<3; ++j) {
+            double pj = p[j];
+            for(unsigned int i=0; i<3; ++i) { // the input wind moves along with the position
+                wp[i] = w[i] + h * dw0[3*i+j];
+                wm[i] = w[i] - h * dw0[3*i+j];
+            }
+            p[j] = pj + h;
+            wind(p[0],p[1],p[2],t,wp);
+            p[j] = pj - h;
+            wind(p[0],p[1],p[2],t,wm);
+            p[j] = pj;
+            for(unsigned int i=0; i<3; ++i) {dw[3*i+j] = (wp[i] - wm[i]) / (2. * h);}
+        }
+        return wind(x,y,z,t,w);
+    }
+
 	/**
 	 * @brief Print
 	 *
@@ -0,0 +1,166 @@
+#ifndef L2FSIM_THERMAL_SCENARIO_HPP_
+#define L2FSIM_THERMAL_SCENARIO_HPP_
+
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <thermal/std_thermal.hpp>
+
+/**
+ * @file thermal_scenario.hpp
+ * @brief Immutable thermal scenario shared by the flight zones
+ * @version 1.0
+ * @since 1.1
+ *
+ * A scenario is the configuration of a 'flat_thermal_soaring_zone' (boundaries, d_min, horizontal
+ * wind) and its thermals. It is not modified once built, hence the zone of the simulator and the
+ * ones of any number of planners and threads can read the same scenario through a
+ * 'std::shared_ptr<const thermal_scenario>', each zone keeping its own query state (e.g. noise).
+ * 'load' parses a scenario saved by 'flat_thermal_soaring_zone::save_scenario' and
+ * 'flat_thermal_soaring_zone::save_fz_cfg' once per process: the scenarios are kept by paths for
+ * as long as a zone uses them, a later load of the same paths returning the same scenario.
+ * @warning the files are assumed not to change while a scenario loaded from them is in use
+ */
+
+namespace L2Fsim {
+
+class thermal_scenario {
+public:
+    /**
+     * @brief Attributes
+     * @param {double} x_min, x_max, y_min, y_max, z_min, z_max; boundaries of the zone
+     * @param {double} d_min; minimum radius of a thermal
+     * @param {double} windx, windy; horizontal components of the wind velocity
+     * @param {std::vector<std::unique_ptr<thermal>>} thermals; thermals of the scenario
+     */
+    double x_min = 0., x_max = 0., y_min = 0., y_max = 0., z_min = 0., z_max = 0.;
+    double d_min = 0.;
+    double windx = 0., windy = 0.;
+    std::vector<std::unique_ptr<thermal>> thermals;
+
+    /**
+     * @brief Read a scenario, see 'flat_thermal_soaring_zone::save_scenario' and 'flat_thermal_soaring_zone::save_fz_cfg'
+     * @warning Expect same order of variables as in save_scenario and save_fz_cfg method, do not modify one without the other.
+     * @param {const std::string &} th_sc_p; thermal scenario input path
+     * @param {const std::string &} fz_cfg_p; flight zone configuration input path
+     * @return {std::shared_ptr<const thermal_scenario>} read scenario, not shared with the other loads
+     */
+    static std::shared_ptr<const thermal_scenario> read(const std::string &th_sc_p, const std::string &fz_cfg_p) {
+        std::shared_ptr<thermal_scenario> sc(new thermal_scenario);
+        // 1. Read flight zone configuration
+        std::ifstream cf_file(fz_cfg_p);
+        if (!cf_file.is_open()) {
+            std::cerr << "Unable to open input file ("<< fz_cfg_p <<") in thermal_scenario reader" << std::endl;
+        }
+        std::string line;
+        std::getline(cf_file,line); // do not take first line into account
+        std::getline(cf_file,line); // take 2nd line
+        if(line.size()>0) { // prevent from reading empty line
+            std::vector<std::string> result = split(line);
+            sc->x_min = stod(result.at(0));
+            sc->x_max = stod(result.at(1));
+            sc->y_min = stod(result.at(2));
+            sc->y_max = stod(result.at(3));
+            sc->z_min = stod(result.at(4));
+            sc->z_max = stod(result.at(5));
+            sc->d_min = stod(result.at(6));
+            sc->windx = stod(result.at(7));
+            sc->windy = stod(result.at(8));
+        } else {std::cout << "Unable to read 2nd line in fz configuration reader in thermal_scenario reader"<<std::endl;}
+        cf_file.close();
+        // 2. Read thermal scenario
+        std::ifstream sc_file(th_sc_p);
+        if (!sc_file.is_open()) {
+            std::cerr << "Unable to open input file ("<< th_sc_p <<") in thermal_scenario reader" << std::endl;
+        }
+        std::getline(sc_file,line); // do not take first line into account
+        while(sc_file.good()) {
+            std::getline(sc_file,line);
+            if(line.size()>0) { // prevent from reading last (empty) line
+                std::vector<std::string> result = split(line);
+                int model = std::stoi(result.at(0));
+                double t_birth = std::stod(result.at(1));
+                double lifespan = std::stod(result.at(2));
+                double w_star = std::stod(result.at(3));
+                double zi = std::stod(result.at(4));
+                double x = std::stod(result.at(5));
+                double y = std::stod(result.at(6));
+                double z = std::stod(result.at(7));
+                double ksi = std::stod(result.at(8));
+                std_thermal *new_th = new std_thermal(model,w_star,zi,t_birth,lifespan,x,y,z,ksi);
+                new_th->set_horizontal_wind(sc->windx,sc->windy);
+                sc->thermals.emplace_back(new_th);
+            }
+        }
+        sc_file.close();
+        return sc;
+    }
+
+    /**
+     * @brief Load a scenario, read only if no scenario of the same paths is in use
+     * @param {const std::string &} th_sc_p; thermal scenario input path
+     * @param {const std::string &} fz_cfg_p; flight zone configuration input path
+     * @return {std::shared_ptr<const thermal_scenario>} shared scenario
+     */
+    static std::shared_ptr<const thermal_scenario> load(const std::string &th_sc_p, const std::string &fz_cfg_p) {
+        std::lock_guard<std::mutex> lock(registry_mutex());
+        std::weak_ptr<const thermal_scenario> &entry = registry()[th_sc_p + '\n' + fz_cfg_p];
+        std::shared_ptr<const thermal_scenario> sc = entry.lock();
+        if(!sc) {
+            sc = read(th_sc_p,fz_cfg_p);
+            entry = sc;
+        }
+        return sc;
+    }
+
+    /**
+     * @brief Make a scenario the one loaded from some paths, e.g. after saving it there
+     * @param {const std::string &} th_sc_p; thermal scenario path
+     * @param {const std::string &} fz_cfg_p; flight zone configuration path
+     * @param {const std::shared_ptr<const thermal_scenario> &} sc; scenario
+     */
+    static void share(const std::string &th_sc_p, const std::string &fz_cfg_p, const std::shared_ptr<const thermal_scenario> &sc) {
+        std::lock_guard<std::mutex> lock(registry_mutex());
+        for(auto it=registry().begin(); it!=registry().end(); ) { // forget the scenarios no longer in use
+            if(it->second.expired()) {it = registry().erase(it);}
+            else {++it;}
+        }
+        registry()[th_sc_p + '\n' + fz_cfg_p] = sc;
+    }
+
+protected:
+    /** @brief Split a line of a scenario file */
+    static std::vector<std::string> split(const std::string &line) {
+        std::vector<std::string> result;
+        std::stringstream line_stream(line);
+        std::string cell;
+        while(std::getline(line_stream,cell,';')) {
+            result.push_back(cell);
+        }
+        if (!line_stream && cell.empty()) { // This checks for a trailing comma with no data after it
+            // If there was a trailing comma then add an empty element
+            result.push_back("");
+        }
+        return result;
+    }
+
+    /** @brief Scenarios in use, by paths */
+    static std::map<std::string, std::weak_ptr<const thermal_scenario>> & registry() {
+        static std::map<std::string, std::weak_ptr<const thermal_scenario>> r;
+        return r;
+    }
+
+    static std::mutex & registry_mutex() {
+        static std::mutex m;
+        return m;
+    }
+};
+
+}
+
+#endif
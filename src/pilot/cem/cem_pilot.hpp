@@ -0,0 +1,337 @@
+#ifndef L2FSIM_CEM_PILOT_HPP_
+#define L2FSIM_CEM_PILOT_HPP_
+
+#include <cmath>
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <vector>
+#include <pilot.hpp>
+#include <glider_reward.hpp>
+#include <worker_pool.hpp>
+#include <anytime.hpp>
+#include <flat_thermal_soaring_zone.hpp>
+#include <beeler_glider/beeler_glider_batch.hpp>
+
+/**
+ * @file cem_pilot.hpp
+ * @brief Open-loop planning of the bank angle with the cross-entropy method (CEM)
+ * @version 1.0
+ * @since 1.1
+ * @note compatibility: 'flat_thermal_soaring_zone.hpp'; 'beeler_glider.hpp'; 'beeler_glider_state.hpp'; 'beeler_glider_command.hpp'
+ * @note compile with '-pthread' if 'nb_threads > 1'
+ *
+ * A plan is a sequence of 'horizon' increments of the bank angle, in units of
+ * 'angle_rate_magnitude' and within [-1,1], each one applied during 'time_step_width'. At each
+ * decision, the plans are sampled from independent normal laws, one per time step, and their
+ * discounted returns are computed by rolling them out from the current state. The normal laws
+ * are then refitted to the 'nb_elites' plans of highest return, and so on for 'nb_iterations'
+ * iterations. The first increment of the best plan found is applied.
+ * - The population is rolled out as the lanes of 'beeler_glider_batch', split in one contiguous
+ *   range of lanes per thread; the atmosphere model is the pilot's own and is only read.
+ * - The first plan of each iteration is the mean of the laws and the second one of the first
+ *   iteration is the best plan of the previous decision, shifted.
+ * - The means are warm-started from the previous decision, shifted by the number of time steps
+ *   elapsed since then, while the standard deviations restart from 'initial_stddev'.
+ * - The reward is 'glider_reward', as for 'optimistic_pilot'.
+ * - Along a rollout, the increments are clipped so that the bank angle stays within its limits
+ *   and alpha follows the same D-controller as the applied command.
+ */
+
+namespace L2Fsim{
+
+class cem_pilot : public pilot {
+public:
+    /**
+     * @brief Attributes
+     * @param {std::vector<beeler_glider_batch>} batches; rollout lanes, one batch per thread
+     * @param {flat_thermal_soaring_zone} fz; atmosphere model, only read during the rollouts
+     * @param {double} angle_rate_magnitude; magnitude of the increment that one can apply to the angles
+     * @param {double} kdalpha; coefficient for the D controller in alpha
+     * @param {double} time_step_width; duration of a step of the plans (s)
+     * @param {double} sub_time_step_width; sub-time-step-width of the rollouts (s)
+     * @param {double} df; discount factor
+     * @param {unsigned int} population; number of plans sampled per iteration
+     * @param {unsigned int} horizon; number of time steps of a plan
+     * @param {unsigned int} nb_iterations; number of refits of the sampling laws per decision
+     * @param {unsigned int} nb_elites; number of plans of highest return the laws are refitted to
+     * @param {double} initial_stddev; standard deviation of the laws at the beginning of a decision
+     * @param {double} smoothing; weight of the previous law in a refit, 0 to take the elites' law
+     * @param {unsigned int} nb_threads; number of rollout threads
+     * @param {std::mt19937} generator; random generator of the plans
+     * @param {decision_stats} stats; latency and number of rollouts of the decisions
+     * @param {std::unique_ptr<worker_pool>} pool; threads of the rollouts
+     * @param {std::vector<double>} mean, stddev; sampling laws, one per time step
+     * @param {std::vector<double>} plans; sampled plans, 'horizon' values per plan
+     * @param {std::vector<double>} returns; discounted return of each plan
+     * @param {std::vector<double>} best_plan; plan of highest return of the last decision
+     * @param {double} plan_time; time of the last decision, origin of 'mean' and 'best_plan'
+     */
+    std::vector<beeler_glider_batch> batches;
+    flat_thermal_soaring_zone fz;
+    double angle_rate_magnitude;
+    double kdalpha;
+    double time_step_width;
+    double sub_time_step_width;
+    double df;
+    unsigned int population;
+    unsigned int horizon;
+    unsigned int nb_iterations;
+    unsigned int nb_elites;
+    double initial_stddev;
+    double smoothing;
+    unsigned int nb_threads;
+    std::mt19937 generator;
+    decision_stats stats;
+    std::unique_ptr<worker_pool> pool;
+    std::vector<double> mean;
+    std::vector<double> stddev;
+    std::vector<double> plans;
+    std::vector<double> returns;
+    std::vector<double> best_plan;
+    double plan_time;
+
+    /** @brief Constructor */
+    cem_pilot(
+        beeler_glider &_ac,
+        std::string sc_path,
+        std::string envt_cfg_path,
+        double noise_stddev,
+        double _angle_rate_magnitude=.01,
+        double _kdalpha=.01,
+        double _time_step_width=1.,
+        double _sub_time_step_width=1e-1,
+        double _df=.9,
+        unsigned int _population=64,
+        unsigned int _horizon=10,
+        unsigned int _nb_iterations=4,
+        unsigned int _nb_elites=8,
+        double _initial_stddev=.5,
+        double _smoothing=.1,
+        unsigned int _nb_threads=1,
+        unsigned int seed=std::random_device()()) :
+        batches(std::max(1u,_nb_threads),beeler_glider_batch(_ac)),
+        fz(sc_path,envt_cfg_path,noise_stddev),
+        angle_rate_magnitude(_angle_rate_magnitude),
+        kdalpha(_kdalpha),
+        time_step_width(_time_step_width),
+        sub_time_step_width(_sub_time_step_width),
+        df(_df),
+        population(std::max(2u,_population)),
+        horizon(std::max(1u,_horizon)),
+        nb_iterations(std::max(1u,_nb_iterations)),
+        nb_elites(std::min(std::max(1u,_nb_elites),population)),
+        initial_stddev(_initial_stddev),
+        smoothing(_smoothing),
+        nb_threads(std::max(1u,_nb_threads)),
+        generator(seed),
+        pool((nb_threads > 1) ? new worker_pool(nb_threads) : nullptr),
+        mean(horizon,0.),
+        stddev(horizon,initial_stddev),
+        plans(population * horizon,0.),
+        returns(population,0.),
+        best_plan(),
+        plan_time(0.)
+    {}
+
+    /**
+     * @brief Shift the plans of the last decision to the time of the current one
+     *
+     * The last step of a shifted mean is repeated. The plans are reset if the elapsed time is
+     * negative (new episode) or longer than the horizon.
+     * @param {double} t; time of the current decision
+     */
+    void warm_start(double t) {
+        double elapsed = (t - plan_time) / time_step_width;
+        unsigned int shift = (elapsed < 0.) ? horizon : (unsigned int) std::min((double) horizon, floor(elapsed + 1e-9));
+        if(shift >= horizon) {
+            std::fill(mean.begin(),mean.end(),0.);
+            best_plan.clear();
+            plan_time = t;
+        } else if(shift > 0) {
+            std::copy(mean.begin()+shift,mean.end(),mean.begin());
+            std::fill(mean.end()-shift,mean.end(),mean[horizon-shift-1]);
+            if(!best_plan.empty()) {
+                std::copy(best_plan.begin()+shift,best_plan.end(),best_plan.begin());
+                std::fill(best_plan.end()-shift,best_plan.end(),best_plan[horizon-shift-1]);
+            }
+            plan_time += shift * time_step_width;
+        }
+        std::fill(stddev.begin(),stddev.end(),initial_stddev);
+    }
+
+    /**
+     * @brief Sample the plans of an iteration from the laws, clipped to [-1,1]
+     * @param {bool} first; first iteration of the decision, the shifted best plan is kept
+     */
+    void sample_plans(bool first) {
+        std::normal_distribution<double> normal(0.,1.);
+        unsigned int j0 = 1;
+        std::copy(mean.begin(),mean.end(),plans.begin());
+        if(first && !best_plan.empty()) {
+            std::copy(best_plan.begin(),best_plan.end(),plans.begin()+horizon);
+            j0 = 2;
+        }
+        for(unsigned int j=j0; j<population; ++j) {
+            for(unsigned int k=0; k<horizon; ++k) {
+                double u = mean[k] + stddev[k] * normal(generator);
+                plans[j*horizon+k] = std::max(-1.,std::min(1.,u));
+            }
+        }
+    }
+
+    /**
+     * @brief Roll out a range of plans from a state and compute their discounted returns
+     * @param {beeler_glider_batch &} b; lanes of the calling thread
+     * @param {const beeler_glider_state &} s0; initial state
+     * @param {unsigned int} first, last; range of plans
+     * @note the plans are only read, several ranges can be rolled out concurrently with distinct batches
+     */
+    void rollout(beeler_glider_batch &b, const beeler_glider_state &s0, unsigned int first, unsigned int last) {
+        unsigned int n = last - first;
+        double nb_sub = std::max(1.,floor(time_step_width / sub_time_step_width));
+        b.resize(n);
+        for(unsigned int i=0; i<n; ++i) {
+            b.set_state(i,s0);
+            returns[first+i] = 0.;
+        }
+        double discount = 1.;
+        for(unsigned int k=0; k<horizon; ++k) {
+            for(unsigned int i=0; i<n; ++i) {
+                double lo = (-b.max_angle_magnitude[i] - b.sigma[i]) / nb_sub;
+                double hi = (+b.max_angle_magnitude[i] - b.sigma[i]) / nb_sub;
+                double u = plans[(first+i)*horizon+k] * angle_rate_magnitude;
+                b.dalpha[i] = kdalpha * (0. - b.s.gammadot[i]);
+                b.dbeta[i] = 0.;
+                b.dsigma[i] = std::max(lo,std::min(hi,u));
+            }
+            b.euler_transition(fz,time_step_width,sub_time_step_width);
+            for(unsigned int i=0; i<n; ++i) {
+                returns[first+i] += discount * glider_reward(b.s.zdot[i],b.s.V[i],b.s.Vdot[i]);
+            }
+            discount *= df;
+        }
+    }
+
+    /**
+     * @brief Roll out every plan, the population being split among the threads
+     * @param {const beeler_glider_state &} s0; initial state
+     */
+    void rollout_population(const beeler_glider_state &s0) {
+        if(nb_threads == 1) {
+            rollout(batches[0],s0,0,population);
+            return;
+        }
+        unsigned int chunk = (population + nb_threads - 1) / nb_threads;
+        pool->run(nb_threads,[this,&s0,chunk](unsigned int j, unsigned int th) {
+            unsigned int first = std::min(population,j*chunk);
+            unsigned int last = std::min(population,first+chunk);
+            if(first < last) {rollout(batches[th],s0,first,last);}
+        });
+    }
+
+    /**
+     * @brief Refit the laws to the elite plans
+     * @param {std::vector<unsigned int> &} order; indices of the plans, partially sorted by decreasing return
+     */
+    void refit(std::vector<unsigned int> &order) {
+        std::iota(order.begin(),order.end(),0);
+        std::partial_sort(order.begin(),order.begin()+nb_elites,order.end(),
+            [this](unsigned int i, unsigned int j){return returns[i] > returns[j];});
+        for(unsigned int k=0; k<horizon; ++k) {
+            double m = 0., v = 0.;
+            for(unsigned int e=0; e<nb_elites; ++e) {m += plans[order[e]*horizon+k];}
+            m /= nb_elites;
+            for(unsigned int e=0; e<nb_elites; ++e) {
+                double d = plans[order[e]*horizon+k] - m;
+                v += d * d;
+            }
+            v /= nb_elites;
+            mean[k] = smoothing * mean[k] + (1. - smoothing) * m;
+            stddev[k] = smoothing * stddev[k] + (1. - smoothing) * sqrt(v);
+        }
+    }
+
+    /**
+     * @brief Plan computation and action selection
+     * @param {state &} _s; reference on the state
+     * @param {command &} _a; reference on the command
+     * @warning dynamic cast of state and action
+     */
+    pilot & operator()(state &_s, command &_a) override {
+        anytime_deadline deadline;
+        beeler_glider_state &s0 = dynamic_cast <beeler_glider_state &> (_s);
+        beeler_glider_command &a = dynamic_cast <beeler_glider_command &> (_a);
+        warm_start(s0.time);
+        std::vector<unsigned int> order(population);
+        std::vector<double> best(horizon,0.);
+        double best_return = -1e300;
+        for(unsigned int it=0; it<nb_iterations; ++it) {
+            sample_plans(it == 0);
+            rollout_population(s0);
+            for(unsigned int j=0; j<population; ++j) {
+                if(returns[j] > best_return) {
+                    best_return = returns[j];
+                    std::copy(plans.begin()+j*horizon,plans.begin()+(j+1)*horizon,best.begin());
+                }
+            }
+            refit(order);
+        }
+        best_plan.swap(best);
+        double mam = s0.max_angle_magnitude;
+        a.dalpha = kdalpha * (0. - s0.gammadot); // D-controller
+        a.dbeta = 0.;
+        a.dsigma = std::max(-mam - s0.sigma,std::min(mam - s0.sigma,best_plan[0] * angle_rate_magnitude));
+        stats.record(deadline.elapsed(),population * nb_iterations,false);
+        return *this;
+    }
+
+    /**
+     * @brief Print the latency and the number of rollouts of the decisions
+     * @param {std::ostream &} os; output stream
+     */
+    void print_decision_stats(std::ostream &os) const override {
+        stats.print(os);
+    }
+
+    /**
+     * @brief Policy for 'out of boundaries' case
+     * @param {state &} s; reference on the state
+     * @param {command &} a; reference on the command
+     */
+    pilot & out_of_boundaries(state &_s, command &_a) override {
+        beeler_glider_state &s = dynamic_cast <beeler_glider_state &> (_s);
+        beeler_glider_command &a = dynamic_cast <beeler_glider_command &> (_a);
+        double ang_max = .4;
+        double x = s.x;
+        double y = s.y;
+        double khi = s.khi;
+        double sigma = s.sigma;
+        double cs = -(x*cos(khi) + y*sin(khi)) / sqrt(x*x + y*y); // cos between heading and origin
+        double th = .8; // threshold to steer back to flat command
+        a.set_to_neutral();
+        if (!is_less_than(sigma,0.) && is_less_than(sigma,ang_max)) {
+            if (is_less_than(cs,th)) {
+                if (is_less_than(sigma+angle_rate_magnitude,ang_max)) {
+                    a.dsigma = +angle_rate_magnitude;
+                }
+            } else {
+                a.dsigma = -angle_rate_magnitude;
+            }
+        } else if (is_less_than(sigma,0.) && is_less_than(-ang_max,sigma)) {
+            if (is_less_than(cs,th)) {
+                if (is_less_than(-ang_max,sigma-angle_rate_magnitude)) {
+                    a.dsigma = -angle_rate_magnitude;
+                }
+            } else {
+                a.dsigma = +angle_rate_magnitude;
+            }
+        }
+        return *this;
+    }
+};
+
+}
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef L2FSIM_GLIDER_REWARD_HPP_
+#define L2FSIM_GLIDER_REWARD_HPP_
+
+#include <utils.hpp>
+#include <beeler_glider/beeler_glider_state.hpp>
+
+/**
+ * @file glider_reward.hpp
+ * @brief Reward of the glider planners, shared by the pilots and the recorded datasets
+ * @version 1.0
+ * @since 1.1
+ */
+
+namespace L2Fsim {
+
+/**
+ * @brief Instantaneous reward: sigmoid of the rate of the specific total energy
+ * @param {double} zdot, V, Vdot; vertical speed, airspeed and its derivative
+ * @return {double} computed instantaneous reward
+ */
+inline double glider_reward(double zdot, double V, double Vdot) {
+    double edot = zdot + V * Vdot / 9.81;
+    return sigmoid(edot,10.,0.);
+}
+
+/**
+ * @brief Instantaneous reward at a state
+ * @param {const beeler_glider_state &} s; state
+ * @return {double} computed instantaneous reward
+ */
+inline double glider_reward(const beeler_glider_state &s) {
+    return glider_reward(s.zdot,s.V,s.Vdot);
+}
+
+}
+
+#endif
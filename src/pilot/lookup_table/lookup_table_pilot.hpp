@@ -0,0 +1,272 @@
+#ifndef L2FSIM_LOOKUP_TABLE_PILOT_HPP_
+#define L2FSIM_LOOKUP_TABLE_PILOT_HPP_
+
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <pilot.hpp>
+#include <pilot_io.hpp>
+#include <beeler_glider/beeler_glider_state.hpp>
+#include <beeler_glider/beeler_glider_command.hpp>
+
+/**
+ * @file lookup_table_pilot.hpp
+ * @brief Policy served from a table of actions over a regular grid of state variables
+ * @version 1.0
+ * @since 1.1
+ * @note compatibility: 'beeler_glider.hpp'; 'beeler_glider_state.hpp'; 'beeler_glider_command.hpp'
+ * @note the table is typically distilled from a planner by 'lut_distiller.hpp' and loaded with 'pilot_io.hpp'
+ *
+ * A decision is the index of the cell of the state (one division per variable) and a byte read,
+ * hence it takes a few nanoseconds whatever the planner the table was computed from.
+ */
+
+namespace L2Fsim {
+
+/** @brief Regular grid over some variables of the glider's state */
+class state_grid {
+public:
+    static constexpr unsigned int nb_variable_types = 8; ///< x; y; z; V; gamma; khi; sigma; time
+
+    /**
+     * @brief Attributes
+     * @param {std::vector<unsigned int>} variables; variables of the grid, see 'variable_name'
+     * @param {std::vector<double>} lower; lower bound of each variable
+     * @param {std::vector<double>} upper; upper bound of each variable, the values out of the bounds fall in the border cells
+     * @param {std::vector<unsigned int>} nb_bins; number of cells along each variable
+     */
+    std::vector<unsigned int> variables;
+    std::vector<double> lower;
+    std::vector<double> upper;
+    std::vector<unsigned int> nb_bins;
+
+    /**
+     * @brief Constructor
+     * @param {const std::string &} spec; comma-separated 'name:lower:upper:nb_bins', e.g. "x:-1500:1500:30,sigma:-.7:.7:7"
+     * @throw std::invalid_argument if an item is malformed, of an unknown variable, with lower >= upper or nb_bins < 1
+     */
+    state_grid(const std::string &spec="") {
+        std::stringstream ss(spec);
+        std::string item;
+        while(std::getline(ss,item,',')) {
+            std::stringstream is(item);
+            std::string name, lo, up, nb;
+            if(!(std::getline(is,name,':') && std::getline(is,lo,':') && std::getline(is,up,':') && std::getline(is,nb))) {
+                throw std::invalid_argument("state_grid: '" + item + "' is not 'name:lower:upper:nb_bins'");
+            }
+            unsigned int v = 0;
+            while(v < nb_variable_types && name != variable_name(v)) {++v;}
+            if(v == nb_variable_types) {throw std::invalid_argument("state_grid: unknown variable '" + name + "'");}
+            double l = std::stod(lo), u = std::stod(up);
+            int b = std::stoi(nb);
+            if(!valid_dimension(l,u,b)) {
+                throw std::invalid_argument("state_grid: '" + item + "' needs finite bounds, lower < upper and nb_bins > 0");
+            }
+            variables.push_back(v);
+            lower.push_back(l);
+            upper.push_back(u);
+            nb_bins.push_back((unsigned int) b);
+        }
+    }
+
+    /** @brief Whether some bounds and number of cells make a dimension of a grid, see 'cell' */
+    static bool valid_dimension(double l, double u, long long b) {
+        return std::isfinite(l) && std::isfinite(u) && l < u && b > 0;
+    }
+
+    /** @brief Name of a variable */
+    static const char * variable_name(unsigned int v) {
+        static const char * names[nb_variable_types] = {"x","y","z","V","gamma","khi","sigma","time"};
+        return names[v];
+    }
+
+    /** @brief Value of a variable at a state, the heading being wrapped in [-pi,pi] */
+    static double variable(const beeler_glider_state &s, unsigned int v) {
+        switch(v) {
+            case 0: {return s.x;}
+            case 1: {return s.y;}
+            case 2: {return s.z;}
+            case 3: {return s.V;}
+            case 4: {return s.gamma;}
+            case 5: {return wrap_angle(s.khi);}
+            case 6: {return s.sigma;}
+            default: {return s.time;}
+        }
+    }
+
+    /** @brief Number of cells */
+    std::size_t size() const {
+        std::size_t n = 1;
+        for(unsigned int b : nb_bins) {n *= b;}
+        return n;
+    }
+
+    /** @brief Cell of a state, the first variable varying the slowest */
+    std::size_t cell(const beeler_glider_state &s) const {
+        std::size_t c = 0;
+        for(unsigned int d=0; d<variables.size(); ++d) {
+            double u = (variable(s,variables[d]) - lower[d]) / (upper[d] - lower[d]);
+            int k = (int) floor(u * nb_bins[d]);
+            k = (k < 0) ? 0 : ((k >= (int) nb_bins[d]) ? nb_bins[d] - 1 : k);
+            c = c * nb_bins[d] + k;
+        }
+        return c;
+    }
+};
+
+class lookup_table_pilot : public pilot {
+public:
+    enum : std::uint8_t {no_action = 255}; ///< Cell without action, the bank angle is kept
+
+    /**
+     * @brief Attributes
+     * @param {double} angle_rate_magnitude; magnitude of the increment that one can apply to the angles
+     * @param {double} kdalpha; coefficient for the D controller in alpha
+     * @param {state_grid} grid; grid of the table
+     * @param {std::vector<std::uint8_t>} actions; action of each cell: 0 = increase sigma; 1 = decrease sigma; 2 = keep sigma; 'no_action'
+     */
+    double angle_rate_magnitude;
+    double kdalpha;
+    state_grid grid;
+    std::vector<std::uint8_t> actions;
+
+    /** @brief Constructor, every cell is without action */
+    lookup_table_pilot(
+        double _angle_rate_magnitude=.01,
+        double _kdalpha=.01,
+        const state_grid &_grid=state_grid()) :
+        angle_rate_magnitude(_angle_rate_magnitude),
+        kdalpha(_kdalpha),
+        grid(_grid),
+        actions(grid.size(),no_action)
+    {}
+
+    /** @brief Indice of an action: 0 = increase sigma; 1 = decrease sigma; 2 = keep sigma */
+    static std::uint8_t action_indice(const beeler_glider_command &a) {
+        return (a.dsigma > 0.) ? 0 : ((a.dsigma < 0.) ? 1 : 2);
+    }
+
+    /**
+     * @brief Action of the table at a state, kept within the bank angle limits
+     * @param {const beeler_glider_state &} s; state
+     * @return {std::uint8_t} indice of the action
+     */
+    std::uint8_t table_action(const beeler_glider_state &s) const {
+        std::uint8_t k = actions[grid.cell(s)];
+        if((k == 0 && !(s.sigma + angle_rate_magnitude < +s.max_angle_magnitude))
+        || (k == 1 && !(s.sigma - angle_rate_magnitude > -s.max_angle_magnitude))
+        || k == no_action) {
+            k = 2;
+        }
+        return k;
+    }
+
+    /**
+     * @brief Read the action of the state's cell
+     * @param {state &} _s; reference on the state
+     * @param {command &} _a; reference on the command
+     * @warning dynamic cast of state and action
+     */
+    pilot & operator()(state &_s, command &_a) override {
+        beeler_glider_state &s = dynamic_cast <beeler_glider_state &> (_s);
+        beeler_glider_command &a = dynamic_cast <beeler_glider_command &> (_a);
+        std::uint8_t k = table_action(s);
+        a.dalpha = kdalpha * (0. - s.gammadot);
+        a.dbeta = 0.;
+        a.dsigma = (k == 0) ? +angle_rate_magnitude : ((k == 1) ? -angle_rate_magnitude : 0.);
+        return *this;
+    }
+
+    /**
+     * @brief Policy for 'out of boundaries' case
+     * @param {state &} s; reference on the state
+     * @param {command &} a; reference on the command
+     */
+    pilot & out_of_boundaries(state &_s, command &_a) override {
+        beeler_glider_state &s = dynamic_cast <beeler_glider_state &> (_s);
+        beeler_glider_command &a = dynamic_cast <beeler_glider_command &> (_a);
+        double ang_max = .4;
+        double x = s.x;
+        double y = s.y;
+        double khi = s.khi;
+        double sigma = s.sigma;
+        double cs = -(x*cos(khi) + y*sin(khi)) / sqrt(x*x + y*y); // cos between heading and origin
+        double th = .8; // threshold to steer back to flat command
+        a.set_to_neutral();
+        if (!is_less_than(sigma,0.) && is_less_than(sigma,ang_max)) {
+            if (is_less_than(cs,th)) {
+                if (is_less_than(sigma+angle_rate_magnitude,ang_max)) {
+                    a.dsigma = +angle_rate_magnitude;
+                }
+            } else {
+                a.dsigma = -angle_rate_magnitude;
+            }
+        } else if (is_less_than(sigma,0.) && is_less_than(-ang_max,sigma)) {
+            if (is_less_than(cs,th)) {
+                if (is_less_than(-ang_max,sigma-angle_rate_magnitude)) {
+                    a.dsigma = -angle_rate_magnitude;
+                }
+            } else {
+                a.dsigma = +angle_rate_magnitude;
+            }
+        }
+		return *this;
+    }
+
+    /**
+     * @brief Write the table
+     *
+     * Payload: name; variables (uint32 each); lower and upper bounds; numbers of cells (uint32
+     * each); actions (one byte per cell).
+     * @param {std::ostream &} os; binary output stream
+     */
+    void save_parameters(std::ostream &os) const override {
+        std::vector<std::uint32_t> vars(grid.variables.begin(),grid.variables.end());
+        std::vector<std::uint32_t> bins(grid.nb_bins.begin(),grid.nb_bins.end());
+        write_name(os,"lookup_table_pilot");
+        write_binary(os,vars.data(),(std::uint32_t) vars.size());
+        write_binary(os,grid.lower.data(),(std::uint32_t) grid.lower.size());
+        write_binary(os,grid.upper.data(),(std::uint32_t) grid.upper.size());
+        write_binary(os,bins.data(),(std::uint32_t) bins.size());
+        write_binary(os,actions.data(),(std::uint32_t) actions.size());
+    }
+
+    /**
+     * @brief Read a table written by 'save_parameters', the grid of the pilot is replaced
+     * @param {std::istream &} is; binary input stream
+     * @throw std::runtime_error if a grid variable is unknown, with lower >= upper or without cell, or at the end of the stream; the pilot is then unchanged
+     */
+    void load_parameters(std::istream &is) override {
+        read_name(is,"lookup_table_pilot");
+        std::vector<std::uint32_t> vars, bins;
+        read_binary_vector(is,vars,state_grid::nb_variable_types);
+        std::uint32_t n = vars.size();
+        std::vector<double> lower(n), upper(n);
+        bins.resize(n);
+        read_binary(is,lower.data(),n);
+        read_binary(is,upper.data(),n);
+        read_binary(is,bins.data(),n);
+        for(std::uint32_t d=0; d<n; ++d) {
+            if(vars[d] >= state_grid::nb_variable_types) {throw std::runtime_error("lookup_table_pilot: unknown grid variable");}
+            if(!state_grid::valid_dimension(lower[d],upper[d],bins[d])) {throw std::runtime_error("lookup_table_pilot: invalid grid bounds or number of cells");}
+        }
+        state_grid g;
+        g.variables.assign(vars.begin(),vars.end());
+        g.lower = lower;
+        g.upper = upper;
+        g.nb_bins.assign(bins.begin(),bins.end());
+        std::vector<std::uint8_t> a;
+        read_binary_vector(is,a);
+        if(a.size() != g.size()) {throw std::runtime_error("lookup_table_pilot: " + std::to_string(a.size()) + " actions found, " + std::to_string(g.size()) + " cells expected");}
+        grid = g; // the grid and its actions are replaced together once the whole table is read
+        actions.swap(a);
+    }
+};
+
+}
+
+#endif
@@ -0,0 +1,188 @@
+#ifndef L2FSIM_LUT_DISTILLER_HPP_
+#define L2FSIM_LUT_DISTILLER_HPP_
+
+#include <array>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <simulation.hpp>
+#include <lookup_table/lookup_table_pilot.hpp>
+
+/**
+ * @file lut_distiller.hpp
+ * @brief Offline distillation of a planner into the table of a 'lookup_table_pilot'
+ * @version 1.0
+ * @since 1.1
+ * @note compile with '-pthread'
+ *
+ * 1. 'sample_states' runs simulations with a behaviour pilot (e.g. the planner itself) and keeps
+ *    the visited states;
+ * 2. 'label' queries the planner at each state, the states being split among threads which own
+ *    a planner each (built by a user-provided factory, planners are not thread-safe);
+ * 3. 'fit' sets the action of each cell of the grid to the majority of the labels of its states,
+ *    then the cells without states take the action of the nearest cell with one (breadth-first
+ *    over the grid neighbours), so that the table has an action everywhere;
+ * 4. 'agreement' measures the rate of states, e.g. held out from the fit, where the table and
+ *    the planner choose the same action.
+ */
+
+namespace L2Fsim {
+
+class lut_distiller {
+public:
+    /** @brief Function building a planner, called once per labelling thread */
+    typedef std::function<std::unique_ptr<pilot>()> planner_factory;
+
+    /**
+     * @brief Function setting up a simulation for a new episode (aircraft, stepper and flight zone if null)
+     * @param {simulation &} sim; simulation, its pilot is not used (the distiller steps the behaviour pilot)
+     * @param {unsigned int} episode; indice of the episode
+     */
+    typedef std::function<void(simulation &, unsigned int)> episode_setup;
+
+    /**
+     * @brief Attributes
+     * @param {state_grid} grid; grid of the table
+     * @param {std::vector<beeler_glider_state>} states; sampled states
+     * @param {std::vector<std::uint8_t>} labels; action of the planner at each state, see 'lookup_table_pilot::action_indice'
+     */
+    state_grid grid;
+    std::vector<beeler_glider_state> states;
+    std::vector<std::uint8_t> labels;
+
+    /** @brief Constructor */
+    lut_distiller(const state_grid &_grid) : grid(_grid) {}
+
+    /**
+     * @brief Sample the states visited by a pilot
+     * @param {pilot &} behaviour; pilot of the simulations
+     * @param {episode_setup} setup; set up of the simulations
+     * @param {unsigned int} nb_episodes; number of simulations
+     * @param {double} duration; simulated duration of an episode (s)
+     * @param {double} time_step_width; time step of the simulations (s)
+     * @param {unsigned int} period; one state out of 'period' is kept
+     */
+    void sample_states(
+        pilot &behaviour,
+        episode_setup setup,
+        unsigned int nb_episodes,
+        double duration,
+        double time_step_width,
+        unsigned int period=1)
+    {
+        simulation sim; // the pilot is owned by the caller, hence not set in 'sim.pl'
+        for(unsigned int e=0; e<nb_episodes; ++e) {
+            setup(sim,e);
+            double t = 0.;
+            bool eos = false;
+            for(unsigned int k=0; !eos && t<duration; ++k) {
+                if(k % period == 0) {states.push_back(dynamic_cast <beeler_glider_state &> (sim.ac->get_state()));}
+                (*sim.st)(*sim.fz,*sim.ac,behaviour,t,time_step_width,eos);
+            }
+        }
+    }
+
+    /**
+     * @brief Query a planner at the sampled states
+     * @param {planner_factory} factory; builds the planner of each thread
+     * @param {unsigned int} nb_threads; number of threads
+     */
+    void label(planner_factory factory, unsigned int nb_threads=1) {
+        labels.resize(states.size());
+        label_range(factory,states,labels,nb_threads);
+    }
+
+    /**
+     * @brief Set the actions of a table from the labelled states
+     * @param {lookup_table_pilot &} table; pilot receiving the table, its grid is set to 'grid'
+     */
+    void fit(lookup_table_pilot &table) const {
+        std::size_t n = grid.size();
+        std::vector<std::array<unsigned int, 3>> votes(n,std::array<unsigned int, 3>{{0,0,0}});
+        for(std::size_t i=0; i<states.size(); ++i) {
+            ++votes[grid.cell(states[i])][labels[i]];
+        }
+        table.grid = grid;
+        table.actions.assign(n,lookup_table_pilot::no_action);
+        std::deque<std::size_t> queue;
+        for(std::size_t c=0; c<n; ++c) {
+            const std::array<unsigned int, 3> &v = votes[c];
+            if(v[0] + v[1] + v[2] == 0) {continue;}
+            table.actions[c] = (v[2] >= v[0] && v[2] >= v[1]) ? 2 : ((v[0] >= v[1]) ? 0 : 1); // ties kept the bank angle
+            queue.push_back(c);
+        }
+        while(!queue.empty()) { // nearest labelled cell, breadth-first
+            std::size_t c = queue.front();
+            queue.pop_front();
+            std::size_t stride = 1;
+            for(unsigned int d=grid.nb_bins.size(); d-->0; ) {
+                std::size_t k = (c / stride) % grid.nb_bins[d];
+                if(k > 0) {visit(table,queue,c,c - stride);}
+                if(k + 1 < grid.nb_bins[d]) {visit(table,queue,c,c + stride);}
+                stride *= grid.nb_bins[d];
+            }
+        }
+    }
+
+    /**
+     * @brief Rate of agreement between a table and a planner
+     * @param {const lookup_table_pilot &} table; table
+     * @param {const std::vector<beeler_glider_state> &} test_states; states of the test
+     * @param {const std::vector<std::uint8_t> &} test_labels; actions of the planner at the states
+     * @return {double} rate of the states where the table chooses the planner's action
+     */
+    static double agreement(
+        const lookup_table_pilot &table,
+        const std::vector<beeler_glider_state> &test_states,
+        const std::vector<std::uint8_t> &test_labels)
+    {
+        std::size_t nb_agree = 0;
+        for(std::size_t i=0; i<test_states.size(); ++i) {
+            if(table.table_action(test_states[i]) == test_labels[i]) {++nb_agree;}
+        }
+        return test_states.empty() ? 0. : (double) nb_agree / test_states.size();
+    }
+
+    /**
+     * @brief Query a planner at some states, the states being split among threads
+     * @param {planner_factory} factory; builds the planner of each thread
+     * @param {const std::vector<beeler_glider_state> &} ss; states
+     * @param {std::vector<std::uint8_t> &} ll; action of the planner at each state, of the size of ss
+     * @param {unsigned int} nb_threads; number of threads
+     */
+    static void label_range(
+        planner_factory factory,
+        const std::vector<beeler_glider_state> &ss,
+        std::vector<std::uint8_t> &ll,
+        unsigned int nb_threads=1)
+    {
+        nb_threads = std::max(1u,nb_threads);
+        std::vector<std::thread> threads;
+        for(unsigned int k=0; k<nb_threads; ++k) {
+            threads.emplace_back([&factory,&ss,&ll,k,nb_threads]() {
+                std::unique_ptr<pilot> planner = factory();
+                for(std::size_t i=k; i<ss.size(); i+=nb_threads) {
+                    beeler_glider_state s = ss[i];
+                    beeler_glider_command a;
+                    (*planner)(s,a);
+                    ll[i] = lookup_table_pilot::action_indice(a);
+                }
+            });
+        }
+        for(auto &th : threads) {th.join();}
+    }
+
+protected:
+    static void visit(lookup_table_pilot &table, std::deque<std::size_t> &queue, std::size_t from, std::size_t to) {
+        if(table.actions[to] == lookup_table_pilot::no_action) {
+            table.actions[to] = table.actions[from];
+            queue.push_back(to);
+        }
+    }
+};
+
+}
+
+#endif
@@ -3,70 +3,126 @@
 
 #include <cstdio>
 #include <cstdlib>
+#include <climits>
+#include <vector>
 
 /**
  * @file optimistic_node.hpp
  * @brief Node for optimistic planning for 'beeler_glider.hpp' model
- * @version 1.0 (based on uct_node code)
+ * @version 1.1 (based on uct_node code)
  * @since 1.0
  * @note compatibility: 'beeler_glider.hpp'; 'beeler_glider_state.hpp'; 'beeler_glider_command.hpp'
+ * @note the nodes are stored in an 'optimistic_node_pool' and linked with indices in the pool
  */
 
 namespace L2Fsim{
 
 class optimistic_node {
 public:
+    /** @brief Index of no node, parent of the root */
+    static constexpr unsigned int no_node = UINT_MAX;
+
     /**
      * @brief Attributes
      * @param {beeler_glider_state} s; state of the node
-     * @param {std::vector<beeler_glider_command>} avail_actions; actions available from the node's state
      * @param {beeler_glider_command} incoming_action; action leading the node's parent to the node itself
      * @param {double} reward; reward obtained for this state s following this action incoming_action
      * @param {double} u_value; u_value of the node
      * @param {double} b_value; b_value of the node
      * @param {unsigned int} depth; depth of the node in the tree, root depth is 0
-     * @param {optimistic_node *} parent; pointer to the parent node
-     * @param {std::vector<optimistic_node>} children; vector containing the children of the node, initialy empty
-     * @warning the pointer to the parent 'parent' is obsolete if the node is root, make use of the boolean 'is_root_node'
+     * @param {unsigned int} parent; index of the parent node in the pool, 'no_node' for the root
+     * @param {unsigned int} first_child; index of the first child in the pool, the children are contiguous
+     * @param {unsigned int} nb_children; number of children, initialy 0
      */
     beeler_glider_state s;
-    std::vector<beeler_glider_command> avail_actions;
     beeler_glider_command incoming_action;
     double reward;
     double u_value;
     double b_value;
     unsigned int depth;
-    optimistic_node* parent;
-    std::vector<optimistic_node> children;
+    unsigned int parent;
+    unsigned int first_child;
+    unsigned int nb_children;
 
     /** @brief Empty constructor */
-    optimistic_node() {
-		children.reserve(3);
-		avail_actions.reserve(3);
-	}
+    optimistic_node() :
+        reward(0.),
+        u_value(0.),
+        b_value(0.),
+        depth(0),
+        parent(no_node),
+        first_child(no_node),
+        nb_children(0)
+    {}
 
     /** @brief Constructor with given state */
     optimistic_node(
         beeler_glider_state _s,
-        std::vector<beeler_glider_command> _avail_actions,
         beeler_glider_command _incoming_action,
         double _reward=0.,
         double _u_value=0.,
         double _b_value=0.,
         unsigned int _depth=0,
-        optimistic_node* _parent=nullptr) :
+        unsigned int _parent=no_node) :
         s(_s),
-        avail_actions(_avail_actions),
         incoming_action(_incoming_action),
         reward(_reward),
         u_value(_u_value),
         b_value(_b_value),
         depth(_depth),
-        parent(_parent)
-    {
-		children.reserve(3);
-		avail_actions.reserve(3);
-	}
+        parent(_parent),
+        first_child(no_node),
+        nb_children(0)
+    {}
+};
+
+/**
+ * @brief Arena of optimistic nodes
+ *
+ * The nodes of a tree are stored in a single vector and are never deallocated: clearing the pool
+ * is O(1) and the storage is reused by the next tree. The children of a node are allocated
+ * together, hence each node's children are contiguous and the tree is laid out level by level
+ * along the expanded branches.
+ */
+class optimistic_node_pool {
+public:
+    /**
+     * @brief Attributes
+     * @param {std::vector<optimistic_node>} nodes; storage of the nodes, its size is the capacity of the pool
+     * @param {unsigned int} nb_nodes; number of nodes in use
+     */
+    std::vector<optimistic_node> nodes;
+    unsigned int nb_nodes;
+
+    /** @brief Constructor */
+    optimistic_node_pool(unsigned int capacity=0) : nodes(capacity), nb_nodes(0) {}
+
+    /** @brief Ensure the capacity of the pool, keeping the nodes in use */
+    void reserve(unsigned int capacity) {
+        if(nodes.size() < capacity) {nodes.resize(capacity);}
+    }
+
+    /** @brief Remove all the nodes, the storage is kept */
+    void clear() {nb_nodes = 0;}
+
+    /** @brief Number of nodes in use */
+    unsigned int size() const {return nb_nodes;}
+
+    /**
+     * @brief Allocate contiguous nodes
+     * @param {unsigned int} n; number of nodes
+     * @return {unsigned int} index of the first allocated node
+     * @warning the references on the nodes are invalidated if the capacity is exceeded, use indices
+     */
+    unsigned int allocate(unsigned int n) {
+        if(nb_nodes + n > nodes.size()) {reserve(2 * (nb_nodes + n));}
+        unsigned int first = nb_nodes;
+        nb_nodes += n;
+        return first;
+    }
+
+    optimistic_node & operator[](unsigned int i) {return nodes[i];}
+    const optimistic_node & operator[](unsigned int i) const {return nodes[i];}
 };
 
 }
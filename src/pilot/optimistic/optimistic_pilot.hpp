@@ -4,10 +4,18 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cassert>
-#include <map>
+#include <algorithm>
+#include <utility>
+#include <memory>
 #include <pilot.hpp>
+#include <glider_reward.hpp>
+#include <worker_pool.hpp>
+#include <dary_heap.hpp>
+#include <anytime.hpp>
 #include <optimistic/optimistic_node.hpp>
 #include <flat_thermal_soaring_zone.hpp>
+#include <beeler_glider/beeler_glider_batch.hpp>
+#include <point_mass_glider/point_mass_glider.hpp>
 
 /**
  * @file optimistic_pilot.hpp
@@ -15,31 +23,88 @@
  * @version 1.0 (based on uct_pilot code)
  * @since 1.0
  * @note compatibility: 'flat_thermal_soaring_zone.hpp'; 'beeler_glider.hpp'; 'beeler_glider_state.hpp'; 'beeler_glider_command.hpp'
- * @note make use of: 'optimistic_node.hpp'
+ * @note make use of: 'optimistic_node.hpp', the nodes of the tree are allocated in a pool reused from one decision to the next
  * @note the different actions available from a node's state are set via the method 'get_actions'
- * @note transition model is defined in function 'transition_model'
+ * @note transition model is defined in function 'transition_model', the children of a node are computed together with 'beeler_glider_batch'
+ * @note with 'model_selector = 1' the transitions use the reduced-order 'point_mass_glider' instead of Beeler's glider
+ * @note with 'model_selector = 2' the children are computed by a single precision batch (4 lanes per SIMD pack)
+ * @note with 'tree_reuse' the subtree under the applied action is kept as the next tree if the observed state matches its prediction (see 'reuse_subtree')
+ * @note with 'nb_threads > 1' the 'parallel_width' leaves of highest b_value are expanded concurrently, each thread having its own transition models (see 'optimistic_models')
+ * @note with 'time_limit > 0' the expansions stop when the wall-clock deadline of the decision has passed (anytime mode), the latency of the decisions is recorded in 'stats'
  * @note reward model is defined in function 'reward_model'
  * @note termination criterion for a node is set in 'is_terminal' method
  */
 
 namespace L2Fsim{
 
-class optimistic_pilot : public pilot {
+/**
+ * @brief Transition models used by one expansion thread
+ */
+class optimistic_models {
 public:
     /**
      * @brief Attributes
      * @param {beeler_glider} ac; aircraft model
-     * @param {flat_thermal_soaring_zone} fz; atmosphere model
+     * @param {beeler_glider_batch} batch; batch propagation of the children of an expanded node
+     * @param {basic_beeler_glider_batch<float>} batch_f; single precision version of 'batch'
+     * @param {point_mass_glider} pm_ac; reduced-order aircraft model
+     */
+    beeler_glider ac;
+    beeler_glider_batch batch;
+    basic_beeler_glider_batch<float> batch_f;
+    point_mass_glider pm_ac;
+
+    optimistic_models(beeler_glider &_ac, double pm_tau) :
+        ac(_ac),
+        batch(_ac,3),
+        batch_f(_ac,3),
+        pm_ac(_ac.s,_ac.u,_ac.mass,_ac.wingspan,_ac.aspect_ratio,pm_tau)
+    {}
+};
+
+/**
+ * @brief Expansion of a leaf: the available actions and the resulting states of the children
+ */
+class optimistic_expansion {
+public:
+    unsigned int node; ///< Index of the expanded node
+    std::vector<beeler_glider_command> actions; ///< Actions available from the node's state
+    std::vector<beeler_glider_state> children; ///< States of the children
+
+    optimistic_expansion() : node(optimistic_node::no_node) {
+        actions.reserve(3);
+        children.reserve(3);
+    }
+};
+
+class optimistic_pilot : public pilot {
+public:
+    /**
+     * @brief Attributes
+     * @param {std::vector<optimistic_models>} models; transition models, one per thread
+     * @param {flat_thermal_soaring_zone} fz; atmosphere model, only read during the expansions
      * @param {double} angle_rate_magnitude; magnitude of the increment that one can apply to the angles
      * @param {double} kdalpha; coefficient for the D controller in alpha
      * @param {double} time_step_width;
      * @param {double} sub_time_step_width;
      * @param {double} df; discount factor
-     * @param {unsigned int} budget; number of expanded nodes in the tree
-     * @param {std::multimap<double, optimistic_node*>} leaves; map of the leaves, ordered by b_value, initially empty
-     * @param {optimistic_node *} u_max_node; pointer to the node with u_value maximum u_max
+     * @param {unsigned int} budget; maximum number of expanded nodes per decision, 0 for no limit if 'time_limit > 0', at least one expansion is made
+     * @param {unsigned int} model_selector; transition model: 0 = Beeler's glider; 1 = point-mass glider; 2 = Beeler's glider in single precision
+     * @param {bool} tree_reuse; keep the subtree under the applied action from one decision to the next
+     * @param {double} reuse_tolerance; maximum difference between the observed and the predicted state variables for the subtree to be kept (m, m/s, rad, s)
+     * @param {unsigned int} nb_threads; number of expansion threads, 1 for the serial algorithm
+     * @param {unsigned int} parallel_width; number of leaves expanded concurrently when 'nb_threads > 1'
+     * @param {double} time_limit; wall-clock time allowed per decision (s), 0 for no limit; the expansions stop at whichever of the budget or the time limit comes first
+     * @param {decision_stats} stats; latency and number of expansions of the decisions
+     * @param {std::unique_ptr<worker_pool>} pool; threads of the parallel expansions
+     * @param {optimistic_node_pool} tree; nodes of the tree, the root has index 0
+     * @param {optimistic_node_pool} spare; pool receiving the kept subtree, swapped with 'tree'
+     * @param {std::vector<optimistic_expansion>} expansions; expansions of the current round
+     * @param {dary_heap<4>} leaves; max-heap of the leaves' indices keyed by b_value, initially empty
+     * @param {unsigned int} u_max_node; index of the node with u_value maximum u_max
+     * @param {unsigned int} next_root; index of the root's child leading to u_max_node, root of the next tree
      */
-    beeler_glider ac;
+    std::vector<optimistic_models> models;
     flat_thermal_soaring_zone fz;
     double angle_rate_magnitude;
     double kdalpha;
@@ -47,8 +112,20 @@ public:
     double sub_time_step_width;
     double df;
     unsigned int budget;
-    std::multimap<double, optimistic_node*> leaves;
-    optimistic_node *u_max_node;
+    unsigned int model_selector;
+    bool tree_reuse;
+    double reuse_tolerance;
+    unsigned int nb_threads;
+    unsigned int parallel_width;
+    double time_limit;
+    decision_stats stats;
+    std::unique_ptr<worker_pool> pool;
+    optimistic_node_pool tree;
+    optimistic_node_pool spare;
+    std::vector<optimistic_expansion> expansions;
+    dary_heap<4> leaves;
+    unsigned int u_max_node;
+    unsigned int next_root;
 
     /** @brief Constructor */
     optimistic_pilot(
@@ -61,34 +138,51 @@ public:
         double _time_step_width=1e-1,
         double _sub_time_step_width=1e-1,
         double _df=.9,
-        unsigned int _budget=10000) :
-        ac(_ac),
+        unsigned int _budget=10000,
+        unsigned int _model_selector=0,
+        double pm_tau=1.,
+        bool _tree_reuse=false,
+        double _reuse_tolerance=1e-3,
+        unsigned int _nb_threads=1,
+        unsigned int _parallel_width=32,
+        double _time_limit=0.) :
+        models(std::max(1u,_nb_threads),optimistic_models(_ac,pm_tau)),
         fz(sc_path,envt_cfg_path,noise_stddev),
         angle_rate_magnitude(_angle_rate_magnitude),
         kdalpha(_kdalpha),
         time_step_width(_time_step_width),
         sub_time_step_width(_sub_time_step_width),
         df(_df),
-        budget(_budget)
+        budget(_budget),
+        model_selector(_model_selector),
+        tree_reuse(_tree_reuse),
+        reuse_tolerance(_reuse_tolerance),
+        nb_threads(std::max(1u,_nb_threads)),
+        parallel_width((nb_threads > 1) ? std::max(1u,_parallel_width) : 1),
+        time_limit(_time_limit),
+        pool((nb_threads > 1) ? new worker_pool(nb_threads) : nullptr),
+        tree(3 * _budget + 1),
+        expansions(parallel_width),
+        next_root(optimistic_node::no_node)
 	{}
 
     /**
-     * @brief Reward function model
+     * @brief Reward function model, see 'glider_reward.hpp'
      * @param {const beeler_glider_state &} s_t; current state
      * @return {double} computed instantaneous reward
      */
-    double reward_model(const beeler_glider_state &s_t) {
-        double edot = s_t.zdot + s_t.V * s_t.Vdot / 9.81;
-        return sigmoid(edot,10.,0.);
+    static double reward_model(const beeler_glider_state &s_t) {
+        return glider_reward(s_t);
     }
 
     /**
      * @brief Compute the u_value & b_value of a node
      * @param {optimistic_node &} v; considered node
+     * @param {const optimistic_node &} p; parent of the node
      */
-    void compute_values(optimistic_node &v) {
+    void compute_values(optimistic_node &v, const optimistic_node &p) {
         double df_d = pow(df, v.depth-1);
-        v.u_value = v.parent->u_value + df_d * v.parent->reward;
+        v.u_value = p.u_value + df_d * p.reward;
         v.b_value = v.u_value + df_d*df/ (1.-df);
     }
 
@@ -104,10 +198,10 @@ public:
     /**
      * @brief Get the available actions for a node, given its state
      * @param {const beeler_glider_state &} s; state of the node
-     * @return {std::vector<beeler_glider_command>} vector of the available actions
+     * @param {std::vector<beeler_glider_command> &} vect_a; vector of the available actions
      */
-    std::vector<beeler_glider_command> get_actions(const beeler_glider_state &s) {
-        std::vector<beeler_glider_command> vect_a;
+    void get_actions(const beeler_glider_state &s, std::vector<beeler_glider_command> &vect_a) {
+        vect_a.clear();
         double sig = s.sigma;
         double mam = s.max_angle_magnitude;
         if(sig+angle_rate_magnitude < +mam) {
@@ -121,48 +215,131 @@ public:
             alpha_d_ctrl(s,action);
         }
         assert(vect_a.size()!=0);
-        return vect_a;
     }
 
     /** @brief Print informations about the set of leaves */
 	void print_leaves(){
-		for(auto &e : leaves){
-			std::cout << std::get<1>(e)->avail_actions.size() << "-";
-			std::cout << std::get<1>(e)->depth << "-";
-			std::cout << std::get<1>(e)->u_value << "  -  ";
+		for(auto &e : leaves.data()){
+			std::cout << tree[e.value].depth << "-";
+			std::cout << tree[e.value].u_value << "  -  ";
 		}
 		std::cout << std::endl;
     }
 
     /**
-     * @brief Create all children from a node
-     * @param {optimistic_node *} ptr; pointer to the parent node
-     * @param {beeler_glider_command &} a; applied command
+     * @brief Create a child of a node
+     * @param {unsigned int} c; index of the child, allocated in the pool
+     * @param {unsigned int} p; index of the parent node
+     * @param {const beeler_glider_command &} a; applied command
+     * @param {const beeler_glider_state &} s_p; state resulting from the transition
      * @note Link the child to the current node as a parent
-     * @note Emplace the created child in the map of leaves
+     * @note Push the created child in the heap of leaves
      * @return {void}
      */
-    void create_child(optimistic_node *ptr, beeler_glider_command &a) {
-        beeler_glider_state s_p = transition_model(ptr->s,a);
-        double rwd = reward_model(s_p);
-        unsigned int new_depth = ptr->depth + 1;
-        ptr->children.emplace_back(s_p, get_actions(s_p), a, rwd,0.,0.,new_depth, ptr);
-        compute_values(ptr->children.back());
-        leaves.emplace(ptr->children.back().b_value,&ptr->children.back());
-        if(!is_less_than(ptr->children.back().u_value, u_max_node->u_value)){
-            u_max_node = &ptr->children.back();
+    void create_child(unsigned int c, unsigned int p, const beeler_glider_command &a, const beeler_glider_state &s_p) {
+        optimistic_node &v = tree[c];
+        v.s = s_p;
+        v.incoming_action = a;
+        v.reward = reward_model(s_p);
+        v.depth = tree[p].depth + 1;
+        v.parent = p;
+        v.first_child = optimistic_node::no_node;
+        v.nb_children = 0;
+        compute_values(v,tree[p]);
+        leaves.push(v.b_value,c);
+        if(!is_less_than(v.u_value, tree[u_max_node].u_value)){
+            u_max_node = c;
         }
 	}
 
     /**
-     * @brief Expand the node v with highest b_value
-     * @param {optimistic_node *} ptr; pointer to the node to expand
+     * @brief Expand the leaf with highest b_value
      * @return {void}
      */
-    void expand(optimistic_node *ptr) {
-        leaves.erase(--leaves.end());
-        for(auto &a : ptr->avail_actions) {
-          	create_child(ptr, a);
+    void expand() {
+        optimistic_expansion &x = expansions[0];
+        x.node = leaves.top().value;
+        leaves.pop();
+        compute_children(x,models[0]);
+        insert_children(x);
+    }
+
+    /**
+     * @brief Expand concurrently the leaves with highest b_value
+     *
+     * The leaves are removed from 'leaves' in decreasing order of b_value, their children are
+     * computed by the threads of 'pool' and inserted in the tree in the same order, hence the
+     * resulting tree does not depend on the scheduling of the threads. It differs from the serial
+     * one when a child of one of the expanded leaves would have been expanded before another one.
+     * @param {unsigned int} k; number of leaves to expand
+     * @return {unsigned int} number of expanded leaves
+     */
+    unsigned int expand_parallel(unsigned int k) {
+        k = std::min(k,(unsigned int)leaves.size());
+        for(unsigned int j=0; j<k; ++j) {
+            expansions[j].node = leaves.top().value;
+            leaves.pop();
+        }
+        pool->run(k,[this](unsigned int j, unsigned int th){compute_children(expansions[j],models[th]);});
+        for(unsigned int j=0; j<k; ++j) {insert_children(expansions[j]);}
+        return k;
+    }
+
+    /**
+     * @brief Compute the available actions of a node and the states of its children
+     * @param {optimistic_expansion &} x; expansion, the index of the node is set
+     * @param {optimistic_models &} m; transition models of the calling thread
+     * @note the tree is only read, several expansions can be computed concurrently with distinct models
+     */
+    void compute_children(optimistic_expansion &x, optimistic_models &m) {
+        const beeler_glider_state &s = tree[x.node].s;
+        get_actions(s,x.actions);
+        unsigned int n = x.actions.size();
+        x.children.resize(n);
+        if(model_selector == 1) {
+            for(unsigned int i=0; i<n; ++i) {
+                x.children[i] = transition_model(m.pm_ac,s,x.actions[i]);
+            }
+        } else if(model_selector == 2) {
+            compute_batch(m.batch_f,x);
+        } else {
+            compute_batch(m.batch,x);
+        }
+    }
+
+    /**
+     * @brief Compute the children of a node together with a batch
+     * @param {B &} b; batch of any scalar type
+     * @param {optimistic_expansion &} x; expansion, the actions are set
+     */
+    template <class B>
+    void compute_batch(B &b, optimistic_expansion &x) {
+        const beeler_glider_state &s = tree[x.node].s;
+        unsigned int n = x.actions.size();
+        b.resize(n);
+        for(unsigned int i=0; i<n; ++i) {
+            b.set_state(i,s);
+            b.set_command(i,x.actions[i]);
+        }
+        b.euler_transition(fz,time_step_width,sub_time_step_width);
+        for(unsigned int i=0; i<n; ++i) {
+            x.children[i] = s;
+            b.get_state(i,x.children[i]);
+        }
+    }
+
+    /**
+     * @brief Allocate the children of an expanded node and link them to the tree
+     * @param {const optimistic_expansion &} x; computed expansion
+     */
+    void insert_children(const optimistic_expansion &x) {
+        unsigned int p = x.node;
+        unsigned int n = x.actions.size();
+        unsigned int first = tree.allocate(n);
+        tree[p].first_child = first;
+        tree[p].nb_children = n;
+        for(unsigned int i=0; i<n; ++i) {
+            create_child(first+i, p, x.actions[i], x.children[i]);
         }
     }
 
@@ -172,14 +349,84 @@ public:
      */
     beeler_glider_command get_best_action() {
         beeler_glider_command best_a;
-        optimistic_node *v = u_max_node;
-     	while(v->depth != 0) {
-            best_a = v->incoming_action;
-            v = v->parent;
+        unsigned int i = u_max_node;
+        next_root = optimistic_node::no_node;
+     	while(tree[i].depth != 0) {
+            best_a = tree[i].incoming_action;
+            next_root = i;
+            i = tree[i].parent;
         }
         return best_a;
     }
 
+    /**
+     * @brief Test whether an observed state diverges from its prediction
+     * @param {const beeler_glider_state &} s; observed state
+     * @param {const beeler_glider_state &} s_pred; predicted state
+     * @return {bool} true if a variable differs by more than 'reuse_tolerance'
+     */
+    bool diverges(const beeler_glider_state &s, const beeler_glider_state &s_pred) {
+        double d[10] = {
+            s.x - s_pred.x, s.y - s_pred.y, s.z - s_pred.z, s.V - s_pred.V,
+            s.gamma - s_pred.gamma, wrap_angle(s.khi - s_pred.khi),
+            s.alpha - s_pred.alpha, s.beta - s_pred.beta, s.sigma - s_pred.sigma,
+            s.time - s_pred.time};
+        for(unsigned int i=0; i<10; ++i) {
+            if(!(std::fabs(d[i]) <= reuse_tolerance)) {return true;}
+        }
+        return false;
+    }
+
+    /**
+     * @brief Promote the child reached by the previous decision to the root of the tree
+     *
+     * The subtree is copied breadth-first into 'spare', which is then swapped with 'tree'. The
+     * values of its nodes are recomputed from the new root, so that the kept tree is the one that
+     * would have been built from the observed state, and its leaves are re-inserted in 'leaves'.
+     * @param {const beeler_glider_state &} s0; observed state
+     * @return {bool} false if there is no subtree to keep or if the observed state diverges from its prediction
+     */
+    bool reuse_subtree(const beeler_glider_state &s0) {
+        if(next_root == optimistic_node::no_node || next_root >= tree.size() || diverges(s0,tree[next_root].s)) {
+            return false;
+        }
+        spare.clear();
+        spare.reserve(tree.size() + 3 * budget + 1);
+        spare[spare.allocate(1)] = tree[next_root];
+        optimistic_node &root = spare[0];
+        root.s = s0;
+        root.reward = 0.;
+        root.u_value = 0.;
+        root.b_value = 0.;
+        root.depth = 0;
+        root.parent = optimistic_node::no_node;
+        leaves.clear();
+        u_max_node = 0;
+        for(unsigned int i=0; i<spare.size(); ++i) { // the pool is the queue of the breadth-first traversal
+            unsigned int n = spare[i].nb_children;
+            if(n == 0) {
+                leaves.push(spare[i].b_value,i);
+                continue;
+            }
+            unsigned int old_first = spare[i].first_child;
+            unsigned int first = spare.allocate(n);
+            spare[i].first_child = first;
+            for(unsigned int k=0; k<n; ++k) {
+                optimistic_node &v = spare[first+k];
+                v = tree[old_first+k];
+                v.depth = spare[i].depth + 1;
+                v.parent = i;
+                compute_values(v,spare[i]);
+                if(!is_less_than(v.u_value, spare[u_max_node].u_value)){
+                    u_max_node = first+k;
+                }
+            }
+        }
+        std::swap(tree.nodes,spare.nodes);
+        std::swap(tree.nb_nodes,spare.nb_nodes);
+        return true;
+    }
+
     /**
      * @brief Transition function; perform a transition given: an aircraft model with a correct state and command; an atmospheric model; the current time; the time-step-width and the sub-time-step-width
      * @note static method for use within an external simulator
@@ -210,15 +457,27 @@ public:
      * @param {const beeler_glider_state &} s; current state
      * @param {const beeler_glider_command &} a; applied command
      * @return {beeler_glider_state} resulting state
-     * @warning dynamic cast to beeler_glider_state
      */
     beeler_glider_state transition_model(const beeler_glider_state &s, const beeler_glider_command &a) {
+        optimistic_models &m = models[0];
+        return transition_model((model_selector == 1) ? m.pm_ac : m.ac, s, a);
+    }
+
+    /**
+     * @brief Transition function model with a given aircraft model
+     * @param {beeler_glider &} model; aircraft model
+     * @param {const beeler_glider_state &} s; current state
+     * @param {const beeler_glider_command &} a; applied command
+     * @return {beeler_glider_state} resulting state
+     * @warning dynamic cast to beeler_glider_state
+     */
+    beeler_glider_state transition_model(beeler_glider &model, const beeler_glider_state &s, const beeler_glider_command &a) {
         beeler_glider_state s_p = s;
-        ac.set_state(s_p);
-        ac.set_command(a);
+        model.set_state(s_p);
+        model.set_command(a);
         double current_time = s_p.time;
-        transition_function(ac,fz,current_time,time_step_width,sub_time_step_width);
-        s_p = dynamic_cast <beeler_glider_state &> (ac.get_state()); // retrieve the computed state
+        transition_function(model,fz,current_time,time_step_width,sub_time_step_width);
+        s_p = dynamic_cast <beeler_glider_state &> (model.get_state()); // retrieve the computed state
         return s_p;
     }
 
@@ -229,23 +488,51 @@ public:
      * @warning dynamic cast of state and action
      */
 	pilot & operator()(state &_s, command &_a) override {
+        anytime_deadline deadline(time_limit);
         beeler_glider_state &s0 = dynamic_cast <beeler_glider_state &> (_s);
         beeler_glider_command &a = dynamic_cast <beeler_glider_command &> (_a);
-        double rew_0 = reward_model(s0);
-        optimistic_node v0(s0,get_actions(s0),rew_0,0.,0.,0); // root node
-        leaves.insert(std::pair<double,optimistic_node*> (v0.b_value,&v0));
-        u_max_node = &v0;
-        for(unsigned int i=0; i<budget; ++i) {
-           	expand((--leaves.end())->second);
+        if(!(tree_reuse && reuse_subtree(s0))) {
+            tree.clear();
+            tree[tree.allocate(1)] = optimistic_node(s0,beeler_glider_command()); // root node
+            leaves.clear();
+            leaves.push(tree[0].b_value,0);
+            u_max_node = 0;
+        }
+        unsigned int max_expansions = (budget == 0 && deadline.is_bounded()) ? UINT_MAX : std::max(1u,budget);
+        if(budget != 0) {
+            tree.reserve(tree.size() + 3 * budget);
+            leaves.reserve(leaves.size() + 2 * budget + 1);
+        }
+        unsigned int nb_expansions = 0;
+        bool expired = false;
+        while(nb_expansions < max_expansions && !expired) { // at least one expansion
+            if(nb_threads > 1) {
+                unsigned int k = expand_parallel(std::min(parallel_width,max_expansions-nb_expansions));
+                if(k == 0) {break;}
+                nb_expansions += k;
+            } else {
+                expand();
+                ++nb_expansions;
+            }
+            expired = deadline.expired();
         }
         a = get_best_action();
         alpha_d_ctrl(s0,a); // D-controller
         //std::cout<<"ACTION choosen :  dsigma = " << a.dsigma << std::endl;
         //std::cout<<"                Altitude = " << s0.z     << std::endl;
         leaves.clear();
+        stats.record(deadline.elapsed(),nb_expansions,expired);
         return *this;
 	}
 
+    /**
+     * @brief Print the latency and the number of expansions of the decisions
+     * @param {std::ostream &} os; output stream
+     */
+    void print_decision_stats(std::ostream &os) const override {
+        stats.print(os);
+    }
+
     /**
      * @brief Policy for 'out of boundaries' case
      * @param {state &} s; reference on the state
@@ -2,6 +2,8 @@
 #define L2FSIM_PILOT_HPP_
 
 #include <vector>
+#include <istream>
+#include <ostream>
 #include <aircraft.hpp>
 
 namespace L2Fsim {
@@ -24,6 +26,26 @@ public:
      * @param {command &} u; reference on the command
      */
     virtual pilot& out_of_boundaries(state &s, command &u) = 0;
+
+    /**
+     * Print the per-decision statistics of a planning pilot, nothing for the other pilots
+     * @param {std::ostream &} os; output stream
+     */
+    virtual void print_decision_stats(std::ostream &os) const {(void) os;}
+
+    /**
+     * Write the learned parameters of the pilot in binary, nothing for the pilots that learn nothing
+     * @param {std::ostream &} os; binary output stream
+     * @note see 'pilot_io.hpp' for the file format
+     */
+    virtual void save_parameters(std::ostream &os) const {(void) os;}
+
+    /**
+     * Read the learned parameters written by 'save_parameters'
+     * @param {std::istream &} is; binary input stream
+     * @throw std::runtime_error if the parameters do not fit the pilot
+     */
+    virtual void load_parameters(std::istream &is) {(void) is;}
 };
 
 }
@@ -0,0 +1,122 @@
+#ifndef L2FSIM_LSPI_SOLVER_HPP_
+#define L2FSIM_LSPI_SOLVER_HPP_
+
+#include <cassert>
+#include <array>
+#include <vector>
+#include <Eigen/Dense>
+#include <replay_buffer.hpp>
+#include <q_learning/q_learning_pilot.hpp>
+
+/**
+ * @file lspi_solver.hpp
+ * @brief Least-squares policy iteration (LSPI) for the linear Q-function of 'q_learning_pilot'
+ * @version 1.0
+ * @since 1.1
+ * @note requires Eigen (compile with '-I/usr/include/eigen3')
+ *
+ * Batch alternative to the stochastic updates of the pilot (see Lagoudakis and Parr, Least-Squares
+ * Policy Iteration). Given a set of transitions (s, a, r, s_p) and a greedy policy pi, LSTD-Q
+ * accumulates A = sum phi(s,a) (phi(s,a) - df * phi(s_p,pi(s_p)))^T + reg * I and
+ * b = sum phi(s,a) r over the features of 'get_feature_vector', then solves A w = b for the
+ * weights of Q^pi. LSPI repeats this with the greedy policy of the new weights until they stop
+ * changing. Each sample is used at every iteration, hence a good policy needs far fewer simulated
+ * transitions than the online updates.
+ * The transitions are typically recorded by the pilot itself with a replay buffer of batch size 0.
+ */
+
+namespace L2Fsim {
+
+class lspi_solver {
+public:
+    typedef q_learning_pilot::feature_map feature_map;
+    typedef Eigen::Matrix<double, feature_map::size, feature_map::size> matrix_type;
+    typedef Eigen::Matrix<double, feature_map::size, 1> vector_type;
+
+    /**
+     * @brief Attributes
+     * @param {std::vector<q_transition>} samples; transitions of the batch
+     * @param {double} regularization; added to the diagonal of A, keeps it invertible when the samples do not span the features
+     * @param {unsigned int} nb_iterations; number of policy iterations of the last call to 'solve'
+     */
+    std::vector<q_transition> samples;
+    double regularization;
+    unsigned int nb_iterations;
+
+    /** @brief Constructor */
+    lspi_solver(double _regularization=1e-3) :
+        regularization(_regularization),
+        nb_iterations(0)
+    {}
+
+    /** @brief Add a transition */
+    void add(const q_transition &tr) {samples.push_back(tr);}
+
+    /** @brief Add the transitions of a replay buffer */
+    void add(const replay_buffer<q_transition> &replay) {
+        for(unsigned int i=0; i<replay.size(); ++i) {samples.push_back(replay[i]);}
+    }
+
+    /**
+     * @brief LSTD-Q: weights of the Q-function of the greedy policy of a pilot
+     * @param {const q_learning_pilot &} pl; pilot, its parameters define the evaluated policy
+     * @param {vector_type &} w; weights of the Q-function
+     */
+    void lstdq(const q_learning_pilot &pl, vector_type &w) const {
+        matrix_type A = regularization * matrix_type::Identity();
+        vector_type b = vector_type::Zero();
+        beeler_glider_state s, s_p;
+        feature_map::vector_type phi, phi_p;
+        for(const q_transition &tr : samples) {
+            tr.s.unpack(s);
+            tr.s_p.unpack(s_p);
+            pl.get_feature_vector(s,pl.indice_action(tr.action),phi);
+            pl.get_feature_vector(s_p,greedy_action(pl,s_p),phi_p);
+            Eigen::Map<const vector_type> f(phi.data()), f_p(phi_p.data());
+            A.noalias() += f * (f - pl.df * f_p).transpose();
+            b += tr.reward * f;
+        }
+        w = A.colPivHouseholderQr().solve(b);
+    }
+
+    /**
+     * @brief LSPI: policy iteration from the current parameters of a pilot
+     * @param {q_learning_pilot &} pl; pilot, its parameters are replaced by the solution
+     * @param {unsigned int} max_iterations; maximum number of policy iterations
+     * @param {double} tolerance; the iterations stop when the weights change by less (L2 norm)
+     * @return {double} change of the weights at the last iteration
+     */
+    double solve(q_learning_pilot &pl, unsigned int max_iterations=20, double tolerance=1e-6) {
+        assert(pl.approximator == 0); // linear Q-function only
+        vector_type w;
+        double change = 0.;
+        nb_iterations = 0;
+        while(nb_iterations < max_iterations) {
+            lstdq(pl,w);
+            ++nb_iterations;
+            Eigen::Map<vector_type> p(pl.parameters.data());
+            change = (w - p).norm();
+            p = w;
+            if(change < tolerance) {break;}
+        }
+        return change;
+    }
+
+protected:
+    /** @brief Deterministic greedy action, the first of maximum Q value */
+    static beeler_glider_command greedy_action(const q_learning_pilot &pl, const beeler_glider_state &s) {
+        q_learning_pilot::actions_type aa;
+        std::array<double, q_learning_pilot::max_nb_actions> scores;
+        unsigned int n = pl.get_avail_actions(s,aa);
+        pl.q_values(s,aa,n,scores);
+        unsigned int best = 0;
+        for(unsigned int l=1; l<n; ++l) {
+            if(scores[l] > scores[best]) {best = l;}
+        }
+        return aa[best];
+    }
+};
+
+}
+
+#endif
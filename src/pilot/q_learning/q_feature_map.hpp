@@ -0,0 +1,127 @@
+#ifndef L2FSIM_Q_FEATURE_MAP_HPP_
+#define L2FSIM_Q_FEATURE_MAP_HPP_
+
+#include <array>
+
+/**
+ * @file q_feature_map.hpp
+ * @brief Quadratic feature map of fixed size for linear Q-functions
+ * @version 1.0
+ * @since 1.1
+ *
+ * The feature vector of size 'size' is made of N base features, the first one being the constant
+ * 1, followed by the products phi[i]*phi[j] for 1 <= i <= j < N (i in the outer loop). The index
+ * pairs of the products are computed at compile time and the expansion is unrolled, the vectors
+ * are 'std::array' hence no allocation is made.
+ * The batch version expands L feature vectors stored lane-wise (phi[k][l] is the k-th feature of
+ * the l-th vector) so that the products and the dot products run on all the lanes at once.
+ */
+
+namespace L2Fsim {
+
+/** @brief Compile-time list of indices */
+template <unsigned int... K>
+struct index_list {};
+
+template <unsigned int M, unsigned int... K>
+struct make_index_list : make_index_list<M-1, M-1, K...> {};
+
+template <unsigned int... K>
+struct make_index_list<0, K...> {
+    typedef index_list<K...> type;
+};
+
+template <unsigned int N>
+class quadratic_feature_map {
+public:
+    static_assert(N >= 1, "the constant feature is required");
+
+    static constexpr unsigned int nb_base = N; ///< Number of base features, including the constant
+    static constexpr unsigned int nb_cross = N * (N - 1) / 2; ///< Number of products
+    static constexpr unsigned int size = N + nb_cross; ///< Size of the feature vector
+
+    typedef std::array<double, size> vector_type;
+
+    template <unsigned int L>
+    using batch_type = std::array<std::array<double, L>, size>;
+
+    /**
+     * @brief First factor of the k-th product
+     * @param {unsigned int} k; index of the product
+     * @param {unsigned int} i; first factor of the products considered, for the recursion
+     */
+    static constexpr unsigned int row(unsigned int k, unsigned int i=1) {
+        return (k < N - i) ? i : row(k - (N - i), i + 1);
+    }
+
+    /** @brief Second factor of the k-th product, see 'row' */
+    static constexpr unsigned int col(unsigned int k, unsigned int i=1) {
+        return (k < N - i) ? i + k : col(k - (N - i), i + 1);
+    }
+
+    /**
+     * @brief Compute the products of a feature vector
+     * @param {vector_type &} phi; feature vector whose N first entries are set
+     */
+    static void expand(vector_type &phi) {
+        expand(phi,typename make_index_list<nb_cross>::type());
+    }
+
+    /**
+     * @brief Compute the products of a batch of feature vectors
+     * @param {batch_type<L> &} phi; lane-wise feature vectors whose N first entries are set
+     */
+    template <unsigned int L>
+    static void expand(batch_type<L> &phi) {
+        expand<L>(phi,typename make_index_list<nb_cross>::type());
+    }
+
+    /** @brief Dot product of a weight vector and a feature vector */
+    static double dot(const vector_type &w, const vector_type &phi) {
+        double score = 0.;
+        for(unsigned int k=0; k<size; ++k) {
+            score += w[k] * phi[k];
+        }
+        return score;
+    }
+
+    /**
+     * @brief Dot products of a weight vector and a batch of feature vectors
+     * @param {const vector_type &} w; weight vector
+     * @param {const batch_type<L> &} phi; lane-wise feature vectors
+     * @param {std::array<double, L> &} scores; dot product of each lane
+     */
+    template <unsigned int L>
+    static void dot(const vector_type &w, const batch_type<L> &phi, std::array<double, L> &scores) {
+        scores.fill(0.);
+        for(unsigned int k=0; k<size; ++k) {
+            for(unsigned int l=0; l<L; ++l) {
+                scores[l] += w[k] * phi[k][l];
+            }
+        }
+    }
+
+protected:
+    template <unsigned int... K>
+    static void expand(vector_type &phi, index_list<K...>) {
+        int unused[] = {0, (phi[N + K] = phi[row(K)] * phi[col(K)], 0)...};
+        (void) unused;
+    }
+
+    template <unsigned int L, unsigned int K>
+    static void expand_lanes(batch_type<L> &phi) {
+        for(unsigned int l=0; l<L; ++l) {
+            phi[N + K][l] = phi[row(K)][l] * phi[col(K)][l];
+        }
+    }
+
+    template <unsigned int L, unsigned int... K>
+    static void expand(batch_type<L> &phi, index_list<K...>) {
+        int unused[] = {0, (expand_lanes<L, K>(phi), 0)...};
+        (void) unused;
+    }
+};
+
+}
+
+#endif
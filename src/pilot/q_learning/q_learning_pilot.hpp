@@ -1,9 +1,20 @@
 #ifndef L2FSIM_Q_LEARNING_PILOT_HPP_
 #define L2FSIM_Q_LEARNING_PILOT_HPP_
 
+#include <cassert>
 #include <cstdio>
 #include <cstdlib>
+#include <array>
+#include <atomic>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
 #include <pilot.hpp>
+#include <q_learning/q_feature_map.hpp>
+#include <q_learning/tile_coder.hpp>
+#include <replay_buffer.hpp>
+#include <pilot_io.hpp>
 
 /**
  * @brief An online implementation of a Q-Learning algorithm
@@ -12,14 +23,125 @@
  *
  * @note compatibility: 'beeler_glider.hpp'; 'beeler_glider_state.hpp'; 'beeler_glider_command.hpp'
  * @note action space defined in method 'get_available_actions'
- * @note feature vector defined in method 'get_feature_vector'
+ * @note feature vector defined in method 'get_feature_vector', of fixed size (see 'q_feature_map.hpp')
+ * @note the Q-values of the available actions are computed together by 'q_values', a step makes no allocation
  * @note reward function defined in method 'get_reward'
+ * @note with 'approximator = 1' the Q-function is a hashed tile coding (see 'tile_coder.hpp') over the variables listed in 'tile_variables', an evaluation and an update touch 'nb_tilings' weights only
+ * @note with a replay capacity, each transition is stored in a prioritized replay buffer (see 'replay_buffer.hpp') and a step learns from a minibatch sampled from the buffer instead of the last transition
+ * @note the learned weights (of the selected approximator) and the thermal estimate are saved and loaded by 'save_parameters' and 'load_parameters' (see 'pilot_io.hpp')
+ * @note with 'shared' set, the parameters are read from and the updates written to a 'q_shared_parameters' vector updated concurrently by other pilots (see 'q_learning_trainer.hpp')
  */
 
 namespace L2Fsim{
 
+/**
+ * @brief Parameters vector shared by several pilots learning concurrently
+ *
+ * The entries are atomics accessed with relaxed ordering. An update reads and writes each entry
+ * without a lock nor a compare-and-swap (Hogwild): concurrent updates of the same entry may be
+ * lost, which does not prevent the convergence of the stochastic updates as long as they are
+ * small, and a reader may see an update partially applied over the vector.
+ */
+template <unsigned int N>
+class q_shared_parameters {
+public:
+    std::array<std::atomic<double>, N> w; ///< Entries of the vector
+
+    /** @brief Constructor, zero vector */
+    q_shared_parameters() {
+        for(auto &x : w) {x.store(0.,std::memory_order_relaxed);}
+    }
+
+    /** @brief Copy the entries into a vector */
+    void load(std::array<double, N> &p) const {
+        for(unsigned int i=0; i<N; ++i) {p[i] = w[i].load(std::memory_order_relaxed);}
+    }
+
+    /** @brief Overwrite the entries */
+    void store(const std::array<double, N> &p) {
+        for(unsigned int i=0; i<N; ++i) {w[i].store(p[i],std::memory_order_relaxed);}
+    }
+
+    /** @brief Add an increment to an entry, not atomically (Hogwild) */
+    void add(unsigned int i, double dw) {
+        w[i].store(w[i].load(std::memory_order_relaxed) + dw,std::memory_order_relaxed);
+    }
+};
+
+/**
+ * @brief Estimate of the position of a thermal
+ *
+ * Centroid of the visited positions weighted by the positive energy rates, the weights decaying
+ * geometrically at each update so that the estimate follows the glider's recent experience.
+ */
+class thermal_estimate {
+public:
+    double decay; ///< Decay factor of the weights at each update
+    double sw; ///< Sum of the weights
+    double sx; ///< Weighted sum of the x coordinates
+    double sy; ///< Weighted sum of the y coordinates
+
+    thermal_estimate(double _decay=.99) : decay(_decay), sw(0.), sx(0.), sy(0.) {}
+
+    /** @brief Account for the energy rate at the current position */
+    void update(const beeler_glider_state &s) {
+        double edot = s.zdot + s.V * s.Vdot / 9.81;
+        double w = (edot > 0.) ? edot : 0.;
+        sw = decay * sw + w;
+        sx = decay * sx + w * s.x;
+        sy = decay * sy + w * s.y;
+    }
+
+    /** @brief Distance from a state to the estimate, 0 if there is no estimate yet */
+    double distance(const beeler_glider_state &s) const {
+        if(!(sw > 0.)) {return 0.;}
+        return sqrt(pow(sx / sw - s.x, 2) + pow(sy / sw - s.y, 2));
+    }
+
+    /** @brief Bearing of the estimate relative to the heading of a state, in [-pi,pi], 0 if there is no estimate yet */
+    double heading(const beeler_glider_state &s) const {
+        if(!(sw > 0.)) {return 0.;}
+        return wrap_angle(atan2(sy / sw - s.y, sx / sw - s.x) - s.khi);
+    }
+};
+
+/**
+ * @brief Transition of 'q_learning_pilot' stored for replay, in single precision
+ *
+ * Only the variables read by the Q-functions and by the available actions are kept; the
+ * thermal variables of the tile coding are computed from the current estimate when replayed.
+ */
+struct q_transition {
+    struct compact_state {
+        float x, y, z, V, khi, sigma, max_angle_magnitude, zdot, gammadot;
+
+        void pack(const beeler_glider_state &s) {
+            x = s.x; y = s.y; z = s.z; V = s.V; khi = s.khi; sigma = s.sigma;
+            max_angle_magnitude = s.max_angle_magnitude; zdot = s.zdot; gammadot = s.gammadot;
+        }
+
+        void unpack(beeler_glider_state &s) const {
+            s.x = x; s.y = y; s.z = z; s.V = V; s.khi = khi; s.sigma = sigma;
+            s.max_angle_magnitude = max_angle_magnitude; s.zdot = zdot; s.gammadot = gammadot;
+        }
+    };
+
+    compact_state s; ///< State t
+    compact_state s_p; ///< State t+1
+    float reward; ///< Reward r(s, a, s_p)
+    unsigned char action; ///< Action t, see 'q_learning_pilot::action_indice'
+};
+
 class q_learning_pilot : public pilot {
 public:
+    typedef quadratic_feature_map<5> feature_map; ///< 1, zdot, gammadot, sigma, dsigma and their products
+    typedef feature_map::vector_type parameters_type;
+    static constexpr unsigned int max_nb_actions = 3; ///< Maximum number of available actions
+    typedef std::array<beeler_glider_command, max_nb_actions> actions_type;
+    typedef q_shared_parameters<feature_map::size> shared_parameters_type;
+    static constexpr unsigned int nb_tile_variable_types = 7; ///< zdot; gammadot; sigma; V; z; thermal_distance; thermal_heading
+    typedef std::array<double, nb_tile_variable_types> tile_input_type;
+
     /**
      * @brief Attributes
      * @param {beeler_glider_state} prev_s; previous state
@@ -29,7 +151,17 @@ public:
      * @param {double} epsilon; for epsilon-greedy policy
      * @param {double} lr; learning rate (aka alpha in the literature)
      * @param {double} df; discount factor (aka gamma in the literature)
-     * @param {std::vector<double>} parameters; parameters vector
+     * @param {parameters_type} parameters; parameters vector
+     * @param {bool} prev_valid; false until the first step of an episode, there is no transition to learn from
+     * @param {shared_parameters_type *} shared; parameters shared with other pilots, nullptr if the pilot learns alone
+     * @param {unsigned long} nb_updates; number of learned transitions
+     * @param {std::mt19937} generator; random generator of the policies
+     * @param {unsigned int} approximator; Q-function approximator: 0 = quadratic features; 1 = tile coding
+     * @param {std::vector<unsigned int>} tile_variables; variables of the tile coding, see 'tile_variable'
+     * @param {tile_coder} tiles; tile coding of the variables and the action
+     * @param {thermal_estimate} thermal; estimate of the position of a thermal, for the tile coding variables
+     * @param {replay_buffer<q_transition>} replay; replayed transitions, of capacity 0 to learn online from the last transition
+     * @param {unsigned int} replay_batch_size; number of transitions replayed at each step, 0 to only record the transitions (e.g. for 'lspi_solver.hpp')
      */
     beeler_glider_state prev_s;
     beeler_glider_command prev_a;
@@ -38,24 +170,137 @@ public:
     double epsilon;
     double lr;
     double df;
-    std::vector<double> parameters;
+    parameters_type parameters;
+    bool prev_valid;
+    shared_parameters_type *shared;
+    unsigned long nb_updates;
+    std::mt19937 generator;
+    unsigned int approximator;
+    std::vector<unsigned int> tile_variables;
+    tile_coder tiles;
+    thermal_estimate thermal;
+    replay_buffer<q_transition> replay;
+    unsigned int replay_batch_size;
 
+    /**
+     * @brief Constructor
+     * @param {unsigned int} _approximator; Q-function approximator: 0 = quadratic features; 1 = tile coding
+     * @param {const std::string &} tile_variables_list; comma-separated names of the variables of the tile coding, see 'tile_variable_name'
+     * @param {unsigned int} nb_tilings; number of tilings of the tile coding
+     * @param {unsigned int} table_bits; the weight table of the tile coding has 2^table_bits entries
+     * @param {double} tile_width_scale; factor applied to the default tile widths
+     * @param {unsigned int} replay_capacity; capacity of the replay buffer, 0 to learn online
+     * @param {unsigned int} _replay_batch_size; number of transitions replayed at each step
+     * @param {double} replay_alpha; priority exponent of the replay, 0 for uniform sampling
+     * @param {double} replay_beta; importance-sampling exponent of the replay
+     * @throw std::invalid_argument if a tile coding variable is unknown or the tile coder is misconfigured, see 'tile_coder'
+     */
     q_learning_pilot(
         double _angle_rate_magnitude=.0,
         double _kdalpha=.01,
         double _epsilon=.01,
         double _lr=.01,
-        double _df=.9) :
+        double _df=.9,
+        unsigned int seed=std::random_device()(),
+        unsigned int _approximator=0,
+        const std::string &tile_variables_list="zdot,gammadot,sigma",
+        unsigned int nb_tilings=8,
+        unsigned int table_bits=16,
+        double tile_width_scale=1.,
+        unsigned int replay_capacity=0,
+        unsigned int _replay_batch_size=32,
+        double replay_alpha=.6,
+        double replay_beta=.4) :
         prev_s(),
         prev_a(),
         angle_rate_magnitude(_angle_rate_magnitude),
         kdalpha(_kdalpha),
         epsilon(_epsilon),
         lr(_lr),
-        df(_df)
+        df(_df),
+        prev_valid(false),
+        shared(nullptr),
+        nb_updates(0),
+        generator(seed),
+        approximator(_approximator),
+        tile_variables(parse_tile_variables(tile_variables_list)),
+        tiles(tile_widths(tile_variables,tile_width_scale),nb_tilings,table_bits),
+        replay(replay_capacity,replay_alpha,replay_beta),
+        replay_batch_size(_replay_batch_size),
+        replay_indices(_replay_batch_size),
+        replay_weights(_replay_batch_size),
+        replay_errors(_replay_batch_size)
     {
-        std::vector<double> phi = get_feature_vector(prev_s,prev_a);
-        parameters.resize(phi.size(),0.);
+        parameters.fill(0.);
+    }
+
+    /**
+     * @brief Name of a tile coding variable
+     * @param {unsigned int} v; variable: 0 = zdot; 1 = gammadot; 2 = sigma; 3 = V; 4 = z; 5 = thermal_distance; 6 = thermal_heading
+     */
+    static const char * tile_variable_name(unsigned int v) {
+        static const char * names[nb_tile_variable_types] = {"zdot","gammadot","sigma","V","z","thermal_distance","thermal_heading"};
+        return names[v];
+    }
+
+    /** @brief Default tile width along a variable (m/s, rad/s, rad, m/s, m, m, rad) */
+    static double tile_variable_width(unsigned int v) {
+        static const double widths[nb_tile_variable_types] = {1., .05, 5.*TO_RAD, 2., 50., 50., 30.*TO_RAD};
+        return widths[v];
+    }
+
+    /** @brief Variables of a comma-separated list of names */
+    static std::vector<unsigned int> parse_tile_variables(const std::string &list) {
+        std::vector<unsigned int> vars;
+        std::stringstream ss(list);
+        std::string name;
+        while(std::getline(ss,name,',')) {
+            name.erase(0,name.find_first_not_of(" \t"));
+            name.erase(name.find_last_not_of(" \t") + 1);
+            unsigned int v = 0;
+            while(v < nb_tile_variable_types && name != tile_variable_name(v)) {++v;}
+            if(v == nb_tile_variable_types) {
+                throw std::invalid_argument("q_learning_pilot: unknown tile coding variable '" + name + "'");
+            }
+            vars.push_back(v);
+        }
+        return vars;
+    }
+
+    /** @brief Tile widths of the variables */
+    static std::vector<double> tile_widths(const std::vector<unsigned int> &vars, double scale) {
+        std::vector<double> w;
+        for(unsigned int v : vars) {w.push_back(scale * tile_variable_width(v));}
+        return w;
+    }
+
+    /**
+     * @brief Input of the tile coding at a state
+     * @param {const beeler_glider_state &} s; state
+     * @param {tile_input_type &} x; values of the tile coding variables, in the order of 'tile_variables'
+     */
+    void get_tile_input(const beeler_glider_state &s, tile_input_type &x) const {
+        for(unsigned int d=0; d<tile_variables.size(); ++d) {
+            switch(tile_variables[d]) {
+                case 0: {x[d] = s.zdot; break;}
+                case 1: {x[d] = s.gammadot; break;}
+                case 2: {x[d] = s.sigma; break;}
+                case 3: {x[d] = s.V; break;}
+                case 4: {x[d] = s.z; break;}
+                case 5: {x[d] = thermal.distance(s); break;}
+                default: {x[d] = thermal.heading(s);}
+            }
+        }
+    }
+
+    /** @brief Indice of an action for the tile coding: 0 = increase sigma; 1 = decrease sigma; 2 = keep sigma */
+    static unsigned int action_indice(const beeler_glider_command &a) {
+        return (a.dsigma > 0.) ? 0 : ((a.dsigma < 0.) ? 1 : 2);
+    }
+
+    /** @brief Action of an indice, see 'action_indice' */
+    beeler_glider_command indice_action(unsigned int i) const {
+        return beeler_glider_command(0.,0.,(i == 0) ? +angle_rate_magnitude : ((i == 1) ? -angle_rate_magnitude : 0.));
     }
 
     /**
@@ -68,30 +313,33 @@ public:
         return 2. * sigmoid(x,x_max,0.) - 1.;
     }
 
+    /**
+     * @brief Set the base features of a state
+     * @param {const beeler_glider_state &} s; state
+     * @param {T &} phi; feature vector or lane of a batch, its 4 first entries are set
+     */
+    template <class T>
+    void set_state_features(const beeler_glider_state &s, T &phi) const {
+        phi[0] = 1.;
+        phi[1] = s.zdot/20.;//scale(s.zdot,10.),
+        phi[2] = s.gammadot/.1;//scale(s.gammadot,.2),
+        phi[3] = s.sigma/s.max_angle_magnitude;//scale(s.sigma,s.max_angle_magnitude),
+    }
+
     /**
      * @brief Evaluate the feature vector at (s, a)
      * @param {const beeler_glider_state &} s; state
      * @param {const beeler_glider_command &} a; action
-     * @return {std::vector<double>} feature vector
+     * @param {feature_map::vector_type &} phi; feature vector
      */
-    std::vector<double> get_feature_vector(
+    void get_feature_vector(
         const beeler_glider_state &s,
-        const beeler_glider_command &a)
+        const beeler_glider_command &a,
+        feature_map::vector_type &phi) const
     {
-        std::vector<double> phi = {
-            1.,
-            s.zdot/20.,//scale(s.zdot,10.),
-            s.gammadot/.1,//scale(s.gammadot,.2),
-            s.sigma/s.max_angle_magnitude,//scale(s.sigma,s.max_angle_magnitude),
-            a.dsigma / angle_rate_magnitude
-        };
-        unsigned int sz = phi.size();
-        for(unsigned int i=1; i<sz; ++i) {
-            for(unsigned int j=i; j<sz; ++j) {
-                phi.push_back(phi[i]*phi[j]);
-            }
-        }
-        return phi;
+        set_state_features(s,phi);
+        phi[4] = a.dsigma / angle_rate_magnitude;
+        feature_map::expand(phi);
     }
 
     /**
@@ -100,34 +348,101 @@ public:
      * @param {const beeler_glider_command &} a; command input
      * @return {double} Q value
      */
-    double q_value(const beeler_glider_state &s, const beeler_glider_command &a)
+    double q_value(const beeler_glider_state &s, const beeler_glider_command &a) const
     {
-        double score = 0.;
-        std::vector<double> phi = get_feature_vector(s,a);
-        for(unsigned int i=0; i<phi.size(); ++i) {
-            score += phi.at(i) * parameters.at(i);
+        if(approximator == 1) {
+            tile_input_type x;
+            get_tile_input(s,x);
+            return tiles.value(x.data(),action_indice(a));
         }
-        return score;
+        feature_map::vector_type phi;
+        get_feature_vector(s,a,phi);
+        return feature_map::dot(parameters,phi);
+    }
+
+    /**
+     * @brief Evaluate the Q function for several actions at once
+     *
+     * The feature vectors are computed lane-wise, the state features being set once.
+     * @param {const beeler_glider_state &} s; state input
+     * @param {const actions_type &} aa; actions
+     * @param {unsigned int} nb_actions; number of actions in aa
+     * @param {std::array<double, max_nb_actions> &} scores; Q values of the actions
+     */
+    void q_values(
+        const beeler_glider_state &s,
+        const actions_type &aa,
+        unsigned int nb_actions,
+        std::array<double, max_nb_actions> &scores) const
+    {
+        if(approximator == 1) { // the tiles of the state are hashed once
+            tile_input_type x;
+            tile_coder::hashes_type h;
+            get_tile_input(s,x);
+            tiles.tiling_hashes(x.data(),h);
+            for(unsigned int l=0; l<nb_actions; ++l) {
+                scores[l] = tiles.value(h,action_indice(aa[l]));
+            }
+            return;
+        }
+        feature_map::batch_type<max_nb_actions> phi;
+        std::array<double, 4> base;
+        set_state_features(s,base);
+        for(unsigned int k=0; k<4; ++k) {
+            phi[k].fill(base[k]);
+        }
+        for(unsigned int l=0; l<max_nb_actions; ++l) {
+            phi[4][l] = (l < nb_actions) ? aa[l].dsigma / angle_rate_magnitude : 0.;
+        }
+        feature_map::expand<max_nb_actions>(phi);
+        feature_map::dot<max_nb_actions>(parameters,phi,scores);
     }
 
     /**
      * @brief Get the available actions from the current state
      * @param {const beeler_glider_state &} s; state
-     * @return {std::vector<beeler_glider_command>} vector of the available actions
+     * @param {actions_type &} aa; available actions
+     * @return {unsigned int} number of available actions
      */
-    std::vector<beeler_glider_command> get_avail_actions(const beeler_glider_state &s)
+    unsigned int get_avail_actions(const beeler_glider_state &s, actions_type &aa) const
     {
-        std::vector<beeler_glider_command> v;
+        unsigned int n = 0;
         double sig = s.sigma;
         double mam = s.max_angle_magnitude;
         if(is_less_than(sig+angle_rate_magnitude, +mam)) {
-            v.push_back(beeler_glider_command(0.,0.,+angle_rate_magnitude));
+            aa[n++] = beeler_glider_command(0.,0.,+angle_rate_magnitude);
         }
         if(is_less_than(-mam, sig-angle_rate_magnitude)) {
-            v.push_back(beeler_glider_command(0.,0.,-angle_rate_magnitude));
+            aa[n++] = beeler_glider_command(0.,0.,-angle_rate_magnitude);
+        }
+        aa[n++] = beeler_glider_command(0.,0.,0.);
+        return n;
+    }
+
+    /**
+     * @brief Split the actions into the ones of maximum score and the others
+     * @param {const std::array<double, max_nb_actions> &} scores; scores of the actions
+     * @param {unsigned int} n; number of actions
+     * @param {std::array<unsigned int, max_nb_actions> &} max_ind; indices of the actions of maximum score
+     * @param {unsigned int &} nb_max; number of actions of maximum score
+     * @param {std::array<unsigned int, max_nb_actions> &} non_max_ind; indices of the other actions
+     * @param {unsigned int &} nb_non_max; number of other actions
+     */
+    static void sort_indices(
+        const std::array<double, max_nb_actions> &scores,
+        unsigned int n,
+        std::array<unsigned int, max_nb_actions> &max_ind,
+        unsigned int &nb_max,
+        std::array<unsigned int, max_nb_actions> &non_max_ind,
+        unsigned int &nb_non_max)
+    {
+        double maxval = *std::max_element(scores.begin(),scores.begin()+n);
+        nb_max = 0;
+        nb_non_max = 0;
+        for(unsigned int j=0; j<n; ++j) {
+            if(is_less_than(scores[j],maxval)) {non_max_ind[nb_non_max++] = j;}
+            else {max_ind[nb_max++] = j;}
         }
-        v.push_back(beeler_glider_command(0.,0.,0.));
-        return v;
     }
 
     /**
@@ -137,26 +452,23 @@ public:
      */
     void epsilon_greedy_policy(const beeler_glider_state &s, beeler_glider_command &a)
     {
-        unsigned seed = std::chrono::system_clock::now().time_since_epoch().count();
-        std::default_random_engine generator(seed);
         std::uniform_real_distribution<double> distribution(0.,1.);
 
-        std::vector<beeler_glider_command> aa = get_avail_actions(s);
-        std::vector<unsigned int> max_ind, non_max_ind;
-        std::vector<double> scores;
-
-        for(auto &action : aa) {
-            scores.push_back(q_value(s,action));
-        }
-        sort_indices(scores,max_ind,non_max_ind);
+        actions_type aa;
+        std::array<double, max_nb_actions> scores;
+        std::array<unsigned int, max_nb_actions> max_ind, non_max_ind;
+        unsigned int nb_max = 0, nb_non_max = 0;
+        unsigned int n = get_avail_actions(s,aa);
+        q_values(s,aa,n,scores);
+        sort_indices(scores,n,max_ind,nb_max,non_max_ind,nb_non_max);
 
         if(distribution(generator) > epsilon) { // Greedy action
-            a = aa.at(rand_element(max_ind));
+            a = aa[max_ind[rand_indice(nb_max)]];
         } else { // Random action
-            if(non_max_ind.size() == 0) { // scores are all the same
-                a = aa.at(rand_element(max_ind));
+            if(nb_non_max == 0) { // scores are all the same
+                a = aa[max_ind[rand_indice(nb_max)]];
             } else {
-                a = aa.at(rand_element(non_max_ind));
+                a = aa[non_max_ind[rand_indice(nb_non_max)]];
             }
         }
     }
@@ -169,15 +481,19 @@ public:
      */
     void greedy_policy(const beeler_glider_state &s, beeler_glider_command &a)
     {
-        std::vector<beeler_glider_command> aa = get_avail_actions(s);
-        std::vector<unsigned int> max_ind, non_max_ind;
-        std::vector<double> scores;
+        actions_type aa;
+        std::array<double, max_nb_actions> scores;
+        std::array<unsigned int, max_nb_actions> max_ind, non_max_ind;
+        unsigned int nb_max = 0, nb_non_max = 0;
+        unsigned int n = get_avail_actions(s,aa);
+        q_values(s,aa,n,scores);
+        sort_indices(scores,n,max_ind,nb_max,non_max_ind,nb_non_max);
+        a = aa[max_ind[rand_indice(nb_max)]];
+    }
 
-        for(unsigned int i=0; i<aa.size(); ++i) {
-            scores.push_back(q_value(s,aa.at(i)));
-        }
-        sort_indices(scores,max_ind,non_max_ind);
-        a = aa.at(rand_element(max_ind));
+    /** @brief Uniformly distributed indice in [0, n), drawn with the pilot's generator */
+    unsigned int rand_indice(unsigned int n) {
+        return std::uniform_int_distribution<unsigned int>(0,n-1)(generator);
     }
 
     /**
@@ -209,10 +525,59 @@ public:
         const beeler_glider_command &a,
         const double delta)
     {
-        std::vector<double> phi = get_feature_vector(s,a);
+        if(approximator == 1) { // the learning rate is shared by the active tiles
+            assert(shared == nullptr);
+            tile_input_type x;
+            get_tile_input(s,x);
+            tiles.update(x.data(),action_indice(a),lr * delta / tiles.nb_tilings);
+            ++nb_updates;
+            return;
+        }
+        feature_map::vector_type phi;
+        get_feature_vector(s,a,phi);
         for (unsigned int i=0; i<parameters.size(); ++i) {
-            parameters.at(i) += lr * delta * phi.at(i);
+            parameters[i] += lr * delta * phi[i];
+            if(shared) {shared->add(i,lr * delta * phi[i]);}
         }
+        ++nb_updates;
+    }
+
+    /** @brief Maximum Q value over the available actions of a state */
+    double max_q_value(const beeler_glider_state &s) const {
+        actions_type aa;
+        std::array<double, max_nb_actions> scores;
+        unsigned int n = get_avail_actions(s,aa);
+        q_values(s,aa,n,scores);
+        return *std::max_element(scores.begin(),scores.begin()+n);
+    }
+
+    /**
+     * @brief Learn from a minibatch of replayed transitions
+     *
+     * The temporal difference errors of the minibatch are computed with the same parameters, then
+     * the updates are applied weighted by the importance-sampling weights and the priorities of
+     * the transitions are set to the magnitudes of their errors.
+     */
+    void replay_update() {
+        replay.sample(generator,replay_batch_size,replay_indices.data(),replay_weights.data());
+        beeler_glider_state s, s_p;
+        for(unsigned int k=0; k<replay_batch_size; ++k) {
+            const q_transition &tr = replay[replay_indices[k]];
+            tr.s.unpack(s);
+            tr.s_p.unpack(s_p);
+            replay_errors[k] = tr.reward + df * max_q_value(s_p) - q_value(s,indice_action(tr.action));
+        }
+        for(unsigned int k=0; k<replay_batch_size; ++k) {
+            const q_transition &tr = replay[replay_indices[k]];
+            tr.s.unpack(s);
+            update_parameters(s,indice_action(tr.action),replay_weights[k] * replay_errors[k]);
+            replay.update_priority(replay_indices[k],replay_errors[k]);
+        }
+    }
+
+    /** @brief Start a new episode, the next step has no previous transition to learn from */
+    void begin_episode() {
+        prev_valid = false;
     }
 
     /**
@@ -228,15 +593,30 @@ public:
         beeler_glider_command a_off_policy;
         double reward = 0.;
 
-        get_reward(prev_s, prev_a, s, reward); // r(s, a, s_p)
-        greedy_policy(s, a_off_policy);
-        double delta = reward + df * q_value(s, a_off_policy) - q_value(prev_s, prev_a);
-        update_parameters(prev_s, prev_a, delta);
+        if(shared) {shared->load(parameters);} // latest shared parameters
+        thermal.update(s);
+        if(prev_valid) {
+            get_reward(prev_s, prev_a, s, reward); // r(s, a, s_p)
+            if(replay.capacity() > 0) {
+                q_transition tr;
+                tr.s.pack(prev_s);
+                tr.s_p.pack(s);
+                tr.reward = reward;
+                tr.action = action_indice(prev_a);
+                replay.push(tr);
+                if(replay_batch_size > 0) {replay_update();}
+            } else {
+                greedy_policy(s, a_off_policy);
+                double delta = reward + df * q_value(s, a_off_policy) - q_value(prev_s, prev_a);
+                update_parameters(prev_s, prev_a, delta);
+            }
+        }
 
         epsilon_greedy_policy(s, a);
         a.dalpha = kdalpha * (0. - s.gammadot);
         prev_s = s;
         prev_a = a;
+        prev_valid = true;
 
 		return *this;
 	}
@@ -278,6 +658,80 @@ public:
         }
 		return *this;
     }
+
+    /**
+     * @brief Write the learned parameters
+     *
+     * Payload: name; approximator (uint32); quadratic weights or tile coding variables (uint32
+     * each), tile widths, number of tilings (uint32) and weight table; thermal estimate (3 doubles).
+     * @param {std::ostream &} os; binary output stream
+     */
+    void save_parameters(std::ostream &os) const override {
+        write_name(os,"q_learning_pilot");
+        write_binary(os,(std::uint32_t) approximator);
+        if(approximator == 1) {
+            std::vector<std::uint32_t> vars(tile_variables.begin(),tile_variables.end());
+            write_binary(os,vars.data(),(std::uint32_t) vars.size());
+            write_binary(os,tiles.widths.data(),(std::uint32_t) tiles.widths.size());
+            write_binary(os,(std::uint32_t) tiles.nb_tilings);
+            write_binary(os,tiles.weights.data(),(std::uint32_t) tiles.weights.size());
+        } else {
+            write_binary(os,parameters.data(),(std::uint32_t) parameters.size());
+        }
+        write_binary(os,thermal.sw);
+        write_binary(os,thermal.sx);
+        write_binary(os,thermal.sy);
+    }
+
+    /**
+     * @brief Read the learned parameters written by 'save_parameters'
+     * @param {std::istream &} is; binary input stream
+     * @throw std::runtime_error if the approximator or its configuration differ from the pilot's, or at the end of the stream; the pilot is then unchanged
+     */
+    void load_parameters(std::istream &is) override {
+        read_name(is,"q_learning_pilot");
+        std::uint32_t apx = 0, nb_tilings = 0;
+        read_binary(is,apx);
+        if(apx != approximator) {
+            throw std::runtime_error("q_learning_pilot: parameters of approximator " + std::to_string(apx)
+                + " found, approximator " + std::to_string(approximator) + " expected");
+        }
+        if(approximator == 1) {
+            std::vector<std::uint32_t> vars(tile_variables.size());
+            std::vector<double> widths(tiles.widths.size());
+            read_binary(is,vars.data(),(std::uint32_t) vars.size());
+            read_binary(is,widths.data(),(std::uint32_t) widths.size());
+            read_binary(is,nb_tilings);
+            if(!std::equal(vars.begin(),vars.end(),tile_variables.begin()) || widths != tiles.widths || nb_tilings != tiles.nb_tilings) {
+                throw std::runtime_error("q_learning_pilot: parameters of another tile coding found");
+            }
+        }
+        std::vector<double> weights(approximator == 1 ? tiles.weights.size() : 0); // the pilot is modified once the whole payload is read
+        parameters_type params;
+        double sw = 0., sx = 0., sy = 0.;
+        if(approximator == 1) {
+            read_binary(is,weights.data(),(std::uint32_t) weights.size());
+        } else {
+            read_binary(is,params.data(),(std::uint32_t) params.size());
+        }
+        read_binary(is,sw);
+        read_binary(is,sx);
+        read_binary(is,sy);
+        if(approximator == 1) {
+            tiles.weights.swap(weights);
+        } else {
+            parameters = params;
+            if(shared) {shared->store(parameters);}
+        }
+        thermal.sw = sw;
+        thermal.sx = sx;
+        thermal.sy = sy;
+    }
+
+protected:
+    std::vector<unsigned int> replay_indices; ///< Sampled transitions of the minibatch
+    std::vector<double> replay_weights; ///< Importance-sampling weights of the minibatch
+    std::vector<double> replay_errors; ///< Temporal difference errors of the minibatch
 };
 
 }
@@ -0,0 +1,195 @@
+#ifndef L2FSIM_Q_LEARNING_TRAINER_HPP_
+#define L2FSIM_Q_LEARNING_TRAINER_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <simulation.hpp>
+#include <save.hpp>
+#include <q_learning/q_learning_pilot.hpp>
+
+/**
+ * @file q_learning_trainer.hpp
+ * @brief Parallel training of 'q_learning_pilot' on several simulations (Hogwild)
+ * @version 1.0
+ * @since 1.1
+ * @note compile with '-pthread'
+ *
+ * Each worker thread runs its own 'simulation' whose pilot is a copy of a prototype
+ * 'q_learning_pilot'. The actors read and update a single 'q_shared_parameters' vector without
+ * locks, hence the number of learned transitions per second grows with the number of cores.
+ * The simulations are set up by a user-provided function called at the beginning of each episode,
+ * which must (re)set the aircraft and the stepper, and the flight zone if it is null (it may be
+ * kept from one episode to the next). An episode ends after 'episode_duration' of simulated time
+ * or when the stepper signals the end of the simulation.
+ * The parameters are periodically appended to a snapshot file as a line
+ * 'elapsed_time nb_transitions w_0 ... w_n'.
+ * Only the quadratic features are shared ('approximator == 0'), a tile coding prototype is rejected.
+ */
+
+namespace L2Fsim {
+
+class q_learning_trainer {
+public:
+    typedef q_learning_pilot::parameters_type parameters_type;
+    typedef q_learning_pilot::shared_parameters_type shared_parameters_type;
+
+    /**
+     * @brief Function setting up the simulation of a worker for a new episode
+     * @param {simulation &} sim; simulation of the worker, its pilot is set by the trainer
+     * @param {unsigned int} worker; indice of the worker
+     * @param {unsigned int} episode; indice of the episode of the worker
+     */
+    typedef std::function<void(simulation &, unsigned int, unsigned int)> episode_setup;
+
+    /**
+     * @brief Attributes
+     * @param {q_learning_pilot} prototype; pilot copied by the workers, its parameters initialize the shared vector
+     * @param {episode_setup} setup; set up of the simulations
+     * @param {unsigned int} nb_workers; number of simulations run concurrently
+     * @param {double} time_step_width; time step of the simulations (s)
+     * @param {double} episode_duration; simulated duration of an episode (s)
+     * @param {std::string} snapshot_path; file receiving the snapshots, no snapshot if empty
+     * @param {double} snapshot_period; wall-clock time between two snapshots (s)
+     * @param {shared_parameters_type} parameters; parameters shared by the workers
+     * @param {unsigned long} nb_transitions; number of learned transitions of the last training
+     * @param {unsigned int} nb_episodes; number of started episodes of the last training
+     * @param {double} elapsed_time; wall-clock duration of the last training (s)
+     */
+    q_learning_pilot prototype;
+    episode_setup setup;
+    unsigned int nb_workers;
+    double time_step_width;
+    double episode_duration;
+    std::string snapshot_path;
+    double snapshot_period;
+    shared_parameters_type parameters;
+    unsigned long nb_transitions;
+    unsigned int nb_episodes;
+    double elapsed_time;
+
+    /**
+     * @brief Constructor
+     * @throw std::invalid_argument if the prototype does not use the quadratic features
+     */
+    q_learning_trainer(
+        const q_learning_pilot &_prototype,
+        episode_setup _setup,
+        unsigned int _nb_workers=1,
+        double _time_step_width=.1,
+        double _episode_duration=1e3,
+        std::string _snapshot_path="",
+        double _snapshot_period=10.) :
+        prototype(_prototype),
+        setup(_setup),
+        nb_workers(std::max(1u,_nb_workers)),
+        time_step_width(_time_step_width),
+        episode_duration(_episode_duration),
+        snapshot_path(_snapshot_path),
+        snapshot_period(_snapshot_period),
+        nb_transitions(0),
+        nb_episodes(0),
+        elapsed_time(0.)
+    {
+        if(prototype.approximator != 0) {
+            throw std::invalid_argument("q_learning_trainer: only the quadratic features (approximator 0) can be shared by the workers");
+        }
+        parameters.store(prototype.parameters);
+    }
+
+    /**
+     * @brief Train the pilots
+     *
+     * Run the workers until the wall-clock duration or the number of learned transitions is
+     * reached, whichever comes first; the calling thread takes the snapshots meanwhile.
+     * @param {double} duration; wall-clock duration of the training (s), 0 for no limit
+     * @param {unsigned long} max_transitions; number of learned transitions, 0 for no limit
+     * @return {double} learned transitions per second
+     */
+    double train(double duration, unsigned long max_transitions=0) {
+        typedef std::chrono::steady_clock clock;
+        std::atomic<bool> stop(false);
+        std::vector<std::atomic<unsigned long>> counts(nb_workers);
+        std::vector<std::atomic<unsigned int>> episodes(nb_workers);
+        for(unsigned int i=0; i<nb_workers; ++i) {
+            counts[i].store(0);
+            episodes[i].store(0);
+        }
+        std::vector<unsigned int> seeds(nb_workers);
+        for(auto &seed : seeds) {seed = prototype.generator();} // before the workers copy the prototype
+        clock::time_point start = clock::now();
+        std::vector<std::thread> workers;
+        for(unsigned int i=0; i<nb_workers; ++i) {
+            workers.emplace_back(&q_learning_trainer::work,this,i,seeds[i],std::ref(stop),std::ref(counts[i]),std::ref(episodes[i]));
+        }
+        double next_snapshot = snapshot_period;
+        while(true) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            double t = std::chrono::duration<double>(clock::now() - start).count();
+            unsigned long n = 0;
+            for(auto &c : counts) {n += c.load(std::memory_order_relaxed);}
+            if(!snapshot_path.empty() && t >= next_snapshot) {
+                save_snapshot(t,n);
+                next_snapshot += snapshot_period;
+            }
+            if((duration > 0. && t >= duration) || (max_transitions > 0 && n >= max_transitions)) {break;}
+        }
+        stop.store(true);
+        for(auto &th : workers) {th.join();}
+        elapsed_time = std::chrono::duration<double>(clock::now() - start).count();
+        nb_transitions = 0;
+        nb_episodes = 0;
+        for(unsigned int i=0; i<nb_workers; ++i) {
+            nb_transitions += counts[i].load();
+            nb_episodes += episodes[i].load();
+        }
+        if(!snapshot_path.empty()) {save_snapshot(elapsed_time,nb_transitions);}
+        return (double) nb_transitions / elapsed_time;
+    }
+
+    /**
+     * @brief Copy the shared parameters into a pilot
+     * @param {q_learning_pilot &} pl; pilot receiving the parameters
+     */
+    void get_parameters(q_learning_pilot &pl) const {
+        parameters.load(pl.parameters);
+    }
+
+protected:
+    /** @brief Loop of a worker, one simulation after the other until the training stops */
+    void work(unsigned int id, unsigned int seed, std::atomic<bool> &stop, std::atomic<unsigned long> &count, std::atomic<unsigned int> &episodes) {
+        simulation sim;
+        q_learning_pilot *pl = new q_learning_pilot(prototype);
+        sim.pl.reset(pl);
+        pl->shared = &parameters;
+        pl->generator.seed(seed);
+        for(unsigned int e=0; !stop.load(std::memory_order_relaxed); ++e) {
+            setup(sim,id,e);
+            pl->begin_episode();
+            episodes.store(e + 1,std::memory_order_relaxed);
+            double t = 0.;
+            bool eos = false;
+            while(!eos && t < episode_duration && !stop.load(std::memory_order_relaxed)) {
+                sim.step(t,time_step_width,eos);
+                count.store(pl->nb_updates,std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void save_snapshot(double t, unsigned long n) const {
+        std::vector<double> v = {t, (double) n};
+        parameters_type p;
+        parameters.load(p);
+        v.insert(v.end(),p.begin(),p.end());
+        save_vector(v,snapshot_path," ",std::ofstream::app);
+    }
+};
+
+}
+
+#endif
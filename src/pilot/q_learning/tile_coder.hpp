@@ -0,0 +1,148 @@
+#ifndef L2FSIM_TILE_CODER_HPP_
+#define L2FSIM_TILE_CODER_HPP_
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * @file tile_coder.hpp
+ * @brief Hashed tile coding of a continuous input with a discrete action
+ * @version 1.0
+ * @since 1.1
+ *
+ * The input space is covered by 'nb_tilings' grids of tiles of the given widths, each grid being
+ * offset by a fraction of a tile (along an asymmetric direction, see Sutton and Barto). An input
+ * and an action activate one tile per grid; the tiles are hashed into a weight table of fixed
+ * size (a power of 2), hence the value of an input is the sum of 'nb_tilings' weights and an
+ * update touches these weights only, whatever the number of variables and the table size.
+ * Hash collisions are not resolved, they act as a random sharing of the weights.
+ */
+
+namespace L2Fsim {
+
+class tile_coder {
+public:
+    static constexpr unsigned int max_tilings = 32; ///< Maximum number of tilings
+    static constexpr unsigned int max_table_bits = 30; ///< Maximum size of the weight table, 2^30 weights (8 GB)
+    typedef std::array<std::uint64_t, max_tilings> hashes_type; ///< Hash of the active tile of each tiling, before the action
+
+    /**
+     * @brief Attributes
+     * @param {std::vector<double>} widths; width of the tiles along each variable
+     * @param {unsigned int} nb_tilings; number of tilings, i.e. of active tiles
+     * @param {std::vector<double>} weights; weight table, its size is a power of 2
+     */
+    std::vector<double> widths;
+    unsigned int nb_tilings;
+    std::vector<double> weights;
+
+    /**
+     * @brief Constructor
+     * @param {const std::vector<double> &} _widths; width of the tiles along each variable
+     * @param {unsigned int} _nb_tilings; number of tilings, at most 'max_tilings'
+     * @param {unsigned int} table_bits; the weight table has 2^table_bits entries, at most 2^max_table_bits
+     * @throw std::invalid_argument if nb_tilings is not in [1,max_tilings] or table_bits not in [1,max_table_bits]
+     */
+    tile_coder(
+        const std::vector<double> &_widths=std::vector<double>(),
+        unsigned int _nb_tilings=8,
+        unsigned int table_bits=16) :
+        widths(_widths),
+        nb_tilings(_nb_tilings),
+        weights(std::size_t(1) << checked_table_bits(_nb_tilings,table_bits),0.),
+        mask((std::size_t(1) << table_bits) - 1)
+    {}
+
+    /**
+     * @brief Hash the active tile of each tiling
+     * @param {const double *} x; input, one value per variable
+     * @param {hashes_type &} h; hashes of the active tiles
+     */
+    void tiling_hashes(const double *x, hashes_type &h) const {
+        for(unsigned int i=0; i<nb_tilings; ++i) {
+            std::uint64_t hi = mix(i + 1);
+            for(unsigned int d=0; d<widths.size(); ++d) {
+                double offset = (double) ((i * (2 * d + 1)) % nb_tilings) / (double) nb_tilings;
+                std::int64_t c = (std::int64_t) floor(x[d] / widths[d] + offset);
+                hi = mix(hi ^ (std::uint64_t) c);
+            }
+            h[i] = hi;
+        }
+    }
+
+    /**
+     * @brief Index of the weight of a tile for an action
+     * @param {std::uint64_t} h; hash of the tile
+     * @param {unsigned int} action; indice of the action
+     */
+    std::size_t index(std::uint64_t h, unsigned int action) const {
+        return (std::size_t) mix(h + 0x9e3779b97f4a7c15ULL * (action + 1)) & mask;
+    }
+
+    /**
+     * @brief Value of an input and an action, from the hashes of its tiles
+     * @param {const hashes_type &} h; hashes of the active tiles
+     * @param {unsigned int} action; indice of the action
+     */
+    double value(const hashes_type &h, unsigned int action) const {
+        double v = 0.;
+        for(unsigned int i=0; i<nb_tilings; ++i) {
+            v += weights[index(h[i],action)];
+        }
+        return v;
+    }
+
+    /** @brief Value of an input and an action */
+    double value(const double *x, unsigned int action) const {
+        hashes_type h;
+        tiling_hashes(x,h);
+        return value(h,action);
+    }
+
+    /**
+     * @brief Add a step to the weights of the active tiles of an input and an action
+     * @param {const double *} x; input
+     * @param {unsigned int} action; indice of the action
+     * @param {double} step; increment of each active weight
+     */
+    void update(const double *x, unsigned int action, double step) {
+        hashes_type h;
+        tiling_hashes(x,h);
+        for(unsigned int i=0; i<nb_tilings; ++i) {
+            weights[index(h[i],action)] += step;
+        }
+    }
+
+protected:
+    std::size_t mask;
+
+    /** @brief Check the configuration of a tile coder before the weight table is allocated, return 'table_bits' */
+    static unsigned int checked_table_bits(unsigned int nb_tilings, unsigned int table_bits) {
+        if(nb_tilings < 1 || nb_tilings > max_tilings) {
+            throw std::invalid_argument("tile_coder: the number of tilings must be in [1," + std::to_string(max_tilings) + "]");
+        }
+        if(table_bits < 1 || table_bits > max_table_bits) {
+            throw std::invalid_argument("tile_coder: the table bits must be in [1," + std::to_string(max_table_bits) + "]");
+        }
+        return table_bits;
+    }
+
+    /** @brief 64-bit finalizer of MurmurHash3 */
+    static std::uint64_t mix(std::uint64_t k) {
+        k ^= k >> 33;
+        k *= 0xff51afd7ed558ccdULL;
+        k ^= k >> 33;
+        k *= 0xc4ceb9fe1a85ec53ULL;
+        k ^= k >> 33;
+        return k;
+    }
+};
+
+}
+
+#endif
@@ -1,10 +1,16 @@
-#ifndef CNODE_HPP_
-#define CNODE_HPP_
+#ifndef L2FSIM_CNODE_HPP_
+#define L2FSIM_CNODE_HPP_
 
-class dnode; // forward declaration
+#include <climits>
+
+namespace L2Fsim {
 
 /**
  * @brief Chance node class
+ *
+ * The sampled returns are summarized by their running count, mean and sum of squared deviations
+ * (Welford's algorithm), hence the size of a node does not depend on its number of visits.
+ * The node is stored in a 'uct_tree' and linked to its children with indices.
  */
 template <class ST, class AC>
 class cnode {
@@ -12,26 +18,48 @@ public:
     typedef ST ST_type; ///< State type
     typedef AC AC_type; ///< Action type
 
-    ST s; ///< Labelling state
+    static constexpr unsigned int no_node = UINT_MAX; ///< Index of no node
+
     AC a; ///< Labelling action
-    std::vector<std::unique_ptr<dnode>> children; ///< Child nodes
-    std::vector<double> sampled_returns; ///< Sampled returns
-    //unsigned nvis; ///< Number of visits //TRM?
+    unsigned int nb_visits; ///< Number of sampled returns
+    double mean; ///< Mean of the sampled returns
+    double m2; ///< Sum of the squared deviations of the sampled returns from their mean
+    unsigned int first_child; ///< Index of the first child decision node, the children are linked by 'next_sibling'
+    unsigned int nb_children; ///< Number of child decision nodes, i.e. of distinct sampled states
 
     /**
      * @brief Constructor
      */
-    cnode(
-        ST _s,
-        AC _a) :
-        s(_s),
-        a(_a)
-    {
-        //nvis = 0;//TRM?
+    cnode(AC _a=AC()) :
+        a(_a),
+        nb_visits(0),
+        mean(0.),
+        m2(0.),
+        first_child(no_node),
+        nb_children(0)
+    {}
+
+    /**
+     * @brief Update value
+     *
+     * Account for a new sampled return.
+     * @param {double} q; sampled return
+     */
+    void update(double q) {
+        ++nb_visits;
+        double d = q - mean;
+        mean += d / (double) nb_visits;
+        m2 += d * (q - mean);
     }
 
-    dnode * get_last_child() const {
-        return children.back().get();
+    /**
+     * @brief Get the number of visits
+     *
+     * The number of visits is the number of sampled returns.
+     * @return Return the number of visits of the node.
+     */
+    unsigned int get_nb_visits() const {
+        return nb_visits;
     }
 
     /**
@@ -42,8 +70,20 @@ public:
      * @return Return the value of the node.
      */
     double get_value() const {
-        return (1. / (double) sampled_returns.size()) * std::accumulate(sampled_returns.begin(),sampled_returns.end(),0.0);
+        return mean;
+    }
+
+    /**
+     * @brief Get variance
+     *
+     * Get the unbiased variance of the sampled returns, 0 if there are less than 2 of them.
+     * @return Return the variance of the sampled returns.
+     */
+    double get_variance() const {
+        return (nb_visits > 1) ? m2 / (double) (nb_visits - 1) : 0.;
     }
 };
 
-#endif // CNODE_HPP_
+}
+
+#endif // L2FSIM_CNODE_HPP_
@@ -1,10 +1,17 @@
-#ifndef DNODE_HPP_
-#define DNODE_HPP_
+#ifndef L2FSIM_DNODE_HPP_
+#define L2FSIM_DNODE_HPP_
 
-#include<uct/cnode.hpp>
+#include <cstddef>
+#include <uct/cnode.hpp>
+
+namespace L2Fsim {
 
 /**
  * @brief Decision node class
+ *
+ * The chance nodes of the available actions are allocated together with the decision node in a
+ * 'uct_tree', at indices [first_child, first_child + nb_actions). The first 'nb_children' ones
+ * have been sampled, the others are the untried actions.
  */
 template <class ST, class AC>
 class dnode {
@@ -12,69 +19,33 @@ public:
     typedef ST ST_type; ///< State type
     typedef AC AC_type; ///< Action type
 
-    ST s; ///< Labelling state
-    std::vector<AC> actions; ///< Available actions, iteratively removed
-    cnode * parent; ///< Pointer to parent node
-    std::vector<std::unique_ptr<cnode>> children; ///< Child nodes
-    //unsigned nvis; ///< Number of visits//TRM?
+    static constexpr unsigned int no_node = UINT_MAX; ///< Index of no node
+
+    ST s; ///< Labelling state, first sampled state of its bucket
+    std::size_t key; ///< Hash of the bucket of the labelling state
+    unsigned int parent; ///< Index of the parent chance node
+    unsigned int next_sibling; ///< Index of the next child decision node of the parent
+    unsigned int first_child; ///< Index of the first chance node
+    unsigned int nb_actions; ///< Number of available actions, i.e. of chance nodes
+    unsigned int nb_children; ///< Number of sampled actions
+    unsigned int nb_visits; ///< Number of visits
 
     /**
      * @brief Constructor
      */
     dnode(
-        ST _s,
-        std::vector<AC> _actions,
-        cnode * _parent) :
+        ST _s=ST(),
+        std::size_t _key=0,
+        unsigned int _parent=no_node) :
         s(_s),
-        actions(_actions),
-        parent(_parent)
-    {
-        //nvis = 0;//TRM?
-    }
-
-    /**
-     * @brief Create Child
-     *
-     * Create a child (hence a chance node).
-     * The action of the child is randomly selected.
-     * @return Return the sampled action.
-     * @warning Remove the sampled action from the actions vector.
-     */
-    AC create_child() {
-        unsigned indice = rand_indice(actions);
-        AC sampled_action = actions.at(indice);
-        actions.erase(actions.begin() + indice);
-        children.emplace_back(
-            std::unique_ptr<cnode>(new cnode(s,sampled_action))
-        );
-        return sampled_action;
-    }
-
-    /**
-     * @brief Get children values
-     *
-     * Get an ordered vector containing all the values of the children.
-     * * @return Return the vector containing all the children values.
-     */
-    std::vector<double> get_children_values() const {
-        std::vector<double> children_values;
-        for(auto &c : children) {
-            children_values.emplace_back(c->get_value());
-        }
-        return children_values;
-    }
-
-    /**
-     * @brief Get value
-     *
-     * Get the value of the node.
-     * This is the maximum value of its children.
-     * @return Return the value of the node.
-     */
-    double get_value() const {
-        std::vector<double> children_values = get_children_values();
-        return children.at(argmax(children_values))->get_value();
-    }
+        key(_key),
+        parent(_parent),
+        next_sibling(no_node),
+        first_child(no_node),
+        nb_actions(0),
+        nb_children(0),
+        nb_visits(0)
+    {}
 
     /**
      * @brief Is fully expanded
@@ -84,8 +55,10 @@ public:
      * @return Return a boolean answer to the test.
      */
     bool is_fully_expanded() const {
-        return (actions.size() == 0);
+        return (nb_children == nb_actions);
     }
 };
 
-#endif // DNODE_HPP_
+}
+
+#endif // L2FSIM_DNODE_HPP_
@@ -1,19 +1,46 @@
-#ifndef UCT_HPP_
-#define UCT_HPP_
+#ifndef L2FSIM_UCT_HPP_
+#define L2FSIM_UCT_HPP_
 
-#include<cassert>
-#include<vector>
-#include<memory>
-#include<numeric>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <vector>
+#include <memory>
+#include <random>
+#include <utility>
 
-#include<uct/cnode.hpp>
-#include<uct/dnode.hpp>
-#include<utils.hpp>
+#include <climits>
+#include <anytime.hpp>
+#include <worker_pool.hpp>
+#include <uct/uct_tree.hpp>
+
+namespace L2Fsim {
 
 /**
  * @brief UCT algorithm class
+ *
+ * Generic UCT tree search with decision and chance nodes.
+ * The generative model MD provides:
+ * - 'void state_transition(const ST &s, const AC &a, ST &s_p)';
+ * - 'double reward_function(const ST &s, const AC &a, const ST &s_p)';
+ * - 'bool is_terminal(const ST &s)';
+ * - 'void get_action_space(const ST &s, std::vector<AC> &actions)', the actions are written in a reused vector;
+ * - 'bool are_equal(const ST &s1, const ST &s2)', test whether two sampled states fall in the same bucket, in which case they are merged into the same child of a chance node;
+ * - 'std::size_t hash(const ST &s)', hash of the bucket of a state, consistent with 'are_equal'.
+ * The default policy PL provides 'AC operator()(MD &model, const ST &s, std::mt19937 &gen)'.
+ * Each search has its own model, default policy, random generator and tree, hence several searches
+ * can be run concurrently (see 'uct_pilot.hpp').
+ * The nodes are stored in a 'uct_tree' reused from one decision to the next and keep running
+ * statistics of their returns, hence a search makes no allocation once the tree storage has grown
+ * to its working size and the size of a node does not depend on its number of visits.
+ * With progressive widening ('pw_k > 0'), a chance node visited n times has at most
+ * max(1, pw_k * n^pw_alpha) children; beyond that, an existing child is revisited with a
+ * probability proportional to its number of visits instead of sampling a new transition, which
+ * keeps the tree deep rather than wide with continuous or noisy transitions.
+ * The value of a leaf is the mean of 'nb_rollouts' default policy rollouts, which may be run as a
+ * batch on several threads (leaf parallelization).
  */
-template <class ST, class AC class MD, class PL>
+template <class ST, class AC, class MD, class PL>
 class uct {
 public:
     typedef ST ST_type; ///< State type
@@ -23,64 +50,144 @@ public:
 
     MD model; ///< Generative model
     PL default_policy; ///< Default policy
-    double discount_factor; ///< Discount factor
     double uct_parameter; ///< UCT parameter
-    unsigned budget; ///< Budget ie number of expanded nodes in the tree
-    unsigned global_counter; ///< Global counter of number of visits / nodes expansions
-    unsigned horizon; ///< Horizon for the default policy simulation
+    double discount_factor; ///< Discount factor
+    unsigned int horizon; ///< Horizon for the default policy simulation
+    unsigned int budget; ///< Budget ie maximum number of searches in the tree
+    unsigned int global_counter; ///< Global counter of number of visits / nodes expansions
+    bool stopped_by_deadline; ///< True if the last tree was stopped by its deadline before the budget
+    std::mt19937 generator; ///< Random generator of the search
+    uct_tree<ST,AC> tree; ///< Nodes of the last built tree, the root has index 0
+    std::vector<AC> actions; ///< Buffer of the available actions at a new node
+    double pw_k; ///< Progressive widening coefficient, 0 to disable the widening limit
+    double pw_alpha; ///< Progressive widening exponent, in [0,1]
+    unsigned int nb_rollouts; ///< Number of default policy rollouts averaged at each leaf
+
+    /** @brief Model, default policy and random generator of a rollout thread */
+    struct rollout_context {
+        MD model;
+        PL default_policy;
+        std::mt19937 generator;
+    };
+
+    std::vector<rollout_context> rollout_contexts; ///< One context per rollout thread
+    std::vector<double> rollout_returns; ///< Returns of the last batch of rollouts
+    std::unique_ptr<worker_pool> rollout_pool; ///< Threads running the rollouts of a leaf, null if there is only one
 
     /**
      * @brief Constructor
+     * @param {unsigned int} max_nodes; maximum number of nodes of a tree, 0 for no limit
+     * @param {double} _pw_k; progressive widening coefficient, 0 to disable the widening limit
+     * @param {double} _pw_alpha; progressive widening exponent
+     * @param {unsigned int} _nb_rollouts; number of rollouts averaged at each leaf
+     * @param {unsigned int} nb_rollout_threads; number of threads running the rollouts of a leaf
      */
-    uct(const parameters &p, environment *en) :
-        model(*en),
-        default_policy(p,en)
+    uct(
+        MD _model,
+        PL _default_policy,
+        double _uct_parameter,
+        double _discount_factor,
+        unsigned int _horizon,
+        unsigned int _budget,
+        unsigned int seed=0,
+        unsigned int max_nodes=0,
+        double _pw_k=0.,
+        double _pw_alpha=.5,
+        unsigned int _nb_rollouts=1,
+        unsigned int nb_rollout_threads=1) :
+        model(_model),
+        default_policy(_default_policy),
+        uct_parameter(_uct_parameter),
+        discount_factor(_discount_factor),
+        horizon(_horizon),
+        budget(_budget),
+        global_counter(0),
+        stopped_by_deadline(false),
+        generator(seed),
+        tree(max_nodes),
+        pw_k(_pw_k),
+        pw_alpha(_pw_alpha),
+        nb_rollouts(_nb_rollouts),
+        rollout_returns(_nb_rollouts)
     {
-        // use the specific parameters of the given model
-        model.misstep_probability = p.MODEL_MISSTEP_PROBABILITY;
-        model.state_gaussian_stddev = p.MODEL_STATE_GAUSSIAN_STDDEV;
-        global_counter = 0;
-        uct_parameter = p.UCT_CST;
-        budget = p.TREE_SEARCH_BUDGET;
-        discount_factor = p.DISCOUNT_FACTOR;
-        horizon = p.DEFAULT_POLICY_HORIZON;
+        if(nb_rollouts > 1 && nb_rollout_threads > 1) {
+            for(unsigned int i=0; i<nb_rollout_threads; ++i) {
+                rollout_contexts.push_back(rollout_context{model,default_policy,std::mt19937(generator())});
+            }
+            rollout_pool.reset(new worker_pool(nb_rollout_threads));
+        }
     }
 
     /**
      * @brief Sample return
      *
      * Sample a return with the default policy starting at the input state.
+     * The rollout stops as soon as a terminal state is reached.
+     * @param {MD &} md; generative model
+     * @param {PL &} pl; default policy
+     * @param {std::mt19937 &} gen; random generator
      * @param {ST} s; input state
      * @return Return the sampled return.
      */
-    double sample_return(ST s) {
-        if(model.is_terminal(s)) {
+    double sample_return(MD &md, PL &pl, std::mt19937 &gen, ST s) const {
+        if(md.is_terminal(s)) {
             return 0.;
         }
         double total_return = 0.;
-        AC a = default_policy(s);
-        for(unsigned t=0; t<horizon; ++t) {
-            ST s_p;
-            model.state_transition(s,a,s_p);
-            total_return += pow(discount_factor,(double)t) * model.reward_function(s,a,s_p);
-            if(model.is_terminal(s_p)) {
+        double discount = 1.;
+        ST s_p = s;
+        for(unsigned int t=0; t<horizon; ++t) {
+            AC a = pl(md,s,gen);
+            md.state_transition(s,a,s_p);
+            total_return += discount * md.reward_function(s,a,s_p);
+            if(md.is_terminal(s_p)) {
                 break;
             }
+            discount *= discount_factor;
             s = s_p;
-            a = default_policy(s);
         }
         return total_return;
     }
 
     /**
-     * @brief Update value
+     * @brief Sample return
      *
-     * Update the value of a chance node by stacking a new sampled value.
-     * @param {cnode<ST,AC> *} ptr; pointer to the updated chance node
-     * @param {double} q; new sampled value
+     * Sample a return with the model, default policy and random generator of the search.
+     * @param {ST} s; input state
+     * @return Return the sampled return.
      */
-    void update_value(cnode<ST,AC> * ptr, double q) const {
-        ptr->sampled_returns.push_back(q);
+    double sample_return(const ST &s) {
+        return sample_return(model,default_policy,generator,s);
+    }
+
+    /**
+     * @brief Estimate return
+     *
+     * Average 'nb_rollouts' sampled returns from the input state. The rollouts are run as a batch
+     * on the rollout threads if there are several of them, each thread with its own copy of the
+     * model, default policy and random generator.
+     * @param {const ST &} s; input state
+     * @return Return the mean of the sampled returns.
+     */
+    double estimate_return(const ST &s) {
+        if(nb_rollouts <= 1) {
+            return sample_return(s);
+        }
+        if(rollout_pool) {
+            rollout_pool->run(nb_rollouts,[this,&s](unsigned int i, unsigned int th){
+                rollout_context &ctx = rollout_contexts[th];
+                rollout_returns[i] = sample_return(ctx.model,ctx.default_policy,ctx.generator,s);
+            });
+        } else {
+            for(unsigned int i=0; i<nb_rollouts; ++i) {
+                rollout_returns[i] = sample_return(s);
+            }
+        }
+        double sum = 0.;
+        for(unsigned int i=0; i<nb_rollouts; ++i) {
+            sum += rollout_returns[i];
+        }
+        return sum / (double) nb_rollouts;
     }
 
     /**
@@ -88,55 +195,99 @@ public:
      *
      * Select child of a decision node wrt the UCT tree policy.
      * The node must be fully expanded.
-     * @param {dnode<ST,AC> *} v; decision node
-     * @return Return to the select child, which is a chance node.
+     * @param {unsigned int} v; index of the decision node
+     * @return Return the index of the selected child, which is a chance node.
      */
-    cnode<ST,AC> * select_child(dnode<ST,AC> * v) const {
-        std::vector<double> children_uct_scores;
-        for(auto &c : v->children) {
-            children_uct_scores.emplace_back(
-                c->get_value()
-                + 2 * uct_parameter *
-                sqrt(log((double) global_counter) / ((double) c->sampled_returns.size()))
-            );
+    unsigned int select_child(unsigned int v) const {
+        const dnode<ST,AC> &d = tree.d(v);
+        double log_n = log((double) d.nb_visits);
+        unsigned int best = d.first_child;
+        double best_score = 0.;
+        for(unsigned int c=d.first_child; c<d.first_child+d.nb_children; ++c) {
+            const cnode<ST,AC> &cn = tree.c(c);
+            double score = cn.get_value() + 2. * uct_parameter * sqrt(log_n / ((double) cn.get_nb_visits()));
+            if(c == d.first_child || score > best_score) {
+                best = c;
+                best_score = score;
+            }
         }
-        return v->children.at(argmax(children_uct_scores)).get();
+        return best;
     }
 
     /**
      * @brief Evaluate
      *
-     * Create a new child node to a decision node and sample a return value with the default
+     * Sample an untried action of a decision node and sample a return value with the default
      * policy.
-     * @param {dnode<ST,AC> *} v; pointer to the decision node
+     * @param {unsigned int} v; index of the decision node
      * @return Return the sampled value.
      */
-    double evaluate(dnode<ST,AC> * v) {
-        ST s_p;
-        global_counter++; // a chance node will be created
-        model.state_transition(v->s,v->create_child(),s_p);
-        double q = sample_return(s_p);
-        update_value(v->children.back().get(),q);//TOCHECK that we have to do this
+    double evaluate(unsigned int v) {
+        global_counter++; // a chance node is sampled
+        dnode<ST,AC> &d = tree.d(v);
+        unsigned int c = d.first_child + d.nb_children;
+        unsigned int nb_untried = d.nb_actions - d.nb_children;
+        unsigned int j = c + std::uniform_int_distribution<unsigned int>(0,nb_untried-1)(generator);
+        std::swap(tree.c(c).a,tree.c(j).a);
+        d.nb_children++;
+        const AC &a = tree.c(c).a;
+        ST s_p = d.s;
+        model.state_transition(d.s,a,s_p);
+        double q = model.reward_function(d.s,a,s_p);
+        if(!model.is_terminal(s_p)) {
+            q += discount_factor * estimate_return(s_p);
+        }
+        tree.c(c).update(q);
+        d.nb_visits++;
         return q;
     }
 
     /**
-     * @brief Is state already sampled
+     * @brief Find child
      *
-     * Equality operator.
-     * @param {cnode<ST,AC> *} ptr; pointer to the chance node
-     * @param {ST &} s; sampled state
-     * @param {unsigned &} ind; indice modified to the value of the indice of the existing
-     * decision node with state s if the comparison succeeds.
+     * Find the child of a chance node labelled by a state of the same bucket as a sampled state.
+     * @param {unsigned int} c; index of the chance node
+     * @param {const ST &} s; sampled state
+     * @param {std::size_t} key; hash of the bucket of s
+     * @return Return the index of the decision node, 'no_node' if the bucket was not sampled yet.
      */
-    bool is_state_already_sampled(cnode<ST,AC> * ptr, ST &s, unsigned &ind) const {
-        for(unsigned i=0; i<ptr->children.size(); ++i) {
-            if(s.is_equal_to(ptr->children[i]->s)) {
-                ind = i;
-                return true;
-            }
+    unsigned int find_child(unsigned int c, const ST &s, std::size_t key) const {
+        return tree.find_child(c,key,[this,&s](const ST &s_w){return model.are_equal(s,s_w);});
+    }
+
+    /**
+     * @brief Can widen
+     *
+     * Test whether a new transition may be sampled at a chance node wrt the progressive widening.
+     * @param {unsigned int} c; index of the chance node
+     */
+    bool can_widen(unsigned int c) const {
+        const cnode<ST,AC> &cn = tree.c(c);
+        return pw_k <= 0. || cn.nb_children == 0
+            || (double) cn.nb_children < pw_k * pow((double) cn.nb_visits,pw_alpha);
+    }
+
+    /**
+     * @brief Sample child
+     *
+     * Sample an existing child of a chance node with a probability proportional to its number of
+     * visits plus one. The chance node must have at least one child.
+     * @param {unsigned int} c; index of the chance node
+     * @return Return the index of the sampled decision node.
+     */
+    unsigned int sample_child(unsigned int c) {
+        const cnode<ST,AC> &cn = tree.c(c);
+        unsigned int total = 0;
+        for(unsigned int w=cn.first_child; w!=dnode<ST,AC>::no_node; w=tree.d(w).next_sibling) {
+            total += tree.d(w).nb_visits + 1;
+        }
+        unsigned int x = std::uniform_int_distribution<unsigned int>(0,total-1)(generator);
+        unsigned int w = cn.first_child;
+        while(x >= tree.d(w).nb_visits + 1) {
+            x -= tree.d(w).nb_visits + 1;
+            w = tree.d(w).next_sibling;
         }
-        return false;
+        return w;
     }
 
     /**
@@ -144,92 +295,101 @@ public:
      *
      * Search within the tree, starting from the input decision node.
      * Recursive method.
-     * @param {dnode<ST,AC> *} v; input decision node
+     * @param {unsigned int} v; index of the input decision node
      * @return Return the sampled return at the given decision node
      */
-    double search_tree(dnode<ST,AC> * v) {
-        if(model.is_terminal(v->s)) { // terminal node
+    double search_tree(unsigned int v) {
+        if(model.is_terminal(tree.d(v).s)) { // terminal node
             return 0.;
-        } else if(!v->is_fully_expanded()) { // leaf node, expand it
+        } else if(!tree.d(v).is_fully_expanded()) { // leaf node, expand it
             return evaluate(v);
         } else { // apply UCT tree policy
-            cnode<ST,AC> * ptr = select_child(v);
-            ST s_p;
-            model.state_transition(v->s,ptr->a,s_p);
-            double r = model.reward_function(v->s,ptr->a,s_p);
+            unsigned int c = select_child(v);
             double q = 0.;
-            unsigned ind = 0; // indice of resulting child
-            if(is_state_already_sampled(ptr,s_p,ind)) { // go to node
-                q = r + discount_factor * search_tree(ptr->children.at(ind).get());
-            } else { // leaf node, create a new node
-                ptr->children.emplace_back(std::unique_ptr<dnode<ST,AC>>(new dnode<ST,AC>(s_p,model.get_action_space(s_p),ptr)));
-                q = r + discount_factor * evaluate(ptr->get_last_child());
+            if(!can_widen(c)) { // revisit an existing child
+                unsigned int w = sample_child(c);
+                double r = model.reward_function(tree.d(v).s,tree.c(c).a,tree.d(w).s);
+                q = r + discount_factor * search_tree(w);
+            } else {
+                ST s_p = tree.d(v).s;
+                model.state_transition(tree.d(v).s,tree.c(c).a,s_p);
+                double r = model.reward_function(tree.d(v).s,tree.c(c).a,s_p);
+                std::size_t key = model.hash(s_p);
+                unsigned int w = find_child(c,s_p,key);
+                if(w != dnode<ST,AC>::no_node) { // go to node
+                    q = r + discount_factor * search_tree(w);
+                } else {
+                    model.get_action_space(s_p,actions);
+                    if(tree.can_create(actions.size())) { // leaf node, create a new node
+                        w = tree.create_dnode(s_p,key,actions,c);
+                        q = r + discount_factor * search_tree(w);
+                    } else { // memory cap reached, sample a return without creating a node
+                        q = r + discount_factor * estimate_return(s_p);
+                    }
+                }
             }
-            update_value(ptr,q);
+            tree.c(c).update(q);
+            tree.d(v).nb_visits++;
             return q;
         }
-        /* // Original implementation (slower)
-        if(model.is_terminal(v->s)) { // terminal node
-            return 0.;
-        } else if(v->is_leaf()) { // leaf node, expand it
-            return evaluate(v->s);
-        } else { // apply UCT tree policy
-            cnode<ST,AC><ST,AC> * ptr = select_child(v);
-            ST s_p;
-            model.state_transition(v->s,ptr->a,s_p);
-            double r = model.reward_function(v->s,ptr->a,s_p);
-            ptr->children.emplace_back(std::unique_ptr<dnode<ST,AC>>(new dnode<ST,AC>(s_p,model.get_action_space(s_p),ptr)));
-            double q = r + discount_factor * search_tree(ptr->get_last_child());
-            update_value(ptr,q);
-            return q;
-        }
-        */
     }
 
     /**
      * @brief Build UCT tree
      *
-     * Build a tree at the input root node.
-     * @param {dnode<ST,AC> &} root; reference to the input root node
+     * Build a tree rooted at the input state, the root is the decision node of index 0.
+     * The searches stop after 'budget' of them or when the deadline has passed, at least one
+     * search is made. A budget of 0 means no limit if the deadline is bounded, a single search otherwise.
+     * @param {const ST &} s; root state
+     * @param {const anytime_deadline &} deadline; wall-clock deadline, checked after each search
+     * @return Return the number of searches.
      */
-    void build_uct_tree(dnode<ST,AC> &root) {
-        for(unsigned i=0; i<budget; ++i) {
-            search_tree(&root);
-        }
+    unsigned int build_uct_tree(const ST &s, const anytime_deadline &deadline=anytime_deadline()) {
         global_counter = 0;
+        tree.clear();
+        model.get_action_space(s,actions);
+        assert(actions.size() != 0);
+        tree.create_dnode(s,model.hash(s),actions,cnode<ST,AC>::no_node);
+        unsigned int max_searches = (budget == 0 && deadline.is_bounded()) ? UINT_MAX : std::max(1u,budget);
+        unsigned int i = 0;
+        stopped_by_deadline = false;
+        while(i < max_searches) {
+            search_tree(0);
+            ++i;
+            if(deadline.expired()) {
+                stopped_by_deadline = (i < max_searches);
+                break;
+            }
+        }
+        return i;
     }
 
     /**
      * @brief Argmax value
      *
-     * Get the indice of the child with the maximum value of an input decision node.
-     * @param {const dnode<ST,AC> &} v; input decision node
-     * @return Return the indice of the child with the maximum value
+     * Get the index of the child with the maximum value of an input decision node.
+     * @param {unsigned int} v; index of the input decision node
+     * @return Return the index of the child with the maximum value
      */
-    unsigned argmax_value(const dnode<ST,AC> &v) const {
-        std::vector<double> values;
-        for(auto &ch: v.children) {
-            values.emplace_back(ch->get_value());
+    unsigned int argmax_value(unsigned int v) const {
+        const dnode<ST,AC> &d = tree.d(v);
+        assert(d.nb_children != 0);
+        unsigned int best = d.first_child;
+        for(unsigned int c=d.first_child+1; c<d.first_child+d.nb_children; ++c) {
+            if(tree.c(c).get_value() > tree.c(best).get_value()) {best = c;}
         }
-        return argmax(values);
+        return best;
     }
 
     /**
      * @brief Recommended action
      *
      * Get the recommended action from an input decision node.
-     * @param {const dnode<ST,AC> &} v; input decision node
+     * @param {unsigned int} v; index of the input decision node
      * @return Return the recommended action at the input decision node.
      */
-    AC recommended_action(const dnode<ST,AC> &v) {
-        return v.children.at(argmax_value(v))->a;
-    }
-
-    void test(dnode<ST,AC> &v) const {
-        std::cout << "nb children = " << v.children.size() << std::endl;
-        for(auto &c : v.children) {
-            std::cout << "nb children = " << c->children.size() << std::endl;
-        }
+    AC recommended_action(unsigned int v) const {
+        return tree.c(argmax_value(v)).a;
     }
 
     /**
@@ -240,10 +400,8 @@ public:
      * @return Return the undertaken action at s.
      */
     AC operator()(const ST &s) {
-        dnode<ST,AC> root(s,model.get_action_space(s),nullptr);
-        build_uct_tree(root);
-        test(root);
-        return recommended_action(root);
+        build_uct_tree(s);
+        return recommended_action(0);
     }
 
     /**
@@ -276,4 +434,6 @@ public:
     }
 };
 
-#endif // UCT_HPP_
+}
+
+#endif // L2FSIM_UCT_HPP_
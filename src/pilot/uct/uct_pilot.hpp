@@ -0,0 +1,437 @@
+#ifndef L2FSIM_UCT_PILOT_HPP_
+#define L2FSIM_UCT_PILOT_HPP_
+
+#include <cstdio>
+#include <cstdlib>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <pilot.hpp>
+#include <glider_reward.hpp>
+#include <worker_pool.hpp>
+#include <anytime.hpp>
+#include <uct/uct.hpp>
+#include <flat_thermal_soaring_zone.hpp>
+#include <euler_integrator.hpp>
+#include <beeler_glider/beeler_glider.hpp>
+
+/**
+ * @file uct_pilot.hpp
+ * @brief An online implementation of the UCT algorithm for 'beeler_glider.hpp' model
+ * @version 1.0
+ * @since 1.1
+ * @note compatibility: 'flat_thermal_soaring_zone.hpp'; 'beeler_glider.hpp'; 'beeler_glider_state.hpp'; 'beeler_glider_command.hpp'
+ * @note make use of: 'uct.hpp', the generative model is 'uct_glider_model' and the default policy 'uct_default_policy'
+ * @note with 'nb_threads > 1' the trees are built concurrently from the same root state (root parallelization) and merged at the root
+ * @note with 'nb_rollout_threads > 1' the rollouts of a leaf are run as a batch on several threads (leaf parallelization)
+ * @note with 'time_limit > 0' the searches stop when the wall-clock deadline of the decision has passed (anytime mode), the latency of the decisions is recorded in 'stats'
+ */
+
+namespace L2Fsim{
+
+/**
+ * @brief Generative model of the glider for the UCT algorithm
+ */
+class uct_glider_model {
+public:
+    /**
+     * @brief Attributes
+     * @param {beeler_glider} ac; aircraft model
+     * @param {flight_zone *} fz; atmosphere model, only read, shared by the searches
+     * @param {double} angle_rate_magnitude; magnitude of the increment that one can apply to the angles
+     * @param {double} kdalpha; coefficient for the D controller in alpha
+     * @param {double} time_step_width;
+     * @param {double} sub_time_step_width;
+     * @param {double} position_resolution; size of the buckets of the sampled states along x, y and z, 0 for exact equality
+     * @param {double} speed_resolution; size of the buckets along V, 0 for exact equality
+     * @param {double} angle_resolution; size of the buckets along the angles, 0 for exact equality
+     */
+    beeler_glider ac;
+    flight_zone *fz;
+    double angle_rate_magnitude;
+    double kdalpha;
+    double time_step_width;
+    double sub_time_step_width;
+    double position_resolution;
+    double speed_resolution;
+    double angle_resolution;
+
+    uct_glider_model(
+        beeler_glider &_ac,
+        flight_zone *_fz,
+        double _angle_rate_magnitude,
+        double _kdalpha,
+        double _time_step_width,
+        double _sub_time_step_width,
+        double _position_resolution=0.,
+        double _speed_resolution=0.,
+        double _angle_resolution=0.) :
+        ac(_ac),
+        fz(_fz),
+        angle_rate_magnitude(_angle_rate_magnitude),
+        kdalpha(_kdalpha),
+        time_step_width(_time_step_width),
+        sub_time_step_width(_sub_time_step_width),
+        position_resolution(_position_resolution),
+        speed_resolution(_speed_resolution),
+        angle_resolution(_angle_resolution)
+    {}
+
+    /**
+     * @brief Set the value of dalpha with a D-controller in order to soften the phugoid behaviour
+     * @param {beeler_glider_state &} s; state
+     * @param {beeler_glider_command &} a; modified action
+     */
+    void alpha_d_ctrl(const beeler_glider_state &s, beeler_glider_command &a) const {
+        a.dalpha = kdalpha * (0. - s.gammadot);
+    }
+
+    /**
+     * @brief Get the available actions, given a state
+     * @param {const beeler_glider_state &} s; state
+     * @param {std::vector<beeler_glider_command> &} vect_a; vector of the available actions, overwritten
+     */
+    void get_action_space(const beeler_glider_state &s, std::vector<beeler_glider_command> &vect_a) const {
+        vect_a.clear();
+        double sig = s.sigma;
+        double mam = s.max_angle_magnitude;
+        if(sig+angle_rate_magnitude < +mam) {
+            vect_a.push_back(beeler_glider_command(0.,0.,+angle_rate_magnitude));
+        }
+        if(sig-angle_rate_magnitude > -mam) {
+            vect_a.push_back(beeler_glider_command(0.,0.,-angle_rate_magnitude));
+        }
+        vect_a.push_back(beeler_glider_command(0.,0.,0.));
+        for (auto &action : vect_a) {
+            alpha_d_ctrl(s,action);
+        }
+    }
+
+    /**
+     * @brief Transition function model
+     * @param {const beeler_glider_state &} s; current state
+     * @param {const beeler_glider_command &} a; applied command
+     * @param {beeler_glider_state &} s_p; resulting state
+     */
+    void state_transition(const beeler_glider_state &s, const beeler_glider_command &a, beeler_glider_state &s_p) {
+        ac.set_state(s);
+        ac.set_command(a);
+        double current_time = s.time;
+        euler_integrator::transition_function(ac,*fz,current_time,time_step_width,sub_time_step_width);
+        s_p = ac.s;
+    }
+
+    /**
+     * @brief Reward function model, see 'glider_reward.hpp'
+     * @param {const beeler_glider_state &} s; state
+     * @param {const beeler_glider_command &} a; applied command
+     * @param {const beeler_glider_state &} s_p; resulting state
+     * @return {double} computed instantaneous reward
+     */
+    double reward_function(const beeler_glider_state &s, const beeler_glider_command &a, const beeler_glider_state &s_p) const {
+        (void) s;
+        (void) a;
+        return glider_reward(s_p);
+    }
+
+    /**
+     * @brief Termination criterion: the glider is on the ground or out of the zone
+     * @param {const beeler_glider_state &} s; state
+     */
+    bool is_terminal(const beeler_glider_state &s) const {
+        return !is_greater_than(s.z,0.) || !fz->is_within_fz(s.x,s.y,s.z);
+    }
+
+    /**
+     * @brief Bucket of a value along one dimension
+     * @param {double} v; value
+     * @param {double} resolution; size of the buckets, 0 for one bucket per value
+     * @return {std::int64_t} index of the bucket, the bits of the value if the resolution is 0
+     */
+    static std::int64_t cell(double v, double resolution) {
+        if(resolution > 0.) {
+            return (std::int64_t) floor(v / resolution);
+        }
+        v += 0.; // -0. and +0. share a bucket
+        std::int64_t bits;
+        std::memcpy(&bits,&v,sizeof(bits));
+        return bits;
+    }
+
+    /**
+     * @brief Buckets of a state along its dimensions
+     * @param {const beeler_glider_state &} s; state
+     * @param {std::int64_t *} c; array of size 9 filled with the buckets along x, y, z, V, gamma, khi, alpha, beta and sigma
+     */
+    void cells(const beeler_glider_state &s, std::int64_t *c) const {
+        c[0] = cell(s.x,position_resolution);
+        c[1] = cell(s.y,position_resolution);
+        c[2] = cell(s.z,position_resolution);
+        c[3] = cell(s.V,speed_resolution);
+        c[4] = cell(s.gamma,angle_resolution);
+        c[5] = cell(s.khi,angle_resolution);
+        c[6] = cell(s.alpha,angle_resolution);
+        c[7] = cell(s.beta,angle_resolution);
+        c[8] = cell(s.sigma,angle_resolution);
+    }
+
+    /** @brief Test whether two sampled states fall in the same bucket */
+    bool are_equal(const beeler_glider_state &s1, const beeler_glider_state &s2) const {
+        std::int64_t c1[9], c2[9];
+        cells(s1,c1);
+        cells(s2,c2);
+        return std::equal(c1,c1+9,c2);
+    }
+
+    /** @brief Hash of the bucket of a sampled state */
+    std::size_t hash(const beeler_glider_state &s) const {
+        std::int64_t c[9];
+        cells(s,c);
+        std::uint64_t h = 0xcbf29ce484222325ULL;
+        for(unsigned int i=0; i<9; ++i) {
+            h = (h ^ (std::uint64_t) c[i]) * 0x100000001b3ULL;
+            h ^= h >> 29;
+        }
+        return (std::size_t) h;
+    }
+};
+
+/**
+ * @brief Default policy of the UCT algorithm
+ *
+ * Selector:
+ * 0: random action;
+ * 1: go-straight, the bank angle is brought back to 0;
+ * 2: wind-up, the bank angle is increased in its current direction up to its maximum magnitude.
+ */
+class uct_default_policy {
+public:
+    unsigned int selector; ///< Selected policy
+    std::vector<beeler_glider_command> vect_a; ///< Buffer of the available actions for the random policy
+
+    uct_default_policy(unsigned int _selector=1) : selector(_selector) {}
+
+    beeler_glider_command operator()(uct_glider_model &model, const beeler_glider_state &s, std::mt19937 &gen) {
+        double arm = model.angle_rate_magnitude;
+        double sig = s.sigma;
+        double mam = s.max_angle_magnitude;
+        beeler_glider_command a;
+        switch(selector) {
+            case 0: { // random
+                model.get_action_space(s,vect_a);
+                return vect_a[std::uniform_int_distribution<unsigned int>(0,vect_a.size()-1)(gen)];
+            }
+            case 2: { // wind-up
+                if(!is_less_than(sig,0.)) {
+                    if(sig+arm < mam) {a.dsigma = +arm;}
+                } else {
+                    if(sig-arm > -mam) {a.dsigma = -arm;}
+                }
+                break;
+            }
+            default: { // go-straight
+                if(!is_less_than(sig,arm)) {a.dsigma = -arm;}
+                else if(!is_greater_than(sig,-arm)) {a.dsigma = +arm;}
+            }
+        }
+        model.alpha_d_ctrl(s,a);
+        return a;
+    }
+};
+
+class uct_pilot : public pilot {
+public:
+    typedef uct<beeler_glider_state, beeler_glider_command, uct_glider_model, uct_default_policy> uct_search;
+
+    /**
+     * @brief Attributes
+     * @param {flat_thermal_soaring_zone} fz; atmosphere model
+     * @param {double} angle_rate_magnitude; magnitude of the increment that one can apply to the angles
+     * @param {double} kdalpha; coefficient for the D controller in alpha
+     * @param {std::vector<uct_search>} searches; one search per thread, each with its own model and random generator
+     * @param {worker_pool} pool; threads building the trees
+     * @param {std::vector<beeler_glider_command>} root_actions; actions available at the root of the last decision
+     * @param {std::vector<double>} root_values; mean returns of the root actions, merged over the trees
+     * @param {std::vector<unsigned int>} root_visits; numbers of visits of the root actions, summed over the trees
+     * @param {double} time_limit; wall-clock time allowed per decision (s), 0 for no limit; the searches stop at whichever of the budget or the time limit comes first
+     * @param {std::vector<unsigned int>} nb_searches; number of searches of each tree in the last decision
+     * @param {decision_stats} stats; latency and number of searches (summed over the trees) of the decisions
+     */
+    flat_thermal_soaring_zone fz;
+    double angle_rate_magnitude;
+    double kdalpha;
+    std::vector<uct_search> searches;
+    worker_pool pool;
+    std::vector<beeler_glider_command> root_actions;
+    std::vector<double> root_values;
+    std::vector<unsigned int> root_visits;
+    double time_limit;
+    std::vector<unsigned int> nb_searches;
+    decision_stats stats;
+
+    /**
+     * @brief Constructor
+     * @param {unsigned int} budget; maximum number of searches in each tree, 0 for no limit if 'time_limit > 0'
+     * @param {unsigned int} nb_threads; number of trees built concurrently
+     * @param {unsigned int} max_nodes; maximum number of nodes of each tree, 0 for no limit
+     * @param {double} pw_k; progressive widening coefficient of the chance nodes, 0 to disable the widening limit
+     * @param {double} pw_alpha; progressive widening exponent of the chance nodes
+     * @param {double} position_resolution; size of the buckets of the sampled states along x, y and z, 0 for exact equality
+     * @param {double} speed_resolution; size of the buckets along V, 0 for exact equality
+     * @param {double} angle_resolution; size of the buckets along the angles, 0 for exact equality
+     * @param {unsigned int} nb_rollouts; number of default policy rollouts averaged at each leaf
+     * @param {unsigned int} nb_rollout_threads; number of threads running the rollouts of a leaf, for each tree
+     * @param {double} _time_limit; wall-clock time allowed per decision (s), 0 for no limit
+     */
+    uct_pilot(
+        beeler_glider &_ac,
+        std::string sc_path,
+        std::string envt_cfg_path,
+        double noise_stddev,
+        double _angle_rate_magnitude=.01,
+        double _kdalpha=.01,
+        double uct_parameter=1.,
+        double time_step_width=.1,
+        double sub_time_step_width=.1,
+        double df=.9,
+        unsigned int horizon=100,
+        unsigned int budget=1000,
+        unsigned int default_policy_selector=1,
+        unsigned int nb_threads=1,
+        unsigned int max_nodes=0,
+        double pw_k=0.,
+        double pw_alpha=.5,
+        double position_resolution=0.,
+        double speed_resolution=0.,
+        double angle_resolution=0.,
+        unsigned int nb_rollouts=1,
+        unsigned int nb_rollout_threads=1,
+        double _time_limit=0.) :
+        fz(sc_path,envt_cfg_path,noise_stddev),
+        angle_rate_magnitude(_angle_rate_magnitude),
+        kdalpha(_kdalpha),
+        pool(std::max(1u,nb_threads)),
+        time_limit(_time_limit),
+        nb_searches(pool.size(),0)
+    {
+        std::random_device rd;
+        for(unsigned int i=0; i<pool.size(); ++i) {
+            searches.emplace_back(
+                uct_glider_model(_ac,&fz,angle_rate_magnitude,kdalpha,time_step_width,sub_time_step_width,position_resolution,speed_resolution,angle_resolution),
+                uct_default_policy(default_policy_selector),
+                uct_parameter, df, horizon, budget, rd(), max_nodes, pw_k, pw_alpha, nb_rollouts, nb_rollout_threads);
+        }
+    }
+
+    /**
+     * @brief Tree computation and action selection
+     *
+     * Each search builds its own tree from the current state, the visits and the sampled returns
+     * of the root's children are summed over the trees and the action with the highest mean return
+     * is applied.
+     * @param {state &} _s; reference on the state
+     * @param {command &} _a; reference on the command
+     * @warning dynamic cast of state and action
+     */
+	pilot & operator()(state &_s, command &_a) override {
+        anytime_deadline deadline(time_limit);
+        beeler_glider_state &s0 = dynamic_cast <beeler_glider_state &> (_s);
+        beeler_glider_command &a = dynamic_cast <beeler_glider_command &> (_a);
+        std::vector<beeler_glider_command> &actions = root_actions;
+        searches[0].model.get_action_space(s0,actions);
+        pool.run(searches.size(),[this,&s0,&deadline](unsigned int i, unsigned int th){
+            (void) th;
+            nb_searches[i] = searches[i].build_uct_tree(s0,deadline);
+        });
+        root_values.assign(actions.size(),0.);
+        root_visits.assign(actions.size(),0);
+        for(auto &search : searches) {
+            const dnode<beeler_glider_state,beeler_glider_command> &root = search.tree.d(0);
+            for(unsigned int c=root.first_child; c<root.first_child+root.nb_children; ++c) {
+                const cnode<beeler_glider_state,beeler_glider_command> &cn = search.tree.c(c);
+                for(unsigned int j=0; j<actions.size(); ++j) {
+                    if(are_equal(cn.a,actions[j])) {
+                        root_values[j] += cn.get_value() * cn.get_nb_visits();
+                        root_visits[j] += cn.get_nb_visits();
+                    }
+                }
+            }
+        }
+        unsigned int best = 0;
+        bool found = false;
+        for(unsigned int j=0; j<actions.size(); ++j) {
+            if(root_visits[j] == 0) {continue;}
+            root_values[j] /= (double) root_visits[j];
+            if(!found || root_values[j] > root_values[best]) {
+                best = j;
+                found = true;
+            }
+        }
+        a = found ? actions[best] : beeler_glider_command();
+        searches[0].model.alpha_d_ctrl(s0,a); // D-controller
+        unsigned int total = 0;
+        bool expired = false;
+        for(unsigned int i=0; i<searches.size(); ++i) {
+            total += nb_searches[i];
+            expired = expired || searches[i].stopped_by_deadline;
+        }
+        stats.record(deadline.elapsed(),total,expired);
+        return *this;
+	}
+
+    /**
+     * @brief Print the latency and the number of searches of the decisions
+     * @param {std::ostream &} os; output stream
+     */
+    void print_decision_stats(std::ostream &os) const override {
+        stats.print(os);
+    }
+
+    /** @brief Test whether two commands are the same */
+    static bool are_equal(const beeler_glider_command &a1, const beeler_glider_command &a2) {
+        return a1.dalpha == a2.dalpha && a1.dbeta == a2.dbeta && a1.dsigma == a2.dsigma;
+    }
+
+    /**
+     * @brief Policy for 'out of boundaries' case
+     * @param {state &} s; reference on the state
+     * @param {command &} a; reference on the command
+     */
+    pilot & out_of_boundaries(state &_s, command &_a) override {
+        beeler_glider_state &s = dynamic_cast <beeler_glider_state &> (_s);
+        beeler_glider_command &a = dynamic_cast <beeler_glider_command &> (_a);
+        double ang_max = .4;
+        double x = s.x;
+        double y = s.y;
+        double khi = s.khi;
+        double sigma = s.sigma;
+        double cs = -(x*cos(khi) + y*sin(khi)) / sqrt(x*x + y*y); // cos between heading and origin
+        double th = .8; // threshold to steer back to flat command
+        a.set_to_neutral();
+        if (!is_less_than(sigma,0.) && is_less_than(sigma,ang_max)) {
+            if (is_less_than(cs,th)) {
+                if (is_less_than(sigma+angle_rate_magnitude,ang_max)) {
+                    a.dsigma = +angle_rate_magnitude;
+                }
+            } else {
+                a.dsigma = -angle_rate_magnitude;
+            }
+        } else if (is_less_than(sigma,0.) && is_less_than(-ang_max,sigma)) {
+            if (is_less_than(cs,th)) {
+                if (is_less_than(-ang_max,sigma-angle_rate_magnitude)) {
+                    a.dsigma = -angle_rate_magnitude;
+                }
+            } else {
+                a.dsigma = +angle_rate_magnitude;
+            }
+        }
+		return *this;
+    }
+};
+
+}
+
+#endif
@@ -0,0 +1,162 @@
+#ifndef L2FSIM_UCT_TREE_HPP_
+#define L2FSIM_UCT_TREE_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <uct/cnode.hpp>
+#include <uct/dnode.hpp>
+
+namespace L2Fsim {
+
+/**
+ * @brief Arena of UCT nodes
+ *
+ * The decision and chance nodes of a tree are stored in two vectors and are never deallocated:
+ * clearing the tree is O(1) and the storage is reused by the next tree. The chance nodes of a
+ * decision node are allocated together with it, hence they are contiguous.
+ * The children of the chance nodes are also indexed in an open-addressing hash table keyed by
+ * (chance node, bucket of the sampled state), so that finding the child labelled by a sampled
+ * state does not depend on the number of children. The slots are stamped with the tree they
+ * belong to, hence clearing the table is O(1) as well.
+ * An optional cap on the total number of nodes bounds the memory used by a tree; once it is
+ * reached, the search keeps sampling returns from the frontier without creating nodes.
+ */
+template <class ST, class AC>
+class uct_tree {
+public:
+    /**
+     * @brief Attributes
+     * @param {std::vector<dnode<ST,AC>>} dnodes; storage of the decision nodes
+     * @param {std::vector<cnode<ST,AC>>} cnodes; storage of the chance nodes
+     * @param {unsigned int} nb_dnodes; number of decision nodes in use
+     * @param {unsigned int} nb_cnodes; number of chance nodes in use
+     * @param {unsigned int} max_nodes; maximum number of nodes (decision and chance) of a tree, 0 for no limit
+     */
+    std::vector<dnode<ST,AC>> dnodes;
+    std::vector<cnode<ST,AC>> cnodes;
+    unsigned int nb_dnodes;
+    unsigned int nb_cnodes;
+    unsigned int max_nodes;
+
+    /** @brief Constructor */
+    uct_tree(unsigned int _max_nodes=0) :
+        nb_dnodes(0),
+        nb_cnodes(0),
+        max_nodes(_max_nodes),
+        stamp(1)
+    {}
+
+    /** @brief Remove all the nodes, the storage is kept */
+    void clear() {
+        nb_dnodes = 0;
+        nb_cnodes = 0;
+        if(++stamp == 0) { // wrap-around, invalidate the slots explicitly
+            std::fill(slot_stamps.begin(),slot_stamps.end(),0);
+            stamp = 1;
+        }
+    }
+
+    /** @brief Number of nodes in use */
+    unsigned int size() const {return nb_dnodes + nb_cnodes;}
+
+    /**
+     * @brief Test whether a decision node with the given number of actions can be created
+     * @param {unsigned int} nb_actions; number of available actions at the node
+     */
+    bool can_create(unsigned int nb_actions) const {
+        return max_nodes == 0 || size() + 1 + nb_actions <= max_nodes;
+    }
+
+    /**
+     * @brief Create a decision node and its chance nodes
+     * @param {const ST &} s; labelling state
+     * @param {std::size_t} key; hash of the bucket of s
+     * @param {const std::vector<AC> &} actions; available actions at s
+     * @param {unsigned int} parent; index of the parent chance node, 'no_node' for the root
+     * @return {unsigned int} index of the created decision node
+     * @warning the references on the nodes are invalidated if the storage grows, use indices
+     */
+    unsigned int create_dnode(const ST &s, std::size_t key, const std::vector<AC> &actions, unsigned int parent) {
+        if(nb_dnodes == dnodes.size()) {dnodes.resize(2 * nb_dnodes + 1);}
+        if(2 * (nb_dnodes + 1) > slot_nodes.size()) {rehash(4 * (nb_dnodes + 1));} // load factor below 1/2
+        if(nb_cnodes + actions.size() > cnodes.size()) {cnodes.resize(2 * (nb_cnodes + actions.size()));}
+        unsigned int v = nb_dnodes++;
+        dnode<ST,AC> &d = dnodes[v];
+        d = dnode<ST,AC>(s,key,parent);
+        d.first_child = nb_cnodes;
+        d.nb_actions = actions.size();
+        for(auto &a : actions) {cnodes[nb_cnodes++] = cnode<ST,AC>(a);}
+        if(parent != cnode<ST,AC>::no_node) { // link to the parent's children and index it
+            d.next_sibling = cnodes[parent].first_child;
+            cnodes[parent].first_child = v;
+            cnodes[parent].nb_children++;
+            insert(v);
+        }
+        return v;
+    }
+
+    /**
+     * @brief Find the child of a chance node labelled by a state of a given bucket
+     * @param {unsigned int} c; index of the chance node
+     * @param {std::size_t} key; hash of the bucket
+     * @param {const EQ &} eq; predicate on the labelling state of a candidate, resolves the hash collisions
+     * @return {unsigned int} index of the decision node, 'no_node' if there is none
+     */
+    template <class EQ>
+    unsigned int find_child(unsigned int c, std::size_t key, const EQ &eq) const {
+        if(slot_nodes.size() == 0) {return dnode<ST,AC>::no_node;}
+        std::size_t mask = slot_nodes.size() - 1;
+        for(std::size_t i=slot(c,key)&mask; slot_stamps[i]==stamp; i=(i+1)&mask) {
+            const dnode<ST,AC> &w = dnodes[slot_nodes[i]];
+            if(w.parent == c && w.key == key && eq(w.s)) {
+                return slot_nodes[i];
+            }
+        }
+        return dnode<ST,AC>::no_node;
+    }
+
+    dnode<ST,AC> & d(unsigned int i) {return dnodes[i];}
+    const dnode<ST,AC> & d(unsigned int i) const {return dnodes[i];}
+    cnode<ST,AC> & c(unsigned int i) {return cnodes[i];}
+    const cnode<ST,AC> & c(unsigned int i) const {return cnodes[i];}
+
+protected:
+    std::vector<unsigned int> slot_nodes; ///< Decision node of each slot, the size is a power of 2
+    std::vector<unsigned int> slot_stamps; ///< Tree of each slot, the slot is used if it is 'stamp'
+    unsigned int stamp; ///< Stamp of the current tree
+
+    /** @brief Slot of a (chance node, bucket) pair before probing */
+    static std::size_t slot(unsigned int c, std::size_t key) {
+        std::uint64_t h = (std::uint64_t) key ^ ((std::uint64_t) c * 0x9e3779b97f4a7c15ULL);
+        h ^= h >> 32;
+        h *= 0xd6e8feb86659fd93ULL;
+        h ^= h >> 32;
+        return (std::size_t) h;
+    }
+
+    void insert(unsigned int v) {
+        std::size_t mask = slot_nodes.size() - 1;
+        std::size_t i = slot(dnodes[v].parent,dnodes[v].key) & mask;
+        while(slot_stamps[i] == stamp) {i = (i + 1) & mask;}
+        slot_nodes[i] = v;
+        slot_stamps[i] = stamp;
+    }
+
+    /** @brief Grow the table to at least n slots and index the decision nodes in use again */
+    void rehash(std::size_t n) {
+        std::size_t size = 16;
+        while(size < n) {size *= 2;}
+        slot_nodes.assign(size,0);
+        slot_stamps.assign(size,0);
+        stamp = 1;
+        for(unsigned int v=0; v<nb_dnodes; ++v) {
+            if(dnodes[v].parent != cnode<ST,AC>::no_node) {insert(v);}
+        }
+    }
+};
+
+}
+
+#endif // L2FSIM_UCT_TREE_HPP_
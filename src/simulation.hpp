@@ -11,6 +11,32 @@
 
 namespace L2Fsim {
 
+/**
+ * @brief Observer of the transitions of a simulation
+ *
+ * Interface of the transition recorders (see 'transition_dataset.hpp'), called before and after
+ * each step of a simulation whose 'recorder' is set. A recorder keeps what it needs of the state
+ * before the step, so that the simulation makes no copy of it.
+ */
+class transition_recorder {
+public:
+    virtual ~transition_recorder() = default;
+
+    /**
+     * @brief Start recording a transition
+     * @param {const state &} s; state before the step
+     */
+    virtual void begin_transition(const state &s) = 0;
+
+    /**
+     * @brief Record the transition started by 'begin_transition'
+     * @param {const command &} a; command applied during the step
+     * @param {const state &} s_p; state after the step
+     * @param {bool} eos; the step ended the simulation
+     */
+    virtual void end_transition(const command &a, const state &s_p, bool eos) = 0;
+};
+
 /**
  * @brief Simulation environment
  *
@@ -29,6 +55,7 @@ public:
 	std::unique_ptr<pilot> pl; ///< Unique pointer to a pilot.
 	std::string st_log_path; ///< Log file path.
 	std::string fz_log_path; ///< Log file path.
+	std::unique_ptr<transition_recorder> recorder; ///< Unique pointer to a transition recorder, null if the transitions are not recorded.
 
 	/**
 	 * @brief Stepping function
@@ -39,7 +66,9 @@ public:
      * and must be stopped (e.g. limit of aircraft model validity)
 	 */
 	void step(double &current_time, const double time_step_width, bool &eos) {
+		if(recorder) {recorder->begin_transition(ac->get_state());}
 		(*st)(*fz, *ac, *pl, current_time, time_step_width, eos);
+		if(recorder) {recorder->end_transition(ac->get_command(), ac->get_state(), eos);}
 	}
 
     /**
@@ -0,0 +1,243 @@
+#ifndef L2FSIM_DOPRI5_INTEGRATOR_HPP_
+#define L2FSIM_DOPRI5_INTEGRATOR_HPP_
+
+#include <stepper.hpp>
+#include <algorithm>
+#include <cmath>
+
+/**
+ * @brief Dormand-Prince 5(4) adaptive stepper
+ *
+ * @file dopri5_integrator.hpp
+ * @version 1.0
+ * @since 1.1
+ *
+ * Embedded Runge-Kutta method with local error control and 4th order dense output.
+ * The sub-step width is adapted so that the scaled local error stays below 1: large steps
+ * are taken through smooth glides and small ones inside thermal cores.
+ * @note the command is applied once at the beginning of each time step (which corresponds to the
+ * fixed-step integrators with 'nb_sub_time_step = 1')
+ * @note the sub-step width is kept from one time step to the next one
+ * Reference: Hairer, Norsett and Wanner. Solving Ordinary Differential Equations I. Springer. 1993.
+ */
+
+namespace L2Fsim {
+
+class dopri5_integrator : public stepper {
+public:
+    /**
+     * @brief Attributes
+     *
+     * @param {double} dt; current width of the integration sub-step (adapted)
+     * @param {double} atol, rtol; absolute and relative tolerances of the error control
+     * @param {double} dt_min, dt_max; bounds of the sub-step width
+     * @param {unsigned int} nb_evaluations; number of calls to the dynamics (wind and aero evaluations)
+     * @param {unsigned int} nb_accepted, nb_rejected; number of accepted and rejected sub-steps
+     * @param {std::unique_ptr<state>} k[7]; stages of the last accepted sub-step
+     * @param {std::unique_ptr<state>} y0, y1, tmp; start, end and temporary states of the sub-step
+     * @param {double} t0, h; start time and width of the last accepted sub-step (dense output)
+     */
+    double dt;
+    double atol;
+    double rtol;
+    double dt_min;
+    double dt_max;
+    unsigned int nb_evaluations = 0;
+    unsigned int nb_accepted = 0;
+    unsigned int nb_rejected = 0;
+    std::unique_ptr<state> k[7];
+    std::unique_ptr<state> y0, y1, tmp;
+    double t0 = 0.;
+    double h = 0.;
+
+    /**
+     * @brief Constructor
+     */
+    dopri5_integrator(
+        double _dt=.1,
+        double _atol=1e-6,
+        double _rtol=1e-6,
+        double _dt_min=1e-6,
+        double _dt_max=10.) :
+        dt(_dt),
+        atol(_atol),
+        rtol(_rtol),
+        dt_min(_dt_min),
+        dt_max(_dt_max)
+    {}
+
+    /**
+     * @brief Dense output
+     *
+     * Interpolate the solution within the last accepted sub-step.
+     * @param {const double} t; time in [t0, t0+h]
+     * @param {state &} s; output state (static variables are interpolated)
+     */
+    void interpolate(const double t, state &s) {
+        // Continuous extension coefficients b_i(theta) = sum_j P[i][j] theta^(j+1)
+        static const double P[7][4] = {
+            {1., -8048581381./2820520608., 8663915743./2820520608., -12715105075./11282082432.},
+            {0., 0., 0., 0.},
+            {0., 131558114200./32700410799., -68118460800./10900136933., 87487479700./32700410799.},
+            {0., -1754552775./470086768., 14199869525./1410260304., -10690763975./1880347072.},
+            {0., 127303824393./49829197408., -318862633887./49829197408., 701980252875./199316789632.},
+            {0., -282668133./205662961., 2019193451./616988883., -1453857185./822651844.},
+            {0., 40617522./29380423., -110615467./29380423., 69997945./29380423.}
+        };
+        double th = (h > 0.) ? (t - t0) / h : 0.;
+        s.copy(*y0);
+        s.clear_dynamic();
+        for(unsigned int i=0; i<7; ++i) {
+            double bi = th * (P[i][0] + th * (P[i][1] + th * (P[i][2] + th * P[i][3])));
+            if(bi != 0.) {s.add_to_dynamic(*k[i],bi);}
+        }
+        s.apply_dynamic(h);
+        s.set_time(t);
+    }
+
+    /**
+     * @brief Transition function
+     *
+     * Perform an adaptive transition of width 'time_step_width' given an aircraft model with a
+     * correct state and command and an atmospheric model.
+     * @param {aircraft &} ac; aircraft model
+     * @param {flight_zone &} fz; atmosphere model
+     * @param {double &} current_time; current time
+     * @param {const double} time_step_width; time-step-width
+     * @param {event_locator *} evl; event locator, no event detection if 'nullptr'; the transition stops at the first terminal event, located with the dense output
+     */
+    void transition_function(
+        aircraft &ac,
+        flight_zone &fz,
+        double &current_time,
+        const double time_step_width,
+        event_locator *evl=nullptr)
+    {
+        // Butcher tableau
+        static const double c[7] = {0., 1./5., 3./10., 4./5., 8./9., 1., 1.};
+        static const double a[7][6] = {
+            {0., 0., 0., 0., 0., 0.},
+            {1./5., 0., 0., 0., 0., 0.},
+            {3./40., 9./40., 0., 0., 0., 0.},
+            {44./45., -56./15., 32./9., 0., 0., 0.},
+            {19372./6561., -25360./2187., 64448./6561., -212./729., 0., 0.},
+            {9017./3168., -355./33., 46732./5247., 49./176., -5103./18656., 0.},
+            {35./384., 0., 500./1113., 125./192., -2187./6784., 11./84.}
+        };
+        static const double e[7] = { // b - b*
+            71./57600., 0., -71./16695., 71./1920., -17253./339200., 22./525., -1./40.
+        };
+
+        state &s = ac.get_state();
+        for(auto &ki : k) {reserve_stage(ki,s);}
+        reserve_stage(y0,s);
+        reserve_stage(y1,s);
+        reserve_stage(tmp,s);
+
+        if(evl) {evl->stop = false;}
+        ac.apply_command();
+        const double t_end = current_time + time_step_width;
+        unsigned int first_stage = 0; // 0: evaluate; 1: first same as last, copied from k[6]; 2: still valid
+        while(is_less_than(current_time,t_end,1e-9)) {
+            double hs = std::min(dt,dt_max);
+            bool truncated = false; // the sub-step is shortened to end at the command period
+            if(!is_less_than(hs,t_end-current_time,1e-9)) {
+                hs = t_end - current_time;
+                truncated = true;
+            }
+            y0->copy(s);
+            if(evl) {evl->begin(ac,fz,s);}
+            if(first_stage == 0) {
+                k[0]->copy(*y0);
+                ac.update_state_dynamic(fz,current_time,*k[0]);
+                ++nb_evaluations;
+            } else if(first_stage == 1) {
+                k[0]->copy(*k[6]);
+            }
+            for(unsigned int i=1; i<7; ++i) { // stages, the 7th one is the 5th order solution
+                k[i]->copy(*y0);
+                k[i]->clear_dynamic();
+                for(unsigned int j=0; j<i; ++j) {
+                    if(a[i][j] != 0.) {k[i]->add_to_dynamic(*k[j],a[i][j]);}
+                }
+                k[i]->apply_dynamic(hs);
+                ac.update_state_dynamic(fz,current_time+c[i]*hs,*k[i]);
+                ++nb_evaluations;
+            }
+            y1->copy(*k[6]); // [ y1 , f(t+h,y1) ]
+
+            // Local error estimate
+            tmp->clear_dynamic();
+            for(unsigned int i=0; i<7; ++i) {
+                if(e[i] != 0.) {tmp->add_to_dynamic(*k[i],e[i]);}
+            }
+            double err = tmp->error_norm(*y0,*y1,hs,atol,rtol);
+            if(!std::isfinite(err)) {err = 1e10;} // e.g. wind model evaluated out of its domain
+            double fac = (err > 0.) ? .9 * pow(err,-.2) : 5.;
+
+            if(err <= 1. || hs <= dt_min) { // accepted
+                ++nb_accepted;
+                t0 = current_time;
+                h = hs;
+                s.copy(*y1);
+                if(evl) {
+                    double h_event = hs;
+                    evl->check(ac,fz,s,t0,h_event,
+                        [this](double tau, state &out) {interpolate(t0+tau,out);});
+                    if(evl->stop) { // refresh the rates at the event
+                        current_time += h_event;
+                        s.set_time(current_time);
+                        ac.update_state_dynamic(fz,current_time,s);
+                        ++nb_evaluations;
+                        break;
+                    }
+                }
+                current_time += hs;
+                s.set_time(current_time);
+                first_stage = 1;
+                double dt_new = hs * std::min(5.,fac);
+                dt = std::max(dt_min,truncated ? std::max(dt,dt_new) : dt_new);
+            } else { // rejected, the first stage remains valid
+                ++nb_rejected;
+                first_stage = 2;
+                dt = std::max(dt_min,hs * std::max(.2,fac));
+            }
+        }
+    }
+
+    /**
+     * @brief Stepping operator
+     *
+     * @param {flight_zone &} fz; flight zone
+     * @param {aircraft &} ac; aircraft
+     * @param {pilot &} pl; pilot
+     * @param {double &} current_time; current time
+     * @param {const double} time_step_width; period of time during which we perform integration
+     * @param {bool &} eos; end of simulation, the simulation reached the bounds of its model and must be stopped (e.g. limit of aircraft model validity)
+     */
+    void operator()(
+        flight_zone &fz,
+        aircraft &ac,
+        pilot &pl,
+        double &current_time,
+        const double time_step_width,
+        bool &eos) override
+    {
+        // 1. Apply the policy and store the command into command attribute of aircraft
+        if (!fz.is_within_fz(ac.get_state().getx(),ac.get_state().gety(),ac.get_state().getz())) {
+            pl.out_of_boundaries(ac.get_state(),ac.get_command());
+        } else {
+            pl(ac.get_state(),ac.get_command());
+        }
+
+        // 2. Apply the transition with the adaptive Dormand-Prince method
+        transition_function(ac,fz,current_time,time_step_width,evl.enabled ? &evl : nullptr);
+
+        // 3. Check aircraft's configuration validity
+        if(evl.stop || !ac.is_in_model()){eos=true;}
+    }
+};
+
+}
+
+#endif // L2FSIM_DOPRI5_INTEGRATOR_HPP_
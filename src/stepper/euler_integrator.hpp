@@ -37,23 +37,38 @@ public:
      * @param {double &} current_time; current time
      * @param {const double} time_step_width; time-step-width
      * @param {const double} sdt; sub-time-step-width
+     * @param {event_locator *} evl; event locator, no event detection if 'nullptr'; the transition stops at the first terminal event
      */
     static void transition_function(
         aircraft &ac,
         flight_zone &fz,
         double &current_time,
         const double time_step_width,
-        const double sdt)
+        const double sdt,
+        event_locator *evl=nullptr)
     {
+        if(evl) {evl->stop = false;}
         unsigned int niter = (int)(time_step_width/sdt);
         for(unsigned int n=0; n<niter; ++n) {
             ac.apply_command();
+            state &s = ac.get_state();
+            double h = sdt;
             //// EULER UPDATE
-            ac.update_state_dynamic(fz,current_time,ac.get_state());
-            ac.get_state().apply_dynamic(sdt);
+            ac.update_state_dynamic(fz,current_time,s);
+            if(evl) {evl->begin(ac,fz,s);} // saved start holds its rates
+            s.apply_dynamic(sdt);
             //// END EULER UPDATE
-            current_time += sdt;
-            ac.get_state().set_time(current_time);
+            if(evl) {
+                state &s0 = *evl->start;
+                evl->check(ac,fz,s,current_time,h,
+                    [&s0](double tau, state &out) {
+                        out.copy(s0);
+                        out.apply_dynamic(tau);
+                    });
+            }
+            current_time += h;
+            s.set_time(current_time);
+            if(evl && evl->stop) {break;}
         }
     }
 
@@ -83,10 +98,10 @@ public:
         }
 
         // 2. Apply the transition with Euler method
-        transition_function(ac,fz,current_time,time_step_width,dt);
+        transition_function(ac,fz,current_time,time_step_width,dt,evl.enabled ? &evl : nullptr);
 
         // 3. Check aircraft's configuration validity
-        if(!ac.is_in_model()){eos=true;}
+        if(evl.stop || !ac.is_in_model()){eos=true;}
     }
 };
 
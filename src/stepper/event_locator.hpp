@@ -0,0 +1,184 @@
+#ifndef L2FSIM_EVENT_LOCATOR_HPP_
+#define L2FSIM_EVENT_LOCATOR_HPP_
+
+#include <aircraft.hpp>
+#include <flight_zone.hpp>
+#include <memory>
+#include <typeinfo>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <iostream>
+
+/**
+ * @brief Event location within integration steps
+ *
+ * @file event_locator.hpp
+ * @version 1.0
+ * @since 1.1
+ *
+ * An event is the crossing of zero by an event function. The event functions are the
+ * aircraft's ones (see 'aircraft::event_function', a crossing is terminal) plus the signed
+ * distance to the flight zone boundaries (see 'flight_zone::boundary_distance', a crossing is
+ * recorded but does not stop the simulation).
+ * The crossing times are located with the Illinois variant of the regula falsi method so
+ * that coarse integration steps still report accurate event times.
+ */
+
+namespace L2Fsim {
+
+/**
+ * @brief Located event
+ */
+struct event {
+    std::string name; ///< Name of the event function
+    double time; ///< Located time of the crossing
+    bool terminal; ///< True if the simulation must be stopped
+};
+
+class event_locator {
+public:
+    /**
+     * @brief Attributes
+     * @param {bool} enabled; event detection is performed if true
+     * @param {double} time_tolerance; precision of the located event times
+     * @param {std::vector<event>} events; located events, in chronological order
+     * @param {bool} stop; true if a terminal event was located during the last transition
+     * @param {std::unique_ptr<state>} start, probe; state at the beginning of the sub-step and state buffer for the root-finding
+     * @param {std::vector<double>} g0, g1; values of the event functions at the beginning and at the end of the sub-step
+     */
+    bool enabled;
+    double time_tolerance;
+    std::vector<event> events;
+    bool stop = false;
+    std::unique_ptr<state> start, probe;
+    std::vector<double> g0, g1;
+
+    /** @brief Constructor */
+    event_locator(bool _enabled=false, double _time_tolerance=1e-4) :
+        enabled(_enabled),
+        time_tolerance(_time_tolerance)
+    {}
+
+    /**
+     * @brief Evaluate an event function
+     * @param {aircraft &} ac; aircraft model
+     * @param {flight_zone &} fz; flight zone
+     * @param {unsigned int} i; indice of the event function, the last one is the zone boundary
+     * @param {state &} s; evaluated state
+     */
+    double evaluate(aircraft &ac, flight_zone &fz, unsigned int i, state &s) {
+        if(i < ac.nb_events()) {return ac.event_function(i,s);}
+        return fz.boundary_distance(s.getx(),s.gety(),s.getz());
+    }
+
+    /**
+     * @brief Begin a sub-step
+     *
+     * Save the state at the beginning of the sub-step and evaluate the event functions.
+     * @param {aircraft &} ac; aircraft model
+     * @param {flight_zone &} fz; flight zone
+     * @param {state &} s; state at the beginning of the sub-step
+     */
+    void begin(aircraft &ac, flight_zone &fz, state &s) {
+        if(!start || typeid(*start) != typeid(s)) {
+            start.reset(s.duplicate());
+            probe.reset(s.duplicate());
+        }
+        start->copy(s);
+        unsigned int n = ac.nb_events() + 1;
+        g0.resize(n);
+        g1.resize(n);
+        for(unsigned int i=0; i<n; ++i) {
+            g0[i] = evaluate(ac,fz,i,s);
+        }
+    }
+
+    /**
+     * @brief Check the end of a sub-step
+     *
+     * Detect the sign changes of the event functions and locate them. If a terminal event is
+     * located, the state is set to its value at the event time and the width of the sub-step
+     * is shortened accordingly.
+     * @param {aircraft &} ac; aircraft model
+     * @param {flight_zone &} fz; flight zone
+     * @param {state &} s; state at the end of the sub-step
+     * @param {const double} t0; time at the beginning of the sub-step
+     * @param {double &} h; width of the sub-step, modified if a terminal event is located
+     * @param {F} state_at; function 'void(double tau, state &out)' computing the state at time t0+tau
+     * @return {bool} true if a terminal event is located
+     */
+    template <class F>
+    bool check(aircraft &ac, flight_zone &fz, state &s, const double t0, double &h, F state_at) {
+        unsigned int n = g0.size();
+        unsigned int nac = ac.nb_events();
+        double tau_stop = h;
+        unsigned int i_stop = n;
+        unsigned int first_logged = events.size();
+        for(unsigned int i=0; i<n; ++i) {
+            g1[i] = evaluate(ac,fz,i,s);
+            if((g0[i] > 0.) != (g1[i] > 0.)) {
+                double tau = locate(ac,fz,i,h,state_at);
+                bool terminal = (i < nac) && (g0[i] > 0.);
+                if(terminal && tau < tau_stop) {
+                    tau_stop = tau;
+                    i_stop = i;
+                } else if(!terminal) {
+                    std::string name = (i < nac) ? ac.event_name(i) : "flight zone boundary crossed";
+                    events.push_back(event{name,t0+tau,false});
+                }
+            }
+        }
+        if(i_stop < n) { // discard the non-terminal events occurring after the terminal one
+            unsigned int j = first_logged;
+            for(unsigned int k=first_logged; k<events.size(); ++k) {
+                if(events[k].time <= t0 + tau_stop) {events[j++] = events[k];}
+            }
+            events.resize(j);
+            events.push_back(event{ac.event_name(i_stop),t0+tau_stop,true});
+            std::cout << "STOP: " << ac.event_name(i_stop) << " at t=" << t0+tau_stop << " (s)" << std::endl;
+            state_at(tau_stop,*probe);
+            s.copy(*probe);
+            h = tau_stop;
+            stop = true;
+        }
+        std::sort(events.begin()+first_logged,events.end(),
+            [](const event &a, const event &b) {return a.time < b.time;});
+        return stop;
+    }
+
+protected:
+    /**
+     * @brief Locate the crossing of an event function within the sub-step
+     * @return {double} the crossing time, relative to the beginning of the sub-step; the
+     * returned time lies on the side where the sign has changed
+     */
+    template <class F>
+    double locate(aircraft &ac, flight_zone &fz, unsigned int i, const double h, F &state_at) {
+        double a = 0., b = h;
+        double fa = g0[i], fb = g1[i];
+        int side = 0;
+        for(unsigned int it=0; it<100 && (b-a)>time_tolerance; ++it) {
+            double c = (fa*b - fb*a) / (fa - fb);
+            if(!(a < c && c < b)) {c = .5 * (a + b);} // discontinuous function or degenerate secant
+            state_at(c,*probe);
+            double fc = evaluate(ac,fz,i,*probe);
+            if((fc > 0.) == (fa > 0.)) {
+                a = c;
+                fa = fc;
+                if(side == -1) {fb *= .5;}
+                side = -1;
+            } else {
+                b = c;
+                fb = fc;
+                if(side == +1) {fa *= .5;}
+                side = +1;
+            }
+        }
+        return b;
+    }
+};
+
+}
+
+#endif // L2FSIM_EVENT_LOCATOR_HPP_
@@ -13,20 +13,91 @@
 
 namespace L2Fsim {
 
+/**
+ * @brief RK4 stage storage
+ *
+ * The four intermediate states of a RK4 sub-step. Buffers are allocated once and then
+ * reused for every sub-step.
+ */
+struct rk4_stages {
+    std::unique_ptr<state> s1, s2, s3, s4;
+
+    /**
+     * @brief Reserve the buffers for the type of the input state
+     * @param {const state &} s; integrated state
+     */
+    void reserve(const state &s) {
+        reserve_stage(s1,s);
+        reserve_stage(s2,s);
+        reserve_stage(s3,s);
+        reserve_stage(s4,s);
+    }
+};
+
 class rk4_integrator : public stepper {
 public:
     /**
      * @brief Attributes
      *
      * @param {double} dt; width of the integration sub-step
+     * @param {rk4_stages} stages; stage storage reused at each sub-step
      */
     double dt;
+    rk4_stages stages;
 
 	/**
 	 * @brief Constructor
 	 */
 	rk4_integrator(double _dt=.01) : dt(_dt) {}
 
+    /**
+     * @brief RK4 sub-step
+     *
+     * Integrate the input state over a sub-step, the command being already applied.
+     * @param {aircraft &} ac; aircraft model
+     * @param {flight_zone &} fz; atmosphere model
+     * @param {const double} t; time at the beginning of the sub-step
+     * @param {const double} sdt; sub-time-step-width
+     * @param {state &} s; integrated state
+     * @param {rk4_stages &} stg; reserved stage storage
+     */
+    static void step(
+        aircraft &ac,
+        flight_zone &fz,
+        const double t,
+        const double sdt,
+        state &s,
+        rk4_stages &stg)
+    {
+        state &s1 = *stg.s1;
+        state &s2 = *stg.s2;
+        state &s3 = *stg.s3;
+        state &s4 = *stg.s4;
+        s1.copy(s); // s1: [ x1 , . ] with x1=x static variables at time t
+        ac.update_state_dynamic(fz,t,s1); // s1: [ x1 , k1 ] with k1=f(t,x1)
+
+        s2.copy(s1); // s2: [ x1, k1 ]
+        s2.apply_dynamic(.5*sdt); // s2: [ x2 , k1 ] with x2=s1+.5*sdt*k1
+        ac.update_state_dynamic(fz,t+.5*sdt,s2); // s2: [ x2 , k2 ] with k2=f(t+.5*sdt,x(t)+.5*sdt*k1)
+
+        s3.copy(s1); // s3: [ x1 , k1 ]
+        s3.set_dynamic(s2); // s3: [ x1 , k2 ]
+        s3.apply_dynamic(.5*sdt); // s3: [ x3 , k2 ] with x3=x1+.5*sdt*k2
+        ac.update_state_dynamic(fz,t+.5*sdt,s3); // s3: [ x3 , k3 ] with k3=f(t+.5*sdt,x(t)+.5*sdt*k2)
+
+        s4.copy(s1); // s4: [ x1 , k1 ]
+        s4.set_dynamic(s3); // s4: [ x1 , k3 ]
+        s4.apply_dynamic(sdt); // s4: [ x4 , k3 ] with x4=x1+sdt*k3
+        ac.update_state_dynamic(fz,t+sdt,s4); // s4: [ x4 , k4 ] with k4=f(t+sdt,x(t)+sdt*k3)
+
+        s.clear_dynamic(); // s: [ x , 0 ]
+        s.add_to_dynamic(s1,1./6.); // s: [ x , k1/6 ]
+        s.add_to_dynamic(s2,1./3.); // s: [ x , (k1 + 2*k2)/6 ]
+        s.add_to_dynamic(s3,1./3.); // s: [ x , (k1 + 2*k2 + 2*k3)/6 ]
+        s.add_to_dynamic(s4,1./6.); // s: [ x , xdot ] with xdot = (k1 + 2*k2 + 2*k3 + k4)/6
+        s.apply_dynamic(sdt); // s: [ x + sdt*xdot , xdot ]
+    }
+
     /**
      * @brief Transition function
      *
@@ -37,53 +108,63 @@ public:
      * @param {double &} current_time; current time
      * @param {const double} time_step_width; time-step-width
      * @param {const double} sdt; sub-time-step-width
+     * @param {rk4_stages &} stg; stage storage, no allocation is performed once reserved
+     * @param {event_locator *} evl; event locator, no event detection if 'nullptr'; the transition stops at the first terminal event
      */
     static void transition_function(
         aircraft &ac,
         flight_zone &fz,
         double &current_time,
         const double time_step_width,
-        const double sdt)
+        const double sdt,
+        rk4_stages &stg,
+        event_locator *evl=nullptr)
     {
+        stg.reserve(ac.get_state());
+        if(evl) {evl->stop = false;}
         unsigned int niter = (int)(time_step_width/sdt);
         for(unsigned int n=0; n<niter; ++n) {
             ac.apply_command();
-            //// RK4 UPDATE
-            ac.get_state().clear_dynamic(); // s: [ x , 0 ]
-
-            state *s1 = ac.get_state().duplicate(); // s1: [ x1 , 0 ] with x1=x static variables at time t
-            ac.update_state_dynamic(fz,current_time,*s1); // s1: [ x1 , k1 ] with k1=f(t,x1)
-
-            state *s2 = s1->duplicate(); // s2: [ x1, k1 ]
-            s2->apply_dynamic(.5*sdt); // s2: [ x2 , k1 ] with x2=s1+.5*sdt*k1
-            ac.update_state_dynamic(fz,current_time+.5*sdt,*s2); // s2: [ x2 , k2 ] with k2=f(t+.5*sdt,x(t)+.5*sdt*k1)
-
-            state *s3 = s1->duplicate(); // s3: [ x1 , k1 ]
-            s3->set_dynamic(*s2); // s3: [ x1 , k2 ]
-            s3->apply_dynamic(.5*sdt); // s3: [ x3 , k2 ] with x3=x1+.5*sdt*k2
-            ac.update_state_dynamic(fz,current_time+.5*sdt,*s3); // s3: [ x3 , k3 ] with k3=f(t+.5*sdt,x(t)+.5*sdt*k2)
-
-            state *s4 = s1->duplicate(); // s4: [ x1 , k1 ]
-            s4->set_dynamic(*s3); // s4: [ x1 , k3 ]
-            s4->apply_dynamic(sdt); // s4: [ x4 , k3 ] with x4=x1+sdt*k3
-            ac.update_state_dynamic(fz,current_time+sdt,*s4); // s4: [ x4 , k4 ] with k4=f(t+sdt,x(t)+sdt*k3)
-
-            ac.get_state().add_to_dynamic(*s1,1.); // s: [ x , k1 ]
-            ac.get_state().add_to_dynamic(*s2,2.); // s: [ x , k1 + 2*k2 ]
-            ac.get_state().add_to_dynamic(*s3,2.); // s: [ x , k1 + 2*k2 + 2*k3 ]
-            ac.get_state().add_to_dynamic(*s4,1.); // s: [ x , xdot ] with wdot = k1 + 2*k2 + 2*k3 + k4
-            ac.get_state().apply_dynamic(sdt/6.); // s: [ x + xdot/6 , xdot ]
-
-            delete s4;
-            delete s3;
-            delete s2;
-            delete s1;
-            //// END RK4 UPDATE
-            current_time += sdt;
-            ac.get_state().set_time(current_time);
+            state &s = ac.get_state();
+            double h = sdt;
+            if(evl) {evl->begin(ac,fz,s);}
+            step(ac,fz,current_time,sdt,s,stg);
+            if(evl) {
+                state &s0 = *evl->start;
+                const double t0 = current_time;
+                evl->check(ac,fz,s,t0,h,
+                    [&ac,&fz,&s0,&stg,t0](double tau, state &out) {
+                        out.copy(s0);
+                        step(ac,fz,t0,tau,out,stg);
+                    });
+            }
+            current_time += h;
+            s.set_time(current_time);
+            if(evl && evl->stop) {break;}
         }
     }
 
+    /**
+     * @brief Transition function
+     *
+     * Same as above with a local stage storage (allocated once per call).
+     * @param {aircraft &} ac; aircraft model
+     * @param {flight_zone &} fz; atmosphere model
+     * @param {double &} current_time; current time
+     * @param {const double} time_step_width; time-step-width
+     * @param {const double} sdt; sub-time-step-width
+     */
+    static void transition_function(
+        aircraft &ac,
+        flight_zone &fz,
+        double &current_time,
+        const double time_step_width,
+        const double sdt)
+    {
+        rk4_stages stg;
+        transition_function(ac,fz,current_time,time_step_width,sdt,stg);
+    }
+
     /**
      * @brief Stepping operator
      *
@@ -110,10 +191,10 @@ public:
         }
 
         // 2. Apply the transition with RK4 method
-        transition_function(ac,fz,current_time,time_step_width,dt);
+        transition_function(ac,fz,current_time,time_step_width,dt,stages,evl.enabled ? &evl : nullptr);
 
         // 3. Check aircraft's configuration validity
-        if(!ac.is_in_model()){eos=true;}
+        if(evl.stop || !ac.is_in_model()){eos=true;}
     }
 };
 
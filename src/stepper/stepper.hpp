@@ -2,6 +2,9 @@
 #define L2FSIM_STEPPER_HPP_
 
 #include <pilot.hpp>
+#include <event_locator.hpp>
+#include <memory>
+#include <typeinfo>
 
 /**
  * @brief Stepper virtual class
@@ -13,8 +16,25 @@
 
 namespace L2Fsim {
 
+/**
+ * @brief Reserve a stage buffer
+ *
+ * Make the buffer hold a state of the same dynamic type as the input state. Allocation only
+ * occurs at first use (or if the type of the integrated state changes), afterwards the buffer
+ * is reused through 'state::copy'.
+ * @param {std::unique_ptr<state> &} buf; stage buffer
+ * @param {const state &} s; model state
+ */
+inline void reserve_stage(std::unique_ptr<state> &buf, const state &s) {
+    if(!buf || typeid(*buf) != typeid(s)) {
+        buf.reset(s.duplicate());
+    }
+}
+
 struct stepper {
 public:
+    event_locator evl; ///< Event detection within the time steps, disabled by default
+
     virtual ~stepper() = default;
 
     /**
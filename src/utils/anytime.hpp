@@ -0,0 +1,178 @@
+#ifndef L2FSIM_ANYTIME_HPP_
+#define L2FSIM_ANYTIME_HPP_
+
+#include <chrono>
+#include <climits>
+#include <iomanip>
+#include <ostream>
+#include <vector>
+
+/**
+ * @file anytime.hpp
+ * @brief Wall-clock deadlines and latency statistics of the planning pilots
+ * @version 1.0
+ * @since 1.1
+ *
+ * A planning pilot in anytime mode starts an 'anytime_deadline' when it is asked for a command,
+ * checks it after each expansion (or search) of its tree and returns the best action found so far
+ * once it has expired. The deadline is therefore exceeded by at most one expansion and the final
+ * action selection. The latency and the number of expansions of each decision are recorded in a
+ * 'decision_stats'.
+ */
+
+namespace L2Fsim {
+
+class anytime_deadline {
+public:
+    typedef std::chrono::steady_clock clock;
+
+    /**
+     * @brief Constructor, start the clock
+     * @param {double} time_limit; time allowed from now (s), 0 for no deadline
+     */
+    anytime_deadline(double time_limit=0.) :
+        start(clock::now()),
+        end(start + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(time_limit))),
+        bounded(time_limit > 0.)
+    {}
+
+    /** @brief Test whether there is a deadline */
+    bool is_bounded() const {return bounded;}
+
+    /** @brief Test whether the deadline has passed, a single read of the clock */
+    bool expired() const {return bounded && clock::now() >= end;}
+
+    /** @brief Time elapsed since the construction (s) */
+    double elapsed() const {return std::chrono::duration<double>(clock::now() - start).count();}
+
+protected:
+    clock::time_point start;
+    clock::time_point end;
+    bool bounded;
+};
+
+/**
+ * @brief Per-decision statistics of a planning pilot
+ *
+ * Histograms of the latency and of the number of expansions of the decisions, with bins following
+ * a 1-2-5 series (e.g. [1ms,2ms), [2ms,5ms), [5ms,10ms)). The storage is allocated once.
+ */
+class decision_stats {
+public:
+    /**
+     * @brief Attributes
+     * @param {std::vector<double>} latency_edges; lower edges of the latency bins (s)
+     * @param {std::vector<unsigned int>} latency_counts; number of decisions per latency bin, the first bin also counts the lower latencies
+     * @param {std::vector<double>} expansion_edges; lower edges of the expansion bins
+     * @param {std::vector<unsigned int>} expansion_counts; number of decisions per expansion bin, the first bin also counts 0
+     * @param {unsigned int} nb_decisions; number of recorded decisions
+     * @param {unsigned int} nb_expired; number of decisions stopped by their deadline
+     * @param {double} latency_sum; sum of the latencies (s)
+     * @param {double} latency_max; maximum latency (s)
+     * @param {double} expansion_sum; sum of the numbers of expansions
+     * @param {unsigned int} expansion_min; minimum number of expansions
+     */
+    std::vector<double> latency_edges;
+    std::vector<unsigned int> latency_counts;
+    std::vector<double> expansion_edges;
+    std::vector<unsigned int> expansion_counts;
+    unsigned int nb_decisions;
+    unsigned int nb_expired;
+    double latency_sum;
+    double latency_max;
+    double expansion_sum;
+    unsigned int expansion_min;
+
+    /** @brief Constructor, latencies from 10us to 100s and expansions from 1 to 1e8 */
+    decision_stats() :
+        latency_edges(series(1e-5,1e2)),
+        latency_counts(latency_edges.size(),0),
+        expansion_edges(series(1.,1e8)),
+        expansion_counts(expansion_edges.size(),0),
+        nb_decisions(0),
+        nb_expired(0),
+        latency_sum(0.),
+        latency_max(0.),
+        expansion_sum(0.),
+        expansion_min(UINT_MAX)
+    {}
+
+    /**
+     * @brief Record a decision
+     * @param {double} latency; time taken by the decision (s)
+     * @param {unsigned int} nb_expansions; number of expansions (or searches) of the decision
+     * @param {bool} expired; true if the decision was stopped by its deadline
+     */
+    void record(double latency, unsigned int nb_expansions, bool expired) {
+        ++latency_counts[bin(latency_edges,latency)];
+        ++expansion_counts[bin(expansion_edges,(double) nb_expansions)];
+        ++nb_decisions;
+        nb_expired += expired ? 1 : 0;
+        latency_sum += latency;
+        latency_max = (latency > latency_max) ? latency : latency_max;
+        expansion_sum += (double) nb_expansions;
+        expansion_min = (nb_expansions < expansion_min) ? nb_expansions : expansion_min;
+    }
+
+    /**
+     * @brief Latency quantile, upper edge of the bin containing it
+     * @param {double} p; probability in [0,1]
+     */
+    double latency_quantile(double p) const {
+        unsigned int target = (unsigned int) (p * nb_decisions);
+        unsigned int n = 0;
+        for(unsigned int i=0; i<latency_counts.size(); ++i) {
+            n += latency_counts[i];
+            if(n > target || (n == nb_decisions && n != 0)) {
+                return (i + 1 < latency_edges.size()) ? latency_edges[i+1] : latency_max;
+            }
+        }
+        return 0.;
+    }
+
+    /** @brief Print the summary and the non-empty bins of the histograms */
+    void print(std::ostream &os) const {
+        if(nb_decisions == 0) {
+            os << "no decision recorded" << std::endl;
+            return;
+        }
+        os << nb_decisions << " decisions, " << nb_expired << " stopped by the deadline" << std::endl;
+        os << "latency (ms): mean " << 1e3 * latency_sum / nb_decisions << ", max " << 1e3 * latency_max
+           << ", p99 below " << 1e3 * latency_quantile(.99) << std::endl;
+        print_histogram(os,latency_edges,latency_counts,1e3);
+        os << "expansions: mean " << expansion_sum / nb_decisions << ", min " << expansion_min << std::endl;
+        print_histogram(os,expansion_edges,expansion_counts,1.);
+    }
+
+protected:
+    /** @brief Edges 1, 2, 5, 10, 20... times 'lo' up to 'hi' */
+    static std::vector<double> series(double lo, double hi) {
+        std::vector<double> edges;
+        for(double d=lo; d<=hi*1.0001; d*=10.) {
+            edges.push_back(d);
+            edges.push_back(2. * d);
+            edges.push_back(5. * d);
+        }
+        return edges;
+    }
+
+    static unsigned int bin(const std::vector<double> &edges, double x) {
+        unsigned int i = 0;
+        while(i + 1 < edges.size() && !(x < edges[i+1])) {++i;}
+        return i;
+    }
+
+    static void print_histogram(std::ostream &os, const std::vector<double> &edges, const std::vector<unsigned int> &counts, double scale) {
+        for(unsigned int i=0; i<counts.size(); ++i) {
+            if(counts[i] == 0) {continue;}
+            os << "  [" << std::setw(8) << scale * edges[i] << ", ";
+            if(i + 1 < edges.size()) {os << std::setw(8) << scale * edges[i+1] << ")";}
+            else {os << "     inf)";}
+            os << " " << counts[i] << std::endl;
+        }
+    }
+};
+
+}
+
+#endif
@@ -8,6 +8,7 @@
 #include <beeler_glider/beeler_glider.hpp>
 #include <beeler_glider/beeler_glider_state.hpp>
 #include <beeler_glider/beeler_glider_command.hpp>
+#include <point_mass_glider/point_mass_glider.hpp>
 
 #include <flight_zone.hpp>
 #include <flat_zone.hpp>
@@ -17,13 +18,16 @@
 #include <stepper.hpp>
 #include <euler_integrator.hpp>
 #include <rk4_integrator.hpp>
+#include <dopri5_integrator.hpp>
 
 #include <pilot.hpp>
 #include <passive_pilot.hpp>
 #include <heuristic_pilot.hpp>
 #include <q_learning/q_learning_pilot.hpp>
-//#include <uct/uct.hpp>
+#include <uct/uct_pilot.hpp>
 #include <optimistic/optimistic_pilot.hpp>
+#include <lookup_table/lookup_table_pilot.hpp>
+#include <cem/cem_pilot.hpp>
 
 /**
  * @brief Configuration file reader
@@ -73,6 +77,31 @@ struct cfg_reader {
         return nullptr;
     }
 
+    /**
+     * @brief Read the pilot parameters files
+     *
+     * Read the path of the learned parameters loaded at start, the path where they are saved and
+     * the period of the saves. An empty path disables the loading or the saving.
+     */
+    void read_pilot_io(const libconfig::Config &cfg, std::string &load_path, std::string &save_path, double &save_period) {
+        if(cfg.lookupValue("pilot_load_path",load_path)
+        && cfg.lookupValue("pilot_save_path",save_path)
+        && cfg.lookupValue("pilot_save_period",save_period)) {/* nothing to do */}
+        else {error_at("read_pilot_io");}
+    }
+
+    /**
+     * @brief Read the transition dataset settings
+     *
+     * Read the prefix of the files of the recorded transitions, empty to record nothing, and the
+     * number of rows of a chunk (see 'transition_dataset.hpp').
+     */
+    void read_dataset(const libconfig::Config &cfg, std::string &prefix, unsigned int &chunk_size) {
+        if(cfg.lookupValue("dataset_prefix",prefix)
+        && cfg.lookupValue("dataset_chunk_size",chunk_size)) {/* nothing to do */}
+        else {error_at("read_dataset");}
+    }
+
     /**
      * @brief Read time variables
      *
@@ -170,6 +199,16 @@ struct cfg_reader {
                 beeler_glider_command a;
                 return std::unique_ptr<aircraft> (new beeler_glider(s,a));
             }
+            case 1: { // point_mass_glider
+                double x0=0., y0=0., z0=0., V0=0., gamma0=0., khi0=0., alpha0=0., beta0=0., sigma0=0., mam=0., tau=1.;
+                read_state(cfg,x0,y0,z0,V0,gamma0,khi0,alpha0,beta0,sigma0,mam);
+                if(cfg.lookupValue("point_mass_tau",tau)) {
+                    beeler_glider_state s(x0,y0,z0,V0,gamma0,khi0,alpha0,beta0,sigma0,mam);
+                    beeler_glider_command a;
+                    return std::unique_ptr<aircraft> (new point_mass_glider(s,a,1.36,1.524,16.,tau));
+                } else {error_at("read_aircraft");}
+                return nullptr;
+            }
             default: {error_at("read_aircraft");}
             }
         }
@@ -192,12 +231,31 @@ struct cfg_reader {
             case 1: { // rk4_integrator
                 return std::unique_ptr<stepper> (new rk4_integrator(sub_dt));
             }
+            case 2: { // dopri5_integrator
+                double atol = 1e-6, rtol = 1e-6;
+                if(cfg.lookupValue("dopri5_atol",atol)
+                && cfg.lookupValue("dopri5_rtol",rtol)) {
+                    return std::unique_ptr<stepper> (new dopri5_integrator(sub_dt,atol,rtol));
+                } else {error_at("read_stepper");}
+                return nullptr;
+            }
             }
         }
         else {error_at("read_stepper");}
         return std::unique_ptr<stepper> (nullptr);
     }
 
+    /**
+     * @brief Read event locator
+     *
+     * Read the event detection settings of a stepper.
+     */
+    void read_event_locator(const libconfig::Config &cfg, event_locator &evl) {
+        if(cfg.lookupValue("event_detection",evl.enabled)
+        && cfg.lookupValue("event_time_tolerance",evl.time_tolerance)) {/* nothing to do */}
+        else {error_at("read_event_locator");}
+    }
+
     /**
      * @brief Read pilot
      *
@@ -224,21 +282,34 @@ struct cfg_reader {
                 } else {error_at("read_pilot");}
             }
             case 2: { // q_learning_pilot
-                double arm=.1, kd=.01, ep=.1, lr=.01, df=.9;
+                double arm=.1, kd=.01, ep=.1, lr=.01, df=.9, tws=1., ralpha=.6, rbeta=.4;
+                unsigned int apx=0, ntl=8, tbits=16, rcap=0, rbatch=32;
+                std::string tvars = "zdot,gammadot,sigma";
                 if(cfg.lookupValue("angle_rate_magnitude",arm)
                 && cfg.lookupValue("kdalpha",kd)
                 && cfg.lookupValue("q_epsilon",ep)
                 && cfg.lookupValue("q_learning_rate",lr)
-                && cfg.lookupValue("q_discount_factor",df))
+                && cfg.lookupValue("q_discount_factor",df)
+                && cfg.lookupValue("q_approximator",apx)
+                && cfg.lookupValue("q_tile_variables",tvars)
+                && cfg.lookupValue("q_nb_tilings",ntl)
+                && cfg.lookupValue("q_tile_table_bits",tbits)
+                && cfg.lookupValue("q_tile_width_scale",tws)
+                && cfg.lookupValue("q_replay_capacity",rcap)
+                && cfg.lookupValue("q_replay_batch_size",rbatch)
+                && cfg.lookupValue("q_replay_alpha",ralpha)
+                && cfg.lookupValue("q_replay_beta",rbeta))
                 {
                     arm *= TO_RAD;
-                    return std::unique_ptr<pilot> (new q_learning_pilot(arm,kd,ep,lr,df));
+                    return std::unique_ptr<pilot> (new q_learning_pilot(arm,kd,ep,lr,df,std::random_device()(),apx,tvars,ntl,tbits,tws,rcap,rbatch,ralpha,rbeta));
                 } else {error_at("read_pilot");}
+                return nullptr;
             }
-            case 3: { // uct
+            case 3: { // uct_pilot
                 std::string sc_path, envt_cfg_path;
                 double noise_stddev=0., arm=1., kd=.01, pr=.7, dt=.1, sdt=.1, df=.9;
-                unsigned int hz=100, bd=1000, dfplselect=0;
+                double pwk=0., pwa=.5, pres=0., vres=0., ares=0., tl=0.;
+                unsigned int hz=100, bd=1000, dfplselect=0, nth=1, mn=0, nro=1, nrth=1;
                 if(cfg.lookupValue("th_scenario_path", sc_path)
                 && cfg.lookupValue("envt_cfg_path", envt_cfg_path)
                 && cfg.lookupValue("noise_stddev", noise_stddev)
@@ -250,47 +321,41 @@ struct cfg_reader {
                 && cfg.lookupValue("uct_discount_factor",df)
                 && cfg.lookupValue("uct_horizon",hz)
                 && cfg.lookupValue("uct_budget",bd)
-                && cfg.lookupValue("uct_default_policy_selector",dfplselect))
+                && cfg.lookupValue("uct_default_policy_selector",dfplselect)
+                && cfg.lookupValue("uct_nb_threads",nth)
+                && cfg.lookupValue("uct_max_nodes",mn)
+                && cfg.lookupValue("uct_pw_k",pwk)
+                && cfg.lookupValue("uct_pw_alpha",pwa)
+                && cfg.lookupValue("uct_position_resolution",pres)
+                && cfg.lookupValue("uct_speed_resolution",vres)
+                && cfg.lookupValue("uct_angle_resolution",ares)
+                && cfg.lookupValue("uct_nb_rollouts",nro)
+                && cfg.lookupValue("uct_nb_rollout_threads",nrth)
+                && cfg.lookupValue("uct_time_limit",tl))
                 {
-                    /*
                     double x0=0., y0=0., z0=0., V0=0., gamma0=0., khi0=0., alpha0=0., beta0=0., sigma0=0., mam=0.;
                     read_state(cfg,x0,y0,z0,V0,gamma0,khi0,alpha0,beta0,sigma0,mam);
                     beeler_glider_state s(x0,y0,z0,V0,gamma0,khi0,alpha0,beta0,sigma0,mam);
                     beeler_glider_command a;
                     beeler_glider ac_model(s,a);
                     arm *= TO_RAD;
-                    */
-                    /* //TRM
+                    ares *= TO_RAD;
+
                     return std::unique_ptr<pilot> (
                         new uct_pilot(
                             ac_model,
                             sc_path, envt_cfg_path, noise_stddev, // flat_thermal_soaring_zone parameters
-                            euler_integrator::transition_function,
-                            arm, kd, pr, dt, sdt, df, hz, bd, dfplselect
-                        )
-                    );
-                    */
-                    /*
-                    return std::unique_ptr<pilot> (
-                        new uct<
-                            beeler_glider_state,
-                            beeler_glider_action,
-                            //TODO
-                        > (
-                            ac_model,
-                            sc_path, envt_cfg_path, noise_stddev, // flat_thermal_soaring_zone parameters
-                            euler_integrator::transition_function,
-                            arm, kd, pr, dt, sdt, df, hz, bd, dfplselect
-                        )
-                    );
-                    */
-                    error_at("read_pilot");//TRM
+                            arm, kd, pr, dt, sdt, df, hz, bd, dfplselect, nth, mn,
+                            pwk, pwa, pres, vres, ares, nro, nrth, tl
+                        ));
                 } else {error_at("read_pilot");}
+                return nullptr;
             }
             case 4: { // optimistic_pilot
                 std::string sc_path, envt_cfg_path;
-                double noise_stddev=0., arm=1., kd=.01, dt=.1, sdt=.1, df=.9;
-                unsigned int bd=1000;
+                double noise_stddev=0., arm=1., kd=.01, dt=.1, sdt=.1, df=.9, tau=1., rtol=1e-3, tl=0.;
+                unsigned int bd=1000, msl=0, nth=1, pw=32;
+                bool reuse=false;
                 if(cfg.lookupValue("th_scenario_path", sc_path)
                 && cfg.lookupValue("envt_cfg_path", envt_cfg_path)
                 && cfg.lookupValue("noise_stddev", noise_stddev)
@@ -299,7 +364,14 @@ struct cfg_reader {
                 && cfg.lookupValue("opt_time_step_width",dt)
                 && cfg.lookupValue("opt_sub_time_step_width",sdt)
                 && cfg.lookupValue("opt_discount_factor",df)
-                && cfg.lookupValue("opt_budget",bd))
+                && cfg.lookupValue("opt_budget",bd)
+                && cfg.lookupValue("opt_model_selector",msl)
+                && cfg.lookupValue("opt_tree_reuse",reuse)
+                && cfg.lookupValue("opt_reuse_tolerance",rtol)
+                && cfg.lookupValue("opt_nb_threads",nth)
+                && cfg.lookupValue("opt_parallel_width",pw)
+                && cfg.lookupValue("opt_time_limit",tl)
+                && cfg.lookupValue("point_mass_tau",tau))
 				{
                     double x0=0., y0=0., z0=0., V0=0., gamma0=0., khi0=0., alpha0=0., beta0=0., sigma0=0., mam=0.;
                     read_state(cfg,x0,y0,z0,V0,gamma0,khi0,alpha0,beta0,sigma0,mam);
@@ -312,9 +384,59 @@ struct cfg_reader {
 						new optimistic_pilot(
 							ac_model,
 							sc_path, envt_cfg_path, noise_stddev, // flat_thermal_soaring_zone parameters
-                        	arm, kd, dt, sdt, df, bd
+                        	arm, kd, dt, sdt, df, bd, msl, tau, reuse, rtol, nth, pw, tl
 						));
                 } else {error_at("read_pilot");}
+                return nullptr;
+            }
+            case 5: { // lookup_table_pilot
+                std::string lut_path;
+                double arm=.1, kd=.01;
+                if(cfg.lookupValue("angle_rate_magnitude",arm)
+                && cfg.lookupValue("kdalpha",kd)
+                && cfg.lookupValue("lut_path",lut_path)) {
+                    arm *= TO_RAD;
+                    std::unique_ptr<pilot> pl(new lookup_table_pilot(arm,kd));
+                    load_pilot_parameters(*pl,lut_path);
+                    return pl;
+                } else {error_at("read_pilot");}
+                return nullptr;
+            }
+            case 6: { // cem_pilot
+                std::string sc_path, envt_cfg_path;
+                double noise_stddev=0., arm=1., kd=.01, dt=1., sdt=.1, df=.9, sd=.5, sm=.1;
+                unsigned int pop=64, hz=10, nit=4, nel=8, nth=1;
+                if(cfg.lookupValue("th_scenario_path", sc_path)
+                && cfg.lookupValue("envt_cfg_path", envt_cfg_path)
+                && cfg.lookupValue("noise_stddev", noise_stddev)
+                && cfg.lookupValue("angle_rate_magnitude",arm)
+                && cfg.lookupValue("kdalpha",kd)
+                && cfg.lookupValue("cem_time_step_width",dt)
+                && cfg.lookupValue("cem_sub_time_step_width",sdt)
+                && cfg.lookupValue("cem_discount_factor",df)
+                && cfg.lookupValue("cem_population",pop)
+                && cfg.lookupValue("cem_horizon",hz)
+                && cfg.lookupValue("cem_nb_iterations",nit)
+                && cfg.lookupValue("cem_nb_elites",nel)
+                && cfg.lookupValue("cem_initial_stddev",sd)
+                && cfg.lookupValue("cem_smoothing",sm)
+                && cfg.lookupValue("cem_nb_threads",nth))
+                {
+                    double x0=0., y0=0., z0=0., V0=0., gamma0=0., khi0=0., alpha0=0., beta0=0., sigma0=0., mam=0.;
+                    read_state(cfg,x0,y0,z0,V0,gamma0,khi0,alpha0,beta0,sigma0,mam);
+                    beeler_glider_state s(x0,y0,z0,V0,gamma0,khi0,alpha0,beta0,sigma0,mam);
+                    beeler_glider_command a;
+                    beeler_glider ac_model(s,a);
+                    arm *= TO_RAD;
+
+                    return std::unique_ptr<pilot> (
+                        new cem_pilot(
+                            ac_model,
+                            sc_path, envt_cfg_path, noise_stddev, // flat_thermal_soaring_zone parameters
+                            arm, kd, dt, sdt, df, pop, hz, nit, nel, sd, sm, nth
+                        ));
+                } else {error_at("read_pilot");}
+                return nullptr;
             }
             }
         }
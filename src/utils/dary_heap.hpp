@@ -0,0 +1,104 @@
+#ifndef L2FSIM_DARY_HEAP_HPP_
+#define L2FSIM_DARY_HEAP_HPP_
+
+#include <vector>
+
+/**
+ * @file dary_heap.hpp
+ * @brief Array-backed d-ary max-heap of indices
+ * @version 1.0
+ * @since 1.1
+ *
+ * Priority queue of indices (e.g. of nodes in a pool) keyed by a double. The entries are stored
+ * contiguously and a node of the heap has D children, so that a heap of a few ten thousands
+ * entries has a small depth and its sift operations stay in few cache lines. No allocation is
+ * made once the capacity is reached.
+ * Entries with equal keys are ordered by insertion: the last inserted one is on top, as for
+ * '--m.end()' with a 'std::multimap'.
+ */
+
+namespace L2Fsim {
+
+template <unsigned int D=4>
+class dary_heap {
+public:
+    /** @brief Entry of the heap */
+    struct entry {
+        double key; ///< Priority
+        unsigned int seq; ///< Insertion number, the greater is on top among equal keys
+        unsigned int value; ///< Stored index
+    };
+
+    /** @brief Constructor */
+    dary_heap(unsigned int capacity=0) : seq(0) {entries.reserve(capacity);}
+
+    /** @brief Reserve storage for a number of entries */
+    void reserve(unsigned int capacity) {entries.reserve(capacity);}
+
+    /** @brief Remove all the entries, the storage is kept */
+    void clear() {
+        entries.clear();
+        seq = 0;
+    }
+
+    unsigned int size() const {return entries.size();}
+    bool empty() const {return entries.empty();}
+
+    /** @brief Entry with the highest key */
+    const entry & top() const {return entries.front();}
+
+    /** @brief Entries in the order of the array, for inspection */
+    const std::vector<entry> & data() const {return entries;}
+
+    /**
+     * @brief Insert an index
+     * @param {double} key; priority
+     * @param {unsigned int} value; inserted index
+     */
+    void push(double key, unsigned int value) {
+        entry e = {key,seq++,value};
+        unsigned int i = entries.size();
+        entries.push_back(e);
+        while(i > 0) { // sift up
+            unsigned int p = (i - 1) / D;
+            if(!less(entries[p],e)) {break;}
+            entries[i] = entries[p];
+            i = p;
+        }
+        entries[i] = e;
+    }
+
+    /** @brief Remove the entry with the highest key */
+    void pop() {
+        entry e = entries.back();
+        entries.pop_back();
+        unsigned int n = entries.size();
+        if(n == 0) {return;}
+        unsigned int i = 0;
+        while(true) { // sift down
+            unsigned int c = D * i + 1;
+            if(c >= n) {break;}
+            unsigned int c_end = (c + D < n) ? c + D : n;
+            unsigned int best = c;
+            for(++c; c<c_end; ++c) {
+                if(less(entries[best],entries[c])) {best = c;}
+            }
+            if(!less(e,entries[best])) {break;}
+            entries[i] = entries[best];
+            i = best;
+        }
+        entries[i] = e;
+    }
+
+protected:
+    std::vector<entry> entries;
+    unsigned int seq;
+
+    static bool less(const entry &a, const entry &b) {
+        return a.key < b.key || (a.key == b.key && a.seq < b.seq);
+    }
+};
+
+}
+
+#endif
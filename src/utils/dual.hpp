@@ -0,0 +1,184 @@
+#ifndef L2FSIM_DUAL_HPP_
+#define L2FSIM_DUAL_HPP_
+
+#include <cmath>
+#include <iostream>
+
+/**
+ * @file dual.hpp
+ * @brief Dual numbers for the forward-mode automatic differentiation
+ * @version 1.0
+ * @since 1.1
+ *
+ * A dual number holds a value and its partial derivatives with respect to N seeded variables.
+ * The arithmetic operators and the elementary functions propagate the derivatives with the
+ * chain rule, so that a model templated on its scalar type (e.g. 'basic_beeler_glider<T>')
+ * computes its output and the Jacobian of the output in a single evaluation.
+ * The elementary functions are found by argument-dependent lookup: the models call them
+ * unqualified ('cos(x)' rather than 'std::cos(x)').
+ * @note the comparison operators compare the values, the branches of the models are taken
+ * according to the values and differentiated as such
+ */
+
+/**
+ * The loops over the derivatives have a constant trip count: unrolling them lets the compiler keep
+ * the dual numbers in registers, which -O2 does not do by itself (about 20 times faster).
+ */
+#if defined(__clang__)
+#define L2FSIM_DUAL_UNROLL _Pragma("unroll")
+#elif defined(__GNUC__) && (__GNUC__ >= 8)
+#define L2FSIM_DUAL_UNROLL _Pragma("GCC unroll 16")
+#else
+#define L2FSIM_DUAL_UNROLL
+#endif
+
+namespace L2Fsim {
+
+template <unsigned int N>
+struct dual {
+    double v; ///< Value
+    double d[N]; ///< Partial derivatives
+
+    /**
+     * @brief Constructor of a constant
+     * @param {double} _v; value
+     */
+    dual(double _v=0.) : v(_v) {
+        L2FSIM_DUAL_UNROLL for(unsigned int k=0; k<N; ++k) {d[k] = 0.;}
+    }
+
+    /**
+     * @brief Constructor of a seeded variable
+     * @param {double} _v; value
+     * @param {unsigned int} i; indice of the variable, its derivative is 1
+     */
+    dual(double _v, unsigned int i) : dual(_v) {d[i] = 1.;}
+
+    /** @brief Tag of the constructor leaving the derivatives uninitialized */
+    struct uninitialized {};
+
+    /** @brief Constructor of a result whose derivatives are set afterwards */
+    dual(double _v, uninitialized) : v(_v) {}
+
+    /** @brief Result of a function with value 'f' and derivative 'df' applied to 'a' */
+    static dual chain(const dual &a, double f, double df) {
+        dual r(f,uninitialized());
+        L2FSIM_DUAL_UNROLL for(unsigned int k=0; k<N; ++k) {r.d[k] = df * a.d[k];}
+        return r;
+    }
+
+    dual & operator+=(const dual &b) {
+        v += b.v;
+        L2FSIM_DUAL_UNROLL for(unsigned int k=0; k<N; ++k) {d[k] += b.d[k];}
+        return *this;
+    }
+    dual & operator-=(const dual &b) {
+        v -= b.v;
+        L2FSIM_DUAL_UNROLL for(unsigned int k=0; k<N; ++k) {d[k] -= b.d[k];}
+        return *this;
+    }
+    dual & operator*=(const dual &b) {return *this = *this * b;}
+    dual & operator/=(const dual &b) {return *this = *this / b;}
+    dual & operator+=(double b) {v += b; return *this;}
+    dual & operator-=(double b) {v -= b; return *this;}
+    dual & operator*=(double b) {
+        v *= b;
+        L2FSIM_DUAL_UNROLL for(unsigned int k=0; k<N; ++k) {d[k] *= b;}
+        return *this;
+    }
+    dual & operator/=(double b) {
+        v /= b;
+        L2FSIM_DUAL_UNROLL for(unsigned int k=0; k<N; ++k) {d[k] /= b;}
+        return *this;
+    }
+
+    friend dual operator+(const dual &a) {return a;}
+    friend dual operator-(const dual &a) {return chain(a,-a.v,-1.);}
+
+    friend dual operator+(dual a, const dual &b) {return a += b;}
+    friend dual operator+(dual a, double b) {return a += b;}
+    friend dual operator+(double a, dual b) {return b += a;}
+    friend dual operator-(dual a, const dual &b) {return a -= b;}
+    friend dual operator-(dual a, double b) {return a -= b;}
+    friend dual operator-(double a, const dual &b) {return chain(b,a-b.v,-1.);}
+    friend dual operator*(const dual &a, const dual &b) {
+        dual r(a.v * b.v,uninitialized());
+        L2FSIM_DUAL_UNROLL for(unsigned int k=0; k<N; ++k) {r.d[k] = a.d[k] * b.v + a.v * b.d[k];}
+        return r;
+    }
+    friend dual operator*(dual a, double b) {return a *= b;}
+    friend dual operator*(double a, dual b) {return b *= a;}
+    friend dual operator/(const dual &a, const dual &b) {
+        dual r(a.v / b.v,uninitialized());
+        double ib = 1. / b.v;
+        L2FSIM_DUAL_UNROLL for(unsigned int k=0; k<N; ++k) {r.d[k] = (a.d[k] - r.v * b.d[k]) * ib;}
+        return r;
+    }
+    friend dual operator/(dual a, double b) {return a /= b;}
+    friend dual operator/(double a, const dual &b) {
+        double f = a / b.v;
+        return chain(b,f,-f/b.v);
+    }
+
+    friend bool operator==(const dual &a, const dual &b) {return a.v == b.v;}
+    friend bool operator!=(const dual &a, const dual &b) {return a.v != b.v;}
+    friend bool operator<(const dual &a, const dual &b) {return a.v < b.v;}
+    friend bool operator>(const dual &a, const dual &b) {return a.v > b.v;}
+    friend bool operator<=(const dual &a, const dual &b) {return a.v <= b.v;}
+    friend bool operator>=(const dual &a, const dual &b) {return a.v >= b.v;}
+    friend bool operator<(const dual &a, double b) {return a.v < b;}
+    friend bool operator>(const dual &a, double b) {return a.v > b;}
+    friend bool operator<=(const dual &a, double b) {return a.v <= b;}
+    friend bool operator>=(const dual &a, double b) {return a.v >= b;}
+    friend bool operator<(double a, const dual &b) {return a < b.v;}
+    friend bool operator>(double a, const dual &b) {return a > b.v;}
+    friend bool operator<=(double a, const dual &b) {return a <= b.v;}
+    friend bool operator>=(double a, const dual &b) {return a >= b.v;}
+
+    friend dual sin(const dual &a) {return chain(a,std::sin(a.v),std::cos(a.v));}
+    friend dual cos(const dual &a) {return chain(a,std::cos(a.v),-std::sin(a.v));}
+    friend dual tan(const dual &a) {
+        double t = std::tan(a.v);
+        return chain(a,t,1.+t*t);
+    }
+    friend dual asin(const dual &a) {return chain(a,std::asin(a.v),1./std::sqrt(1.-a.v*a.v));}
+    friend dual acos(const dual &a) {return chain(a,std::acos(a.v),-1./std::sqrt(1.-a.v*a.v));}
+    friend dual atan(const dual &a) {return chain(a,std::atan(a.v),1./(1.+a.v*a.v));}
+    friend dual atan2(const dual &y, const dual &x) {
+        double ir2 = 1. / (x.v*x.v + y.v*y.v);
+        dual r(std::atan2(y.v,x.v),uninitialized());
+        L2FSIM_DUAL_UNROLL for(unsigned int k=0; k<N; ++k) {r.d[k] = (x.v * y.d[k] - y.v * x.d[k]) * ir2;}
+        return r;
+    }
+    /** @note the derivative is set to 0 at 0, where the square root of a clamped value is taken */
+    friend dual sqrt(const dual &a) {
+        double s = std::sqrt(a.v);
+        return chain(a,s,(s > 0.) ? .5/s : 0.);
+    }
+    friend dual exp(const dual &a) {
+        double e = std::exp(a.v);
+        return chain(a,e,e);
+    }
+    friend dual log(const dual &a) {return chain(a,std::log(a.v),1./a.v);}
+    friend dual pow(const dual &a, double p) {
+        double f = std::pow(a.v,p);
+        return chain(a,f,(a.v != 0.) ? p*f/a.v : 0.);
+    }
+    friend dual fabs(const dual &a) {return (a.v < 0.) ? -a : a;}
+    friend dual copysign(const dual &a, const dual &b) {
+        return (std::signbit(a.v) == std::signbit(b.v)) ? a : -a;
+    }
+    friend dual remainder(const dual &a, const dual &b) {
+        double q = std::round((a.v - std::remainder(a.v,b.v)) / b.v);
+        return a - q * b;
+    }
+
+    /** @brief Value of a dual number, see 'value_of' in 'utils.hpp' */
+    friend double value_of(const dual &a) {return a.v;}
+
+    friend std::ostream & operator<<(std::ostream &os, const dual &a) {return os << a.v;}
+};
+
+}
+
+#endif // L2FSIM_DUAL_HPP_
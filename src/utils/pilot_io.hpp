@@ -0,0 +1,159 @@
+#ifndef L2FSIM_PILOT_IO_HPP_
+#define L2FSIM_PILOT_IO_HPP_
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <pilot.hpp>
+
+/**
+ * @file pilot_io.hpp
+ * @brief Versioned binary files of the learned parameters of a pilot
+ * @version 1.0
+ * @since 1.1
+ *
+ * A file is made of a header followed by the payload written by 'pilot::save_parameters':
+ * - the magic bytes "L2FP";
+ * - the format version (uint32);
+ * - the byte order mark 0x01020304 (uint32), a file written on a machine of another byte order is rejected.
+ * A payload begins with the name of the pilot (see 'write_name'), checked by the loading pilot.
+ * The values are written in the byte order of the machine, the doubles in IEEE 754. A pilot
+ * writes the sizes of its arrays before them so that a file of another configuration (e.g.
+ * another feature map or weight table size) is rejected instead of silently misread.
+ * A file is written to 'path.tmp' then renamed, hence a periodic save interrupted by the end of
+ * the process leaves the previous file intact.
+ */
+
+namespace L2Fsim {
+
+static constexpr char pilot_io_magic[4] = {'L','2','F','P'};
+static constexpr std::uint32_t pilot_io_version = 1;
+static constexpr std::uint32_t pilot_io_byte_order = 0x01020304;
+
+/** @brief Write a trivially copyable value */
+template <class T>
+void write_binary(std::ostream &os, const T &v) {
+    os.write(reinterpret_cast<const char *>(&v),sizeof(T));
+}
+
+/** @brief Write an array of trivially copyable values, preceded by its size (uint32) */
+template <class T>
+void write_binary(std::ostream &os, const T *v, std::uint32_t n) {
+    write_binary(os,n);
+    os.write(reinterpret_cast<const char *>(v),n * sizeof(T));
+}
+
+/**
+ * @brief Read a trivially copyable value
+ * @throw std::runtime_error at the end of the stream
+ */
+template <class T>
+void read_binary(std::istream &is, T &v) {
+    if(!is.read(reinterpret_cast<char *>(&v),sizeof(T))) {
+        throw std::runtime_error("pilot_io: unexpected end of file");
+    }
+}
+
+/**
+ * @brief Read an array written by 'write_binary', its size must be the expected one
+ * @throw std::runtime_error if the sizes differ or at the end of the stream
+ */
+template <class T>
+void read_binary(std::istream &is, T *v, std::uint32_t n) {
+    std::uint32_t m = 0;
+    read_binary(is,m);
+    if(m != n) {
+        throw std::runtime_error("pilot_io: array of size " + std::to_string(m) + " found, " + std::to_string(n) + " expected");
+    }
+    if(!is.read(reinterpret_cast<char *>(v),n * sizeof(T))) {
+        throw std::runtime_error("pilot_io: unexpected end of file");
+    }
+}
+
+/**
+ * @brief Read an array written by 'write_binary' whatever its size
+ * @param {std::vector<T> &} v; read array, resized to the size found
+ * @param {std::uint32_t} max_size; maximum size accepted, against corrupted files
+ */
+template <class T>
+void read_binary_vector(std::istream &is, std::vector<T> &v, std::uint32_t max_size=1u<<30) {
+    std::uint32_t n = 0;
+    read_binary(is,n);
+    if(n > max_size) {throw std::runtime_error("pilot_io: array of size " + std::to_string(n) + " found, at most " + std::to_string(max_size) + " expected");}
+    v.resize(n);
+    if(!is.read(reinterpret_cast<char *>(v.data()),n * sizeof(T))) {
+        throw std::runtime_error("pilot_io: unexpected end of file");
+    }
+}
+
+/** @brief Write the name of a pilot (uint32 length, then the characters) */
+inline void write_name(std::ostream &os, const std::string &name) {
+    write_binary(os,name.data(),(std::uint32_t) name.size());
+}
+
+/**
+ * @brief Read the name of a pilot written by 'write_name', it must be the expected one
+ * @throw std::runtime_error if the names differ
+ */
+inline void read_name(std::istream &is, const std::string &name) {
+    std::uint32_t length = 0;
+    read_binary(is,length);
+    std::string file_name(length,' ');
+    if(!is.read(&file_name[0],length) || file_name != name) {
+        throw std::runtime_error("pilot_io: parameters of " + file_name + " found, " + name + " expected");
+    }
+}
+
+/**
+ * @brief Save the learned parameters of a pilot
+ * @param {const pilot &} pl; saved pilot
+ * @param {const std::string &} path; output file
+ */
+inline void save_pilot_parameters(const pilot &pl, const std::string &path) {
+    std::string tmp_path = path + ".tmp";
+    {
+        std::ofstream os(tmp_path,std::ofstream::binary);
+        if(!os) {throw std::runtime_error("pilot_io: cannot open " + tmp_path);}
+        os.write(pilot_io_magic,4);
+        write_binary(os,pilot_io_version);
+        write_binary(os,pilot_io_byte_order);
+        pl.save_parameters(os);
+        if(!os) {throw std::runtime_error("pilot_io: error while writing " + tmp_path);}
+    }
+    if(std::rename(tmp_path.c_str(),path.c_str()) != 0) {
+        throw std::runtime_error("pilot_io: cannot rename " + tmp_path + " to " + path);
+    }
+}
+
+/**
+ * @brief Load the learned parameters of a pilot
+ * @param {pilot &} pl; loading pilot
+ * @param {const std::string &} path; input file
+ * @throw std::runtime_error if the file does not fit the pilot
+ */
+inline void load_pilot_parameters(pilot &pl, const std::string &path) {
+    std::ifstream is(path,std::ifstream::binary);
+    if(!is) {throw std::runtime_error("pilot_io: cannot open " + path);}
+    char magic[4];
+    std::uint32_t version = 0, byte_order = 0;
+    if(!is.read(magic,4) || std::string(magic,4) != std::string(pilot_io_magic,4)) {
+        throw std::runtime_error("pilot_io: " + path + " is not a pilot parameters file");
+    }
+    read_binary(is,version);
+    if(version != pilot_io_version) {
+        throw std::runtime_error("pilot_io: " + path + " has format version " + std::to_string(version)
+            + ", version " + std::to_string(pilot_io_version) + " expected");
+    }
+    read_binary(is,byte_order);
+    if(byte_order != pilot_io_byte_order) {
+        throw std::runtime_error("pilot_io: " + path + " was written with another byte order");
+    }
+    pl.load_parameters(is);
+}
+
+}
+
+#endif
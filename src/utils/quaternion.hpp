@@ -15,169 +15,197 @@ namespace L2Fsim {
  * - roll is a rotation around the x-axis
  * Reference: Euler Angles, Quaternions, and Transformation Matrices.
  * NASA-TM-74839, shuttle program (1977).
+ * The template parameter T is the scalar type ('double', 'float' or a dual number of 'dual.hpp'),
+ * the elementary functions are called unqualified so that they are found by argument-dependent lookup.
  */
-class quaternion {
+template <class T>
+class basic_quaternion {
 protected:
-	double w;
-	double x;
-	double y;
-	double z;
+	T w;
+	T x;
+	T y;
+	T z;
 
 public:
-	/** Constructor (default is the identity rotation). */
-	quaternion(double w_=1., double x_=0., double y_=0., double z_=0.);
+	/** Default constructor: the identity rotation (already normalized). */
+	basic_quaternion();
+	/** Constructor (the quaternion is normalized). */
+	basic_quaternion(T w_, T x_=0, T y_=0, T z_=0);
 	/** Copy constructor */
-	quaternion(const quaternion &q2);
+	basic_quaternion(const basic_quaternion &q2);
+	/** Assignment */
+	basic_quaternion & operator=(const basic_quaternion &q2) = default;
 	/** Destructor */
-	virtual ~quaternion();
+	virtual ~basic_quaternion();
 	/** Initializes from Euler angles */
-	void fromEuler(double yaw, double pitch, double roll);
+	void fromEuler(T yaw, T pitch, T roll);
 	/** Returns corresponding Euler angles */
-	void toEuler(double &yaw, double &pitch, double &roll) const;
+	void toEuler(T &yaw, T &pitch, T &roll) const;
 	/** Initializes from a pair axis-angle. Axis should be a non-zero vector (does not need to be normalized). */
-	void fromAxisAngle(double xx, double yy, double zz, double alpha);
+	void fromAxisAngle(T xx, T yy, T zz, T alpha);
 	/** Returns the corresponding (not normalized) rotation axis and angle. If angle is zero, then the returned axis is a zero vector. */
-	void toAxisAngle(double &xx, double &yy, double &zz, double &alpha) const;
+	void toAxisAngle(T &xx, T &yy, T &zz, T &alpha) const;
 	/** Initializes from a rotation matrix. The argument is supposed to be a 9-elements vector containing the consecutive rows of the matrix. This function supposes that the provided matrix is indeed a rotation matrix and does not perform any verification on it. */
-	void fromRotationMatrix(const std::vector<double>& m);
+	void fromRotationMatrix(const std::vector<T>& m);
 	/** Returns the corresponding rotation matrix. The return value is a 9-elements vector containing the consecutive rows of the matrix. */
-	void toRotationMatrix(std::vector<double> &m) const;
+	void toRotationMatrix(std::vector<T> &m) const;
 	/** Rotates vector v using the quaternion */
-	void rotateVector(std::vector<double> &v) const;
+	void rotateVector(std::vector<T> &v) const;
 	/** Changes q into q*q2 (so the corresponding rotation becomes "r2 then r"). */
-	void multRight(quaternion &q2);
+	void multRight(basic_quaternion &q2);
 	/** Changes q into q2*q (so the corresponding rotation becomes "r then r2"). */
-	void multLeft(quaternion &q2);
+	void multLeft(basic_quaternion &q2);
 	/** Returns the rotation angle */
-	double rotationAngle() const;
+	T rotationAngle() const;
 	/** Returns the (not normalized) rotation axis */
-	void rotationAxis(std::vector<double> &v) const;
+	void rotationAxis(std::vector<T> &v) const;
 	/** Returns the (not normalized) rotation axis */
-	void rotationAxis(double &xx, double &yy, double &zz) const;
+	void rotationAxis(T &xx, T &yy, T &zz) const;
 	/** Normalizes the quaternion */
 	void normalize();
 	/** Reverses the rotation angle */
 	void invert();
 	/** The quaternion's norm */
-	double norm() const;
+	T norm() const;
 };
 
-quaternion::quaternion(double w_, double x_, double y_, double z_)
+template <class T>
+basic_quaternion<T>::basic_quaternion()
+: w(1), x(0), y(0), z(0) { }
+
+template <class T>
+basic_quaternion<T>::basic_quaternion(T w_, T x_, T y_, T z_)
 : w(w_), x(x_), y(y_), z(z_) { this->normalize(); }
 
-quaternion::quaternion(const quaternion &q2)
+template <class T>
+basic_quaternion<T>::basic_quaternion(const basic_quaternion &q2)
 : w(q2.w), x(q2.x), y(q2.y), z(q2.z) { }
 
-quaternion::~quaternion() { }
+template <class T>
+basic_quaternion<T>::~basic_quaternion() { }
 
-void quaternion::fromEuler(double yaw, double pitch, double roll) {
-	double c1 = std::cos(yaw / 2.);
-	double s1 = std::sin(yaw / 2.);
-	double c2 = std::cos(pitch / 2.);
-	double s2 = std::sin(pitch / 2.);
-	double c3 = std::cos(roll / 2.);
-	double s3 = std::sin(roll / 2.);
+template <class T>
+void basic_quaternion<T>::fromEuler(T yaw, T pitch, T roll) {
+	using std::cos; using std::sin;
+	T c1 = cos(yaw / 2);
+	T s1 = sin(yaw / 2);
+	T c2 = cos(pitch / 2);
+	T s2 = sin(pitch / 2);
+	T c3 = cos(roll / 2);
+	T s3 = sin(roll / 2);
 	w = c1*c2*c3 + s1*s2*s3;
 	x = c1*c2*s3 - s1*s2*c3;
 	y = c1*s2*c3 + s1*c2*s3;
 	z = s1*c2*c3 - c1*s2*s3;
 }
 
-void quaternion::toEuler(double &yaw, double &pitch, double &roll) const {
-	double sqw = w*w;
-	double sqx = x*x;
-	double sqy = y*y;
-	double sqz = z*z;
-	yaw   = std::atan2(2.*(x*y + z*w), sqw+sqx-sqy-sqz);
-	roll  = std::atan2(2.0 * (y*z + x*w),(-sqx - sqy + sqz + sqw));
-	pitch = std::asin(-2.0 * (x*z - y*w)/(sqx + sqy + sqz + sqw));
+template <class T>
+void basic_quaternion<T>::toEuler(T &yaw, T &pitch, T &roll) const {
+	using std::atan2; using std::asin;
+	T sqw = w*w;
+	T sqx = x*x;
+	T sqy = y*y;
+	T sqz = z*z;
+	yaw   = atan2(2*(x*y + z*w), sqw+sqx-sqy-sqz);
+	roll  = atan2(2 * (y*z + x*w),(-sqx - sqy + sqz + sqw));
+	pitch = asin(-2 * (x*z - y*w)/(sqx + sqy + sqz + sqw));
 }
 
-void quaternion::fromAxisAngle(double xx, double yy, double zz, double alpha) {
-	double norm = std::sqrt(xx*xx + yy*yy + zz*zz);
-	w = std::cos(alpha/2.);
-	double s = std::sin(alpha/2.);
+template <class T>
+void basic_quaternion<T>::fromAxisAngle(T xx, T yy, T zz, T alpha) {
+	using std::cos; using std::sin; using std::sqrt;
+	T norm = sqrt(xx*xx + yy*yy + zz*zz);
+	w = cos(alpha/2);
+	T s = sin(alpha/2);
 	x = xx*s/norm;
 	y = yy*s/norm;
 	z = zz*s/norm;
 }
 
-void quaternion::toAxisAngle(double &xx, double &yy, double &zz, double &alpha) const {
-	alpha = 2.*std::acos(w);
+template <class T>
+void basic_quaternion<T>::toAxisAngle(T &xx, T &yy, T &zz, T &alpha) const {
+	using std::acos;
+	alpha = 2*acos(w);
 	xx = x;
 	yy = y;
 	zz = z;
 }
 
-void quaternion::fromRotationMatrix(const std::vector<double>& m) {
-	w = std::sqrt( std::max( 0., 1. + m[0] + m[4] + m[8] ) ) / 2.;
-	x = std::sqrt( std::max( 0., 1. + m[0] - m[4] - m[8] ) ) / 2.;
-	y = std::sqrt( std::max( 0., 1. - m[0] + m[4] - m[8] ) ) / 2.;
-	z = std::sqrt( std::max( 0., 1. - m[0] - m[4] + m[8] ) ) / 2.;
-	x = std::copysign(x, m[7] - m[5]);
-	y = std::copysign(y, m[2] - m[6]);
-	z = std::copysign(z, m[3] - m[1]);
+template <class T>
+void basic_quaternion<T>::fromRotationMatrix(const std::vector<T>& m) {
+	using std::sqrt; using std::copysign;
+	w = sqrt( std::max( T(0), T(1) + m[0] + m[4] + m[8] ) ) / 2;
+	x = sqrt( std::max( T(0), T(1) + m[0] - m[4] - m[8] ) ) / 2;
+	y = sqrt( std::max( T(0), T(1) - m[0] + m[4] - m[8] ) ) / 2;
+	z = sqrt( std::max( T(0), T(1) - m[0] - m[4] + m[8] ) ) / 2;
+	x = copysign(x, m[7] - m[5]);
+	y = copysign(y, m[2] - m[6]);
+	z = copysign(z, m[3] - m[1]);
 	this->normalize();
 }
 
-void quaternion::toRotationMatrix(std::vector<double> &m) const {
-	std::vector<double>(9).swap(m);
-	double wx = w*x;
-	double wy = w*y;
-	double wz = w*z;
-	double xx = x*x;
-	double xy = x*y;
-	double xz = x*z;
-	double yy = y*y;
-	double yz = y*z;
-	double zz = z*z;
+template <class T>
+void basic_quaternion<T>::toRotationMatrix(std::vector<T> &m) const {
+	std::vector<T>(9).swap(m);
+	T wx = w*x;
+	T wy = w*y;
+	T wz = w*z;
+	T xx = x*x;
+	T xy = x*y;
+	T xz = x*z;
+	T yy = y*y;
+	T yz = y*z;
+	T zz = z*z;
 	/* 1st row */
-	m[0] = 1.-2.*(yy+zz);
-	m[1] =    2.*(xy-wz);
-	m[2] =    2.*(wy+xz);
+	m[0] = 1-2*(yy+zz);
+	m[1] =    2*(xy-wz);
+	m[2] =    2*(wy+xz);
 	/* 2nd row */
-	m[3] =    2.*(wz+xy);
-	m[4] = 1.-2.*(xx+zz);
-	m[5] =    2.*(yz-wx);
+	m[3] =    2*(wz+xy);
+	m[4] = 1-2*(xx+zz);
+	m[5] =    2*(yz-wx);
 	/* 3rd row */
-	m[6] =    2.*(xz-wy);
-	m[7] =    2.*(wx+yz);
-	m[8] = 1.-2.*(xx+yy);
+	m[6] =    2*(xz-wy);
+	m[7] =    2*(wx+yz);
+	m[8] = 1-2*(xx+yy);
 
 }
 
-void quaternion::rotateVector(std::vector<double> &v) const {
-	double wx = w*x;
-	double wy = w*y;
-	double wz = w*z;
-	double xx = x*x;
-	double xy = x*y;
-	double xz = x*z;
-	double yy = y*y;
-	double yz = y*z;
-	double zz = z*z;
-	double v1 = 2.*( (-yy - zz)*v[0] + ( xy - wz)*v[1] + ( wy + xz)*v[2] ) + v[0];
-	double v2 = 2.*( ( wz + xy)*v[0] + (-xx - zz)*v[1] + ( yz - wx)*v[2] ) + v[1];
-	double v3 = 2.*( ( xz - wy)*v[0] + ( wx + yz)*v[1] + (-xx - yy)*v[2] ) + v[2];
-	std::vector<double>({v1,v2,v3}).swap(v);
+template <class T>
+void basic_quaternion<T>::rotateVector(std::vector<T> &v) const {
+	T wx = w*x;
+	T wy = w*y;
+	T wz = w*z;
+	T xx = x*x;
+	T xy = x*y;
+	T xz = x*z;
+	T yy = y*y;
+	T yz = y*z;
+	T zz = z*z;
+	T v1 = 2*( (-yy - zz)*v[0] + ( xy - wz)*v[1] + ( wy + xz)*v[2] ) + v[0];
+	T v2 = 2*( ( wz + xy)*v[0] + (-xx - zz)*v[1] + ( yz - wx)*v[2] ) + v[1];
+	T v3 = 2*( ( xz - wy)*v[0] + ( wx + yz)*v[1] + (-xx - yy)*v[2] ) + v[2];
+	std::vector<T>({v1,v2,v3}).swap(v);
 }
 
-void quaternion::multRight(quaternion &q2) {
-	double ww = w*q2.w - x*q2.x - y*q2.y - z*q2.z;
-	double xx = w*q2.x + x*q2.w + y*q2.z - z*q2.y;
-	double yy = w*q2.y + y*q2.w + z*q2.x - x*q2.z;
-	double zz = w*q2.z + z*q2.w + x*q2.y - y*q2.x;
+template <class T>
+void basic_quaternion<T>::multRight(basic_quaternion &q2) {
+	T ww = w*q2.w - x*q2.x - y*q2.y - z*q2.z;
+	T xx = w*q2.x + x*q2.w + y*q2.z - z*q2.y;
+	T yy = w*q2.y + y*q2.w + z*q2.x - x*q2.z;
+	T zz = w*q2.z + z*q2.w + x*q2.y - y*q2.x;
 	w = ww;
 	x = xx;
 	y = yy;
 	z = zz;
 }
 
-void quaternion::multLeft(quaternion &q2) {
-	double ww = q2.w*w - q2.x*x - q2.y*y - q2.z*z;
-	double xx = q2.w*x + q2.x*w + q2.y*z - q2.z*y;
-	double yy = q2.w*y + q2.y*w + q2.z*x - q2.x*z;
-	double zz = q2.w*z + q2.z*w + q2.x*y - q2.y*x;
+template <class T>
+void basic_quaternion<T>::multLeft(basic_quaternion &q2) {
+	T ww = q2.w*w - q2.x*x - q2.y*y - q2.z*z;
+	T xx = q2.w*x + q2.x*w + q2.y*z - q2.z*y;
+	T yy = q2.w*y + q2.y*w + q2.z*x - q2.x*z;
+	T zz = q2.w*z + q2.z*w + q2.x*y - q2.y*x;
 	w = ww;
 	x = xx;
 	y = yy;
@@ -185,34 +213,45 @@ void quaternion::multLeft(quaternion &q2) {
 
 }
 
-double quaternion::rotationAngle() const { return 2.*std::acos(w); }
+template <class T>
+T basic_quaternion<T>::rotationAngle() const { using std::acos; return 2*acos(w); }
 
-void quaternion::rotationAxis(std::vector<double> &v) const {
-	std::vector<double>({x,y,z}).swap(v);
+template <class T>
+void basic_quaternion<T>::rotationAxis(std::vector<T> &v) const {
+	std::vector<T>({x,y,z}).swap(v);
 }
 
-void quaternion::rotationAxis(double &xx, double &yy, double &zz) const {
+template <class T>
+void basic_quaternion<T>::rotationAxis(T &xx, T &yy, T &zz) const {
 	xx = x; yy = y; zz = z;
 }
 
-void quaternion::normalize() {
-	double magnitude = sqrt(w*w + x*x + y*y + z*z);
+template <class T>
+void basic_quaternion<T>::normalize() {
+	using std::sqrt;
+	T magnitude = sqrt(w*w + x*x + y*y + z*z);
 	w /= magnitude;
 	x /= magnitude;
 	y /= magnitude;
 	z /= magnitude;
 }
 
-void quaternion::invert() {
+template <class T>
+void basic_quaternion<T>::invert() {
 	x = -x;
 	y = -y;
 	z = -z;
 }
 
-double quaternion::norm() const {
-	return std::sqrt(w*w+x*x+y*y+z*z);
+template <class T>
+T basic_quaternion<T>::norm() const {
+	using std::sqrt;
+	return sqrt(w*w+x*x+y*y+z*z);
 }
 
+/** Quaternion in double precision */
+typedef basic_quaternion<double> quaternion;
+
 }
 
 #endif
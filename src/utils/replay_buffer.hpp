@@ -0,0 +1,158 @@
+#ifndef L2FSIM_REPLAY_BUFFER_HPP_
+#define L2FSIM_REPLAY_BUFFER_HPP_
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <random>
+#include <vector>
+
+/**
+ * @file replay_buffer.hpp
+ * @brief Fixed-capacity prioritized experience replay
+ * @version 1.0
+ * @since 1.1
+ *
+ * The transitions are stored in a ring preallocated at construction, the oldest one being
+ * overwritten once the capacity is reached. Each transition has a priority p = (|delta| + eps)^alpha
+ * where delta is its last temporal difference error, a new transition getting the maximum priority
+ * seen so far so that it is replayed at least once. The transitions are sampled with probability
+ * p / sum(p) through a sum tree, in O(log n) per sample and per priority update (see Schaul et
+ * al., Prioritized Experience Replay), a minibatch being stratified over the total priority.
+ * The sampling bias is corrected by the importance-sampling weights (n * P(i))^-beta, normalized
+ * by their maximum over the minibatch. No allocation is made after construction.
+ */
+
+namespace L2Fsim {
+
+/** @brief Binary tree of the partial sums of the priorities, stored in an array (root at 1) */
+class sum_tree {
+public:
+    /** @brief Constructor, the number of leaves is the capacity rounded up to a power of 2 */
+    sum_tree(unsigned int capacity=0) : nb_leaves(1) {
+        while(nb_leaves < capacity) {nb_leaves *= 2;}
+        sums.assign(2 * nb_leaves,0.);
+    }
+
+    /** @brief Sum of the priorities */
+    double total() const {return sums[1];}
+
+    /** @brief Priority of a leaf */
+    double get(unsigned int i) const {return sums[nb_leaves + i];}
+
+    /** @brief Set the priority of a leaf and update its ancestors */
+    void set(unsigned int i, double p) {
+        unsigned int k = nb_leaves + i;
+        double dp = p - sums[k];
+        for(; k>=1; k/=2) {sums[k] += dp;}
+    }
+
+    /**
+     * @brief Leaf whose interval of the cumulated priorities contains a value
+     * @param {double} u; value in [0, total())
+     * @note the leaves of priority 0 are never returned, even with rounding errors on the sums
+     */
+    unsigned int find(double u) const {
+        unsigned int k = 1;
+        while(k < nb_leaves) {
+            if(u < sums[2 * k] || !(sums[2 * k + 1] > 0.)) {
+                k = 2 * k;
+            } else {
+                u -= sums[2 * k];
+                k = 2 * k + 1;
+            }
+        }
+        return k - nb_leaves;
+    }
+
+protected:
+    unsigned int nb_leaves;
+    std::vector<double> sums;
+};
+
+template <class T>
+class replay_buffer {
+public:
+    /**
+     * @brief Attributes
+     * @param {double} alpha; priority exponent, 0 for uniform sampling
+     * @param {double} beta; importance-sampling exponent, 1 for a full correction
+     * @param {double} eps; added to the magnitude of the errors, so that every transition can be sampled
+     */
+    double alpha;
+    double beta;
+    double eps;
+
+    /** @brief Constructor, the storage of 'capacity' transitions is allocated */
+    replay_buffer(unsigned int _capacity=0, double _alpha=.6, double _beta=.4, double _eps=1e-3) :
+        alpha(_alpha),
+        beta(_beta),
+        eps(_eps),
+        items(_capacity),
+        tree(_capacity),
+        head(0),
+        count(0),
+        max_priority(1.)
+    {}
+
+    unsigned int capacity() const {return items.size();}
+    unsigned int size() const {return count;}
+    bool empty() const {return count == 0;}
+
+    /** @brief Stored transition */
+    const T & operator[](unsigned int i) const {return items[i];}
+
+    /** @brief Store a transition with the maximum priority, overwriting the oldest one if the buffer is full */
+    void push(const T &t) {
+        assert(capacity() > 0);
+        items[head] = t;
+        tree.set(head,max_priority);
+        head = (head + 1) % capacity();
+        if(count < capacity()) {++count;}
+    }
+
+    /**
+     * @brief Sample a minibatch
+     * @param {G &} generator; random generator
+     * @param {unsigned int} n; size of the minibatch
+     * @param {unsigned int *} indices; sampled transitions, n entries
+     * @param {double *} weights; importance-sampling weights of the sampled transitions, n entries
+     */
+    template <class G>
+    void sample(G &generator, unsigned int n, unsigned int *indices, double *weights) const {
+        assert(count > 0);
+        std::uniform_real_distribution<double> distribution(0.,1.);
+        double total = tree.total();
+        double segment = total / n;
+        double max_w = 0.;
+        for(unsigned int k=0; k<n; ++k) {
+            double u = std::min((k + distribution(generator)) * segment, total * (1. - 1e-12));
+            indices[k] = tree.find(u);
+            weights[k] = pow(count * tree.get(indices[k]) / total, -beta);
+            if(weights[k] > max_w) {max_w = weights[k];}
+        }
+        for(unsigned int k=0; k<n; ++k) {weights[k] /= max_w;}
+    }
+
+    /**
+     * @brief Set the priority of a transition from its last temporal difference error
+     * @param {unsigned int} i; transition
+     * @param {double} delta; temporal difference error
+     */
+    void update_priority(unsigned int i, double delta) {
+        double p = pow(fabs(delta) + eps, alpha);
+        if(p > max_priority) {max_priority = p;}
+        tree.set(i,p);
+    }
+
+protected:
+    std::vector<T> items;
+    sum_tree tree;
+    unsigned int head;
+    unsigned int count;
+    double max_priority;
+};
+
+}
+
+#endif
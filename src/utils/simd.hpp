@@ -0,0 +1,211 @@
+#ifndef L2FSIM_SIMD_HPP_
+#define L2FSIM_SIMD_HPP_
+
+#include <utils.hpp>
+#include <cstring>
+#include <cmath>
+
+/**
+ * @file simd.hpp
+ * @brief Packs of floating point values processed with SIMD instructions
+ * @version 1.0
+ * @since 1.1
+ *
+ * A pack holds 16 bytes (2 doubles or 4 floats), the register width of SSE2 which is always
+ * available on x86-64 (and of NEON on ARM). It is built on the GCC vector extensions (supported
+ * by g++ and clang++), the arithmetic operators and the comparisons being applied element-wise.
+ * The elementary functions of the standard library are scalar; the functions below are
+ * branch-free polynomial versions working on whole packs:
+ * - 'simd_sincos' reduces the argument modulo pi/2 (Cody-Waite) and evaluates polynomials on [-pi/4,pi/4];
+ * - 'simd_atan' reduces the argument to [0,tan(pi/8)] then halves the angle before its Taylor polynomial.
+ * Their error is within a few ulps of the standard library for arguments of moderate magnitude
+ * (|x| < 1e5 for the trigonometric functions), which covers the angles of the flight models.
+ */
+
+namespace L2Fsim {
+
+/**
+ * @brief Pack type
+ *
+ * 'simd<T>::type' is a pack of 'simd<T>::width' values of type 'T' ('double' or 'float').
+ */
+template <class T>
+struct simd {
+    static constexpr unsigned int width = 16 / sizeof(T);
+    typedef T type __attribute__((vector_size(16)));
+};
+
+/**
+ * @brief Load a pack from memory, no alignment is required
+ * @param {const T *} p; address of the first value
+ */
+template <class T>
+inline typename simd<T>::type simd_load(const T *p) {
+    typename simd<T>::type v;
+    std::memcpy(&v,p,sizeof(v));
+    return v;
+}
+
+/**
+ * @brief Store a pack into memory, no alignment is required
+ * @param {T *} p; address of the first value
+ * @param {typename simd<T>::type} v; stored pack
+ */
+template <class T>
+inline void simd_store(T *p, typename simd<T>::type v) {
+    std::memcpy(p,&v,sizeof(v));
+}
+
+/** @brief Pack whose values are all equal to 'x' */
+template <class T>
+inline typename simd<T>::type simd_set(T x) {
+    typename simd<T>::type v = {};
+    return v + x;
+}
+
+/** @brief Element-wise square root */
+template <class T>
+inline typename simd<T>::type simd_sqrt(typename simd<T>::type x) {
+    for(unsigned int k=0; k<simd<T>::width; ++k) {x[k] = std::sqrt(x[k]);}
+    return x;
+}
+
+/** @brief Element-wise minimum */
+template <class T>
+inline typename simd<T>::type simd_min(typename simd<T>::type a, typename simd<T>::type b) {
+    return (a < b) ? a : b;
+}
+
+/** @brief Element-wise maximum */
+template <class T>
+inline typename simd<T>::type simd_max(typename simd<T>::type a, typename simd<T>::type b) {
+    return (a > b) ? a : b;
+}
+
+/** @brief Element-wise 'sign' function, see 'utils.hpp' */
+template <class T>
+inline typename simd<T>::type simd_sign(typename simd<T>::type x) {
+    return (x < simd_set<T>(-COMPARISON_THRESHOLD)) ? simd_set<T>(-1) : simd_set<T>(1);
+}
+
+/**
+ * @brief Constants of the elementary functions
+ *
+ * @param {T} round; adding and subtracting it rounds a value to the nearest integer
+ * @param {T} pio2_1, pio2_2; high and low parts of pi/2
+ */
+template <class T>
+struct simd_constants;
+
+template <>
+struct simd_constants<double> {
+    static constexpr double round = 6755399441055744.; // 1.5*2^52
+    static constexpr double pio2_1 = 1.57079632673412561417e+00; // 33 bits of pi/2
+    static constexpr double pio2_2 = 6.07710050650619224932e-11; // pi/2 - pio2_1
+};
+
+template <>
+struct simd_constants<float> {
+    static constexpr float round = 12582912.f; // 1.5*2^23
+    static constexpr float pio2_1 = 1.5703125f; // 9 bits of pi/2
+    static constexpr float pio2_2 = 4.83826794897e-4f; // pi/2 - pio2_1
+};
+
+/**
+ * @brief Polynomials of the sine and cosine on [-pi/4,pi/4]
+ *
+ * sin(z) = z + z^3 P(z^2) and cos(z) = 1 - z^2/2 + z^4 Q(z^2), coefficients of the Cephes library.
+ * @param {typename simd<T>::type} z2; squared angles
+ */
+inline simd<double>::type simd_sin_poly(simd<double>::type z2) {
+    simd<double>::type p = simd_set(1.58962301576546568060e-10);
+    p = p * z2 - 2.50507477628578072866e-8;
+    p = p * z2 + 2.75573136213857245213e-6;
+    p = p * z2 - 1.98412698295895385996e-4;
+    p = p * z2 + 8.33333333332211858878e-3;
+    return p * z2 - 1.66666666666666307295e-1;
+}
+
+inline simd<double>::type simd_cos_poly(simd<double>::type z2) {
+    simd<double>::type p = simd_set(-1.13585365213876817300e-11);
+    p = p * z2 + 2.08757008419747316778e-9;
+    p = p * z2 - 2.75573141792967388112e-7;
+    p = p * z2 + 2.48015872888517045348e-5;
+    p = p * z2 - 1.38888888888730564116e-3;
+    return p * z2 + 4.16666666666665929218e-2;
+}
+
+inline simd<float>::type simd_sin_poly(simd<float>::type z2) {
+    simd<float>::type p = simd_set(-1.9515295891e-4f);
+    p = p * z2 + 8.3321608736e-3f;
+    return p * z2 - 1.6666654611e-1f;
+}
+
+inline simd<float>::type simd_cos_poly(simd<float>::type z2) {
+    simd<float>::type p = simd_set(2.443315711809948e-5f);
+    p = p * z2 - 1.388731625493765e-3f;
+    return p * z2 + 4.166664568298827e-2f;
+}
+
+/**
+ * @brief Element-wise sine and cosine
+ * @param {typename simd<T>::type} x; angles
+ * @param {typename simd<T>::type &} s, c; sines and cosines
+ */
+template <class T>
+inline void simd_sincos(typename simd<T>::type x, typename simd<T>::type &s, typename simd<T>::type &c) {
+    typedef typename simd<T>::type V;
+    typedef simd_constants<T> K;
+    const V rnd = simd_set<T>(K::round);
+    V n = (x * (T)M_2_PI + rnd) - rnd; // nearest integer of x/(pi/2)
+    V z = (x - n * K::pio2_1) - n * K::pio2_2; // z in [-pi/4,pi/4]
+    V q = n - (T)4 * (((n - (T)1.5) * (T).25 + rnd) - rnd); // quadrant in {0,1,2,3}
+    V z2 = z * z;
+
+    V cz = (T)1 - (T).5 * z2 + z2 * z2 * simd_cos_poly(z2);
+    V sz = z + z * z2 * simd_sin_poly(z2);
+
+    auto odd = (q == (T)1) | (q == (T)3);
+    V sv = odd ? cz : sz;
+    V cv = odd ? sz : cz;
+    s = (q >= (T)2) ? -sv : sv;
+    c = ((q == (T)1) | (q == (T)2)) ? -cv : cv;
+}
+
+/**
+ * @brief Element-wise arc tangent
+ * @param {typename simd<T>::type} x; values
+ * @return {typename simd<T>::type} the arc tangents, in [-pi/2,pi/2]
+ */
+template <class T>
+inline typename simd<T>::type simd_atan(typename simd<T>::type x) {
+    typedef typename simd<T>::type V;
+    const V zero = simd_set<T>(0);
+    const V one = simd_set<T>(1);
+    V t = (x < zero) ? -x : x;
+    auto big = t > (T)2.41421356237309504880; // tan(3*pi/8)
+    auto mid = t > (T).41421356237309504880; // tan(pi/8)
+    V u = big ? -one / t : (mid ? (t - one) / (t + one) : t);
+    V off = big ? simd_set<T>((T)M_PI_2) : (mid ? simd_set<T>((T)M_PI_4) : zero);
+
+    // atan(u) = 2 atan(v) with |v| <= tan(pi/16), Taylor remainder below 1e-19
+    V v = u / (one + simd_sqrt<T>(one + u * u));
+    V v2 = v * v;
+    V p = simd_set<T>((T)(-1./23.));
+    p = p * v2 + (T)(1./21.);
+    p = p * v2 - (T)(1./19.);
+    p = p * v2 + (T)(1./17.);
+    p = p * v2 - (T)(1./15.);
+    p = p * v2 + (T)(1./13.);
+    p = p * v2 - (T)(1./11.);
+    p = p * v2 + (T)(1./9.);
+    p = p * v2 - (T)(1./7.);
+    p = p * v2 + (T)(1./5.);
+    p = p * v2 - (T)(1./3.);
+    V a = off + (T)2 * (v + v * v2 * p);
+    return (x < zero) ? -a : a;
+}
+
+}
+
+#endif // L2FSIM_SIMD_HPP_
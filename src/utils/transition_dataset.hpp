@@ -0,0 +1,359 @@
+#ifndef L2FSIM_TRANSITION_DATASET_HPP_
+#define L2FSIM_TRANSITION_DATASET_HPP_
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <simulation.hpp>
+#include <pilot_io.hpp>
+#include <beeler_glider/beeler_glider_state.hpp>
+#include <beeler_glider/beeler_glider_command.hpp>
+#include <glider_reward.hpp>
+
+/**
+ * @file transition_dataset.hpp
+ * @brief Chunked columnar binary files of transitions (s, a, r, s_p, done) for offline learning
+ * @version 1.0
+ * @since 1.1
+ * @note compatibility: 'beeler_glider.hpp'; 'beeler_glider_state.hpp'; 'beeler_glider_command.hpp'
+ *
+ * A 'transition_writer' is set as the 'recorder' of a simulation and records each step, whatever
+ * the pilot, the reward being 'glider_reward' at s_p. The rows are
+ * buffered column by column and written by chunks of 'chunk_size' rows, one contiguous write per
+ * column, hence the recording costs a few stores per variable and the writing is I/O-bound.
+ * Files of a dataset 'prefix':
+ * - 'prefix.NNNN.dat', shard NNNN: header (magic "L2FD", version, byte order mark, number of
+ *   columns, then the name and type of each column, see 'column_names' and 'column_types'),
+ *   followed by the chunks; a chunk is its number of rows (uint32) then each column in order;
+ * - 'prefix.NNNN.idx', index of shard NNNN: for each chunk its offset in the shard (uint64) and
+ *   its number of rows (uint32), appended when the chunk is written.
+ * Each writer owns a shard, hence several simulations (e.g. one per thread) record the same
+ * dataset without synchronisation. A 'transition_dataset' opens the consecutive shards of a
+ * prefix and reads any row from the indices, e.g. to sample minibatches uniformly.
+ * The values are in the byte order of the machine, see 'pilot_io.hpp'.
+ */
+
+namespace L2Fsim {
+
+static constexpr std::uint32_t transition_dataset_version = 1;
+
+/** @brief Transition of a dataset, the states and the command in single precision */
+struct transition_row {
+    static constexpr unsigned int nb_state_variables = 15;
+    typedef std::array<float, nb_state_variables> state_type; ///< x, y, z, V, gamma, khi, alpha, beta, sigma, xdot, ydot, zdot, Vdot, gammadot, khidot
+
+    double time; ///< Time of s
+    state_type s; ///< State before the step
+    std::array<float, 3> a; ///< Command applied during the step: dalpha, dbeta, dsigma
+    float reward; ///< Reward 'glider_reward' at s_p
+    state_type s_p; ///< State after the step
+    std::uint8_t done; ///< 1 if the step ended the simulation
+    std::uint32_t episode; ///< Episode of the writer
+
+    static void pack(const beeler_glider_state &s, state_type &v) {
+        v = {{(float) s.x, (float) s.y, (float) s.z, (float) s.V, (float) s.gamma, (float) s.khi,
+              (float) s.alpha, (float) s.beta, (float) s.sigma,
+              (float) s.xdot, (float) s.ydot, (float) s.zdot, (float) s.Vdot, (float) s.gammadot, (float) s.khidot}};
+    }
+
+    static void unpack(const state_type &v, beeler_glider_state &s) {
+        s.x = v[0]; s.y = v[1]; s.z = v[2]; s.V = v[3]; s.gamma = v[4]; s.khi = v[5];
+        s.alpha = v[6]; s.beta = v[7]; s.sigma = v[8];
+        s.xdot = v[9]; s.ydot = v[10]; s.zdot = v[11]; s.Vdot = v[12]; s.gammadot = v[13]; s.khidot = v[14];
+    }
+};
+
+/**
+ * @brief Columns of a dataset
+ *
+ * Column 0 is 'time' (double), columns 1 to 34 are the floats of s, a, reward and s_p in the
+ * order of 'transition_row', then 'done' (uint8) and 'episode' (uint32).
+ */
+class transition_columns {
+public:
+    static constexpr unsigned int nb_floats = 2 * transition_row::nb_state_variables + 4;
+    static constexpr unsigned int nb_columns = nb_floats + 3;
+
+    static const std::vector<std::string> & column_names() {
+        static const std::vector<std::string> names = {
+            "time",
+            "x","y","z","V","gamma","khi","alpha","beta","sigma","xdot","ydot","zdot","Vdot","gammadot","khidot",
+            "dalpha","dbeta","dsigma","reward",
+            "x_p","y_p","z_p","V_p","gamma_p","khi_p","alpha_p","beta_p","sigma_p","xdot_p","ydot_p","zdot_p","Vdot_p","gammadot_p","khidot_p",
+            "done","episode"};
+        return names;
+    }
+
+    /** @brief Type of each column: 'd' double; 'f' float; 'B' uint8; 'I' uint32 (as in Python's 'struct') */
+    static const std::string & column_types() {
+        static const std::string types = "d" + std::string(nb_floats,'f') + "BI";
+        return types;
+    }
+
+    /** @brief Size of a value of a column (bytes) */
+    static unsigned int column_size(unsigned int c) {
+        return (c == 0) ? 8 : ((c <= nb_floats) ? 4 : ((c == nb_floats + 1) ? 1 : 4));
+    }
+
+    /** @brief Path of a shard file, or of its index with 'ext = "idx"' */
+    static std::string shard_path(const std::string &prefix, unsigned int shard, const std::string &ext="dat") {
+        char buf[16];
+        std::snprintf(buf,sizeof(buf),".%04u.",shard);
+        return prefix + buf + ext;
+    }
+};
+
+class transition_writer : public transition_recorder {
+public:
+    /**
+     * @brief Constructor, the shard and its index are overwritten
+     * @param {const std::string &} prefix; prefix of the files of the dataset
+     * @param {unsigned int} shard; shard of the writer, distinct for each concurrent writer
+     * @param {unsigned int} _chunk_size; number of rows of a chunk
+     */
+    transition_writer(const std::string &prefix, unsigned int shard=0, unsigned int _chunk_size=1<<16) :
+        chunk_size(std::max(1u,_chunk_size)),
+        nb_rows(0),
+        nb_written(0),
+        episode(0),
+        times(chunk_size),
+        floats(transition_columns::nb_floats * chunk_size),
+        dones(chunk_size),
+        episodes(chunk_size),
+        os(transition_columns::shard_path(prefix,shard),std::ofstream::binary),
+        index(transition_columns::shard_path(prefix,shard,"idx"),std::ofstream::binary)
+    {
+        if(!os || !index) {throw std::runtime_error("transition_writer: cannot open the shard " + std::to_string(shard) + " of " + prefix);}
+        os.write("L2FD",4);
+        write_binary(os,transition_dataset_version);
+        write_binary(os,pilot_io_byte_order);
+        write_binary(os,(std::uint32_t) transition_columns::nb_columns);
+        for(unsigned int c=0; c<transition_columns::nb_columns; ++c) {
+            write_name(os,transition_columns::column_names()[c]);
+            os.put(transition_columns::column_types()[c]);
+        }
+    }
+
+    /** @brief Destructor, the last chunk is written, a write error is reported to std::cerr (see 'flush') */
+    ~transition_writer() {
+        try {
+            flush();
+        } catch(const std::exception &e) {
+            std::cerr << e.what() << std::endl;
+        }
+    }
+
+    /** @brief Start a new episode, e.g. when the simulation is reset */
+    void begin_episode() {++episode;}
+
+    void begin_transition(const state &_s) override {
+        const beeler_glider_state &s = dynamic_cast <const beeler_glider_state &> (_s);
+        times[nb_rows] = s.time;
+        transition_row::pack(s,pending);
+    }
+
+    void end_transition(const command &_a, const state &_s_p, bool eos) override {
+        const beeler_glider_command &a = dynamic_cast <const beeler_glider_command &> (_a);
+        const beeler_glider_state &s_p = dynamic_cast <const beeler_glider_state &> (_s_p);
+        transition_row::state_type v_p;
+        transition_row::pack(s_p,v_p);
+        float *f = floats.data() + nb_rows;
+        unsigned int c = 0;
+        for(float x : pending) {f[(c++) * chunk_size] = x;}
+        f[(c++) * chunk_size] = a.dalpha;
+        f[(c++) * chunk_size] = a.dbeta;
+        f[(c++) * chunk_size] = a.dsigma;
+        f[(c++) * chunk_size] = glider_reward(s_p);
+        for(float x : v_p) {f[(c++) * chunk_size] = x;}
+        dones[nb_rows] = eos ? 1 : 0;
+        episodes[nb_rows] = episode;
+        if(++nb_rows == chunk_size) {flush();}
+    }
+
+    /**
+     * @brief Write the buffered rows as a chunk
+     * @throw std::runtime_error if the writing fails
+     */
+    void flush() {
+        if(nb_rows == 0) {return;}
+        std::uint64_t offset = (std::uint64_t) os.tellp();
+        write_binary(os,(std::uint32_t) nb_rows);
+        os.write(reinterpret_cast<const char *>(times.data()),nb_rows * sizeof(double));
+        for(unsigned int c=0; c<transition_columns::nb_floats; ++c) {
+            os.write(reinterpret_cast<const char *>(floats.data() + c * chunk_size),nb_rows * sizeof(float));
+        }
+        os.write(reinterpret_cast<const char *>(dones.data()),nb_rows);
+        os.write(reinterpret_cast<const char *>(episodes.data()),nb_rows * sizeof(std::uint32_t));
+        os.flush();
+        write_binary(index,offset);
+        write_binary(index,(std::uint32_t) nb_rows);
+        index.flush();
+        if(!os || !index) {throw std::runtime_error("transition_writer: error while writing a chunk");}
+        nb_written += nb_rows;
+        nb_rows = 0;
+    }
+
+    /** @brief Number of recorded rows, written or buffered */
+    unsigned long size() const {return nb_written + nb_rows;}
+
+protected:
+    unsigned int chunk_size;
+    unsigned int nb_rows; ///< Buffered rows
+    unsigned long nb_written; ///< Written rows
+    std::uint32_t episode;
+    transition_row::state_type pending; ///< State of the started transition
+    std::vector<double> times;
+    std::vector<float> floats; ///< Float columns of the chunk, column c at c * chunk_size
+    std::vector<std::uint8_t> dones;
+    std::vector<std::uint32_t> episodes;
+    std::ofstream os;
+    std::ofstream index;
+};
+
+class transition_dataset {
+public:
+    /**
+     * @brief Constructor, open the shards 0, 1, ... of a prefix until one is missing
+     * @param {const std::string &} prefix; prefix of the files of the dataset
+     * @throw std::runtime_error if there is no shard or a shard has another format
+     */
+    transition_dataset(const std::string &prefix) : nb_rows(0) {
+        for(unsigned int k=0; ; ++k) {
+            std::ifstream idx(transition_columns::shard_path(prefix,k,"idx"),std::ifstream::binary);
+            if(!idx) {break;}
+            shards.emplace_back(new std::ifstream());
+            shards.back()->rdbuf()->pubsetbuf(nullptr,0); // a row is read by small reads scattered over a chunk
+            shards.back()->open(transition_columns::shard_path(prefix,k),std::ifstream::binary);
+            check_header(*shards.back());
+            std::uint64_t offset;
+            std::uint32_t n;
+            while(idx.read(reinterpret_cast<char *>(&offset),sizeof(offset)) && idx.read(reinterpret_cast<char *>(&n),sizeof(n))) {
+                chunks.push_back({k,offset,n,nb_rows});
+                nb_rows += n;
+            }
+        }
+        if(shards.empty()) {throw std::runtime_error("transition_dataset: no shard of " + prefix);}
+    }
+
+    /** @brief Number of rows of the dataset */
+    unsigned long size() const {return nb_rows;}
+
+    /** @brief Number of chunks of the dataset */
+    unsigned int nb_chunks() const {return chunks.size();}
+
+    /**
+     * @brief Read a row
+     * @param {unsigned long} i; row, in [0, size())
+     * @param {transition_row &} r; read row
+     * @throw std::out_of_range if the row is not in the dataset
+     */
+    void read(unsigned long i, transition_row &r) {
+        if(i >= nb_rows) {throw std::out_of_range("transition_dataset: row " + std::to_string(i) + " of a dataset of " + std::to_string(nb_rows) + " rows");}
+        const chunk &ch = *(std::upper_bound(chunks.begin(),chunks.end(),i,
+            [](unsigned long j, const chunk &c) {return j < c.first_row;}) - 1);
+        unsigned long k = i - ch.first_row;
+        std::ifstream &is = *shards[ch.shard];
+        std::uint64_t column = ch.offset + sizeof(std::uint32_t);
+        read_at(is,column + k * 8,&r.time,8);
+        column += ch.nb_rows * 8;
+        for(unsigned int j=0; j<transition_columns::nb_floats; ++j) {
+            read_at(is,column + k * 4,float_of_row(r,j),4);
+            column += ch.nb_rows * 4;
+        }
+        read_at(is,column + k,&r.done,1);
+        column += ch.nb_rows;
+        read_at(is,column + k * 4,&r.episode,4);
+    }
+
+    /**
+     * @brief Read all the rows of a chunk with a single read, for sequential passes over a dataset
+     * @param {unsigned int} c; chunk, in [0, nb_chunks())
+     * @param {std::vector<transition_row> &} rows; rows of the chunk
+     * @throw std::out_of_range if the chunk is not in the dataset
+     */
+    void read_chunk(unsigned int c, std::vector<transition_row> &rows) {
+        if(c >= chunks.size()) {throw std::out_of_range("transition_dataset: chunk " + std::to_string(c) + " of a dataset of " + std::to_string(chunks.size()) + " chunks");}
+        const chunk &ch = chunks[c];
+        std::size_t n = ch.nb_rows;
+        buffer.resize(n * row_size);
+        read_at(*shards[ch.shard],ch.offset + sizeof(std::uint32_t),buffer.data(),buffer.size());
+        rows.resize(n);
+        const char *col = buffer.data();
+        for(std::size_t k=0; k<n; ++k) {std::memcpy(&rows[k].time,col + k * 8,8);}
+        col += n * 8;
+        for(unsigned int j=0; j<transition_columns::nb_floats; ++j) {
+            for(std::size_t k=0; k<n; ++k) {std::memcpy(float_of_row(rows[k],j),col + k * 4,4);}
+            col += n * 4;
+        }
+        for(std::size_t k=0; k<n; ++k) {rows[k].done = (std::uint8_t) col[k];}
+        col += n;
+        for(std::size_t k=0; k<n; ++k) {std::memcpy(&rows[k].episode,col + k * 4,4);}
+    }
+
+    /**
+     * @brief Read rows drawn uniformly
+     * @param {G &} generator; random generator
+     * @param {std::vector<transition_row> &} rows; read rows, its size is the number of drawn rows
+     * @throw std::runtime_error if the dataset has no row
+     */
+    template <class G>
+    void sample(G &generator, std::vector<transition_row> &rows) {
+        if(nb_rows == 0) {throw std::runtime_error("transition_dataset: cannot sample an empty dataset");}
+        std::uniform_int_distribution<unsigned long> distribution(0,nb_rows-1);
+        for(auto &r : rows) {read(distribution(generator),r);}
+    }
+
+protected:
+    struct chunk {
+        unsigned int shard;
+        std::uint64_t offset;
+        std::uint32_t nb_rows;
+        unsigned long first_row;
+    };
+
+    static constexpr std::size_t row_size = 8 + 4 * transition_columns::nb_floats + 1 + 4; ///< Bytes of a row in a chunk
+
+    std::vector<std::unique_ptr<std::ifstream>> shards;
+    std::vector<chunk> chunks;
+    unsigned long nb_rows;
+    std::vector<char> buffer; ///< Chunk read by 'read_chunk'
+
+    /** @brief j-th float of a row in the order of the columns */
+    static float * float_of_row(transition_row &r, unsigned int j) {
+        const unsigned int ns = transition_row::nb_state_variables;
+        if(j < ns) {return &r.s[j];}
+        if(j < ns + 3) {return &r.a[j - ns];}
+        if(j == ns + 3) {return &r.reward;}
+        return &r.s_p[j - ns - 4];
+    }
+
+    static void read_at(std::ifstream &is, std::uint64_t pos, void *v, std::size_t n) {
+        is.seekg(pos);
+        if(!is.read(reinterpret_cast<char *>(v),n)) {throw std::runtime_error("transition_dataset: unexpected end of shard");}
+    }
+
+    static void check_header(std::ifstream &is) {
+        char magic[4];
+        std::uint32_t version = 0, byte_order = 0, nb_columns = 0;
+        if(!is.read(magic,4) || std::string(magic,4) != "L2FD") {throw std::runtime_error("transition_dataset: not a shard");}
+        read_binary(is,version);
+        read_binary(is,byte_order);
+        read_binary(is,nb_columns);
+        if(version != transition_dataset_version || byte_order != pilot_io_byte_order || nb_columns != transition_columns::nb_columns) {
+            throw std::runtime_error("transition_dataset: shard of another version, byte order or layout");
+        }
+    }
+};
+
+}
+
+#endif
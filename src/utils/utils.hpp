@@ -98,6 +98,30 @@ double sign(T x) {
     return (is_less_than(x,0.)) ? -1. : 1.;
 }
 
+/**
+ * @brief Wrap an angle
+ *
+ * Template method.
+ * @return Return the angle equal to x modulo 2pi lying in [-pi,pi]
+ */
+template <class T>
+inline T wrap_angle(T x) {
+    if(-M_PI <= x && x <= M_PI) {return x;}
+    using std::remainder;
+    return remainder(x,(T)(2.*M_PI));
+}
+
+/**
+ * @brief Value of a scalar
+ *
+ * Template method. Overloaded by the dual numbers of 'dual.hpp' to drop the derivatives.
+ * @return Return x converted to double
+ */
+template <class T>
+inline double value_of(const T &x) {
+    return x;
+}
+
 /**
  * @brief Shuffle
  *
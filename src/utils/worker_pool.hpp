@@ -0,0 +1,119 @@
+#ifndef L2FSIM_WORKER_POOL_HPP_
+#define L2FSIM_WORKER_POOL_HPP_
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @file worker_pool.hpp
+ * @brief Pool of persistent threads running parallel loops
+ * @version 1.0
+ * @since 1.1
+ *
+ * The threads are created once and wait for the next loop, so that short loops (a few
+ * tree expansions) are not dominated by the creation of threads. The calling thread takes part
+ * in the loops as thread 0.
+ * @note compile with '-pthread'
+ */
+
+namespace L2Fsim {
+
+class worker_pool {
+public:
+    /**
+     * @brief Constructor
+     * @param {unsigned int} nb_threads; number of threads including the calling thread
+     */
+    worker_pool(unsigned int nb_threads) :
+        next_task(0),
+        generation(0),
+        nb_running(0),
+        stop(false)
+    {
+        for(unsigned int i=1; i<nb_threads; ++i) {
+            threads.emplace_back(&worker_pool::work,this,i);
+        }
+    }
+
+    worker_pool(const worker_pool &) = delete;
+    worker_pool & operator=(const worker_pool &) = delete;
+
+    /** @brief Destructor, join the threads */
+    ~worker_pool() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stop = true;
+        }
+        start.notify_all();
+        for(auto &th : threads) {th.join();}
+    }
+
+    /** @brief Number of threads including the calling thread */
+    unsigned int size() const {return threads.size() + 1;}
+
+    /**
+     * @brief Run a parallel loop
+     *
+     * The tasks are taken one by one by the threads, the method returns when all of them are done.
+     * @param {unsigned int} n; number of tasks
+     * @param {const std::function<void(unsigned int, unsigned int)> &} f; task, called with the indice of the task and the indice of the thread
+     */
+    void run(unsigned int n, const std::function<void(unsigned int, unsigned int)> &f) {
+        if(threads.size() == 0 || n <= 1) {
+            for(unsigned int i=0; i<n; ++i) {f(i,0);}
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            task = &f;
+            nb_tasks = n;
+            next_task = 0;
+            nb_running = threads.size();
+            ++generation;
+        }
+        start.notify_all();
+        take_tasks(0);
+        std::unique_lock<std::mutex> lock(mtx);
+        done.wait(lock,[this]{return nb_running == 0;});
+        task = nullptr;
+    }
+
+protected:
+    std::vector<std::thread> threads;
+    std::mutex mtx;
+    std::condition_variable start; ///< Notified when a loop starts or when the pool stops
+    std::condition_variable done; ///< Notified when the last thread finishes its tasks
+    const std::function<void(unsigned int, unsigned int)> *task = nullptr;
+    unsigned int nb_tasks = 0;
+    std::atomic<unsigned int> next_task;
+    unsigned int generation;
+    unsigned int nb_running;
+    bool stop;
+
+    void take_tasks(unsigned int id) {
+        for(unsigned int i=next_task++; i<nb_tasks; i=next_task++) {(*task)(i,id);}
+    }
+
+    void work(unsigned int id) {
+        unsigned int seen = 0;
+        while(true) {
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                start.wait(lock,[this,seen]{return stop || generation != seen;});
+                if(stop) {return;}
+                seen = generation;
+            }
+            take_tasks(id);
+            std::lock_guard<std::mutex> lock(mtx);
+            if(--nb_running == 0) {done.notify_one();}
+        }
+    }
+};
+
+}
+
+#endif
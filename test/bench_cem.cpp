@@ -0,0 +1,91 @@
+#include <iostream>
+#include <iomanip>
+#include <ctime>
+#include "bench_fixture.hpp"
+#include <optimistic/optimistic_pilot.hpp>
+#include <cem/cem_pilot.hpp>
+
+/**
+ * Benchmark of 'cem_pilot' ('cem_pilot.hpp')
+ * 1. Cost of a rollout sub-step per plan, the population being propagated as the lanes of
+ *    'beeler_glider_batch' or plan by plan with 'optimistic_pilot::transition_function';
+ * 2. Mean final altitude and CPU time per decision in closed loop, from random initial positions
+ *    and headings, of 'optimistic_pilot' and of 'cem_pilot' with and without warm start.
+ */
+
+using namespace L2Fsim;
+using bench::sc_path;
+using bench::envt_cfg_path;
+using bench::random_initial_state;
+
+const double arm = 2. * TO_RAD;
+const double kdalpha = .01;
+const double time_step_width = .1;
+const double plan_step_width = 1.;
+const double episode_duration = 100.;
+const unsigned int nb_episodes = 8;
+
+/** @brief 'cem_pilot' whose plans are reset at each decision */
+class cold_cem_pilot : public cem_pilot {
+public:
+    using cem_pilot::cem_pilot;
+    pilot & operator()(state &s, command &a) override {
+        plan_time = -1e300;
+        return cem_pilot::operator()(s,a);
+    }
+};
+
+/**
+ * @brief Mean final altitude of a pilot over some episodes
+ * @param {double &} cpu_ms; CPU time per time step (ms)
+ */
+double closed_loop(pilot &pl, double &cpu_ms) {
+    return bench::closed_loop(pl,100,nb_episodes,episode_duration,time_step_width,&cpu_ms);
+}
+
+int main() {
+    beeler_glider ac_model(random_initial_state(0),beeler_glider_command());
+    std::cout << std::fixed;
+
+    // 1. Rollouts
+    cem_pilot cem(ac_model,sc_path,envt_cfg_path,0.,arm,kdalpha,plan_step_width,time_step_width,.9,256,10,1,32,.5,.1,1,1);
+    beeler_glider_state s0 = random_initial_state(0);
+    cem.warm_start(0.);
+    cem.sample_plans(true);
+    const unsigned int nb_rounds = 20;
+    double nb_sub_steps = (double) nb_rounds * cem.population * cem.horizon * (plan_step_width / time_step_width);
+    std::clock_t start = std::clock();
+    for(unsigned int r=0; r<nb_rounds; ++r) {cem.rollout_population(s0);}
+    double batch_ns = (double) (std::clock() - start) / CLOCKS_PER_SEC / nb_sub_steps * 1e9;
+    volatile double sink = 0.;
+    start = std::clock();
+    for(unsigned int r=0; r<nb_rounds; ++r) {
+        for(unsigned int j=0; j<cem.population; ++j) {
+            ac_model.set_state(s0);
+            double t = 0.;
+            for(unsigned int k=0; k<cem.horizon; ++k) {
+                beeler_glider_state &s = ac_model.s;
+                ac_model.set_command(beeler_glider_command(kdalpha*(0.-s.gammadot),0.,cem.plans[j*cem.horizon+k]*arm));
+                optimistic_pilot::transition_function(ac_model,cem.fz,t,plan_step_width,time_step_width);
+                sink += glider_reward(s);
+            }
+        }
+    }
+    double scalar_ns = (double) (std::clock() - start) / CLOCKS_PER_SEC / nb_sub_steps * 1e9;
+    std::cout << std::setprecision(1) << "rollout sub-step per plan: batch " << batch_ns << " ns, plan by plan " << scalar_ns << " ns" << std::endl;
+
+    // 2. Closed loop
+    double cpu = 0., z = 0.;
+    for(unsigned int budget : {200, 4000}) {
+        optimistic_pilot opt(ac_model,sc_path,envt_cfg_path,0.,arm,kdalpha,time_step_width,time_step_width,.9,budget);
+        z = closed_loop(opt,cpu);
+        std::cout << "optimistic_pilot budget " << budget << ": " << std::setprecision(1) << z << " m, " << std::setprecision(3) << cpu << " ms per decision" << std::endl;
+    }
+    cem_pilot warm(ac_model,sc_path,envt_cfg_path,0.,arm,kdalpha,plan_step_width,time_step_width,.9,64,10,4,8,.5,.1,1,1);
+    z = closed_loop(warm,cpu);
+    std::cout << "cem_pilot 64x10x4 warm start: " << std::setprecision(1) << z << " m, " << std::setprecision(3) << cpu << " ms per decision" << std::endl;
+    cold_cem_pilot cold(ac_model,sc_path,envt_cfg_path,0.,arm,kdalpha,plan_step_width,time_step_width,.9,64,10,4,8,.5,.1,1,1);
+    z = closed_loop(cold,cpu);
+    std::cout << "cem_pilot 64x10x4 cold start: " << std::setprecision(1) << z << " m, " << std::setprecision(3) << cpu << " ms per decision" << std::endl;
+    return 0;
+}
@@ -0,0 +1,119 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <map>
+#include <queue>
+#include <random>
+#include <ctime>
+#include <cassert>
+#include <dary_heap.hpp>
+
+/**
+ * Micro-benchmark of the leaf queue of 'optimistic_pilot.hpp'
+ * The operations of a planning tree are replayed: each expansion pops the leaf of highest key and
+ * pushes 3 children sharing a key slightly lower than their parent's one. The queue is cleared
+ * between decisions. The sequences of popped indices are checked to be the same as with a
+ * 'std::multimap' (the last inserted among equal keys is on top).
+ */
+
+using namespace L2Fsim;
+
+/** @brief Keys of the children of the n-th expansion */
+struct scenario {
+    std::vector<double> dkey;
+    scenario(unsigned int n) : dkey(n) {
+        std::mt19937 gen(42);
+        std::uniform_real_distribution<double> unif(0.,1e-2);
+        for(auto &d : dkey) {d = unif(gen);}
+    }
+};
+
+struct multimap_queue {
+    std::multimap<double, unsigned int> m;
+    void clear() {m.clear();}
+    void push(double k, unsigned int v) {m.emplace(k,v);}
+    unsigned int pop(double &k) {
+        auto it = --m.end();
+        unsigned int v = it->second;
+        k = it->first;
+        m.erase(it);
+        return v;
+    }
+};
+
+struct binary_heap_queue {
+    typedef std::pair<std::pair<double, unsigned int>, unsigned int> entry; // ((key, insertion number), index)
+    std::priority_queue<entry> q;
+    unsigned int seq = 0;
+    void clear() {q = std::priority_queue<entry>(); seq = 0;}
+    void push(double k, unsigned int v) {q.push(entry(std::make_pair(k,seq++),v));}
+    unsigned int pop(double &k) {
+        unsigned int v = q.top().second;
+        k = q.top().first.first;
+        q.pop();
+        return v;
+    }
+};
+
+template <unsigned int D>
+struct dary_queue {
+    dary_heap<D> h;
+    void clear() {h.clear();}
+    void push(double k, unsigned int v) {h.push(k,v);}
+    unsigned int pop(double &k) {
+        unsigned int v = h.top().value;
+        k = h.top().key;
+        h.pop();
+        return v;
+    }
+};
+
+/**
+ * @brief Replay the decisions
+ * @return {double} CPU time per queue operation (ns)
+ */
+template <class Q>
+double replay(Q &q, const scenario &sc, unsigned int budget, unsigned int nb_decisions, std::vector<unsigned int> &popped) {
+    popped.clear();
+    std::clock_t c0 = std::clock();
+    for(unsigned int d=0; d<nb_decisions; ++d) {
+        q.clear();
+        q.push(0.,0);
+        unsigned int nb_nodes = 1;
+        for(unsigned int i=0; i<budget; ++i) {
+            double k;
+            unsigned int v = q.pop(k);
+            if(d == 0) {popped.push_back(v);}
+            double kc = k - sc.dkey[i];
+            for(unsigned int c=0; c<3; ++c) {q.push(kc,nb_nodes++);}
+        }
+    }
+    double cpu = double(std::clock() - c0) / CLOCKS_PER_SEC;
+    return cpu / (4. * budget * nb_decisions) * 1e9;
+}
+
+template <class Q>
+void run(const char *name, const scenario &sc, unsigned int budget, unsigned int nb_decisions, const std::vector<unsigned int> &ref) {
+    Q q;
+    std::vector<unsigned int> popped;
+    double ns = replay(q,sc,budget,nb_decisions,popped);
+    if(ref.size() != 0) {assert(popped == ref);}
+    std::cout << "  " << std::left << std::setw(22) << name << std::right << std::setw(8) << std::fixed << std::setprecision(1) << ns << " ns/op" << std::endl;
+}
+
+int main() {
+    for(unsigned int budget : {1000u, 10000u, 100000u}) {
+        unsigned int nb_decisions = 2000000 / budget;
+        scenario sc(budget);
+        std::cout << "budget " << budget << " (" << 2*budget+1 << " leaves at the end of a decision), " << nb_decisions << " decisions" << std::endl;
+        multimap_queue mq;
+        std::vector<unsigned int> ref;
+        replay(mq,sc,budget,1,ref);
+        run<multimap_queue>("std::multimap",sc,budget,nb_decisions,ref);
+        run<binary_heap_queue>("std::priority_queue",sc,budget,nb_decisions,ref);
+        run<dary_queue<2> >("dary_heap<2>",sc,budget,nb_decisions,ref);
+        run<dary_queue<4> >("dary_heap<4>",sc,budget,nb_decisions,ref);
+        run<dary_queue<8> >("dary_heap<8>",sc,budget,nb_decisions,ref);
+    }
+    return 0;
+}
@@ -0,0 +1,95 @@
+#ifndef L2FSIM_BENCH_FIXTURE_HPP_
+#define L2FSIM_BENCH_FIXTURE_HPP_
+
+#include <ctime>
+#include <random>
+#include <string>
+#include <utils.hpp>
+#include <aircraft.hpp>
+#include <beeler_glider/beeler_glider.hpp>
+#include <flight_zone.hpp>
+#include <flat_zone.hpp>
+#include <flat_thermal_soaring_zone.hpp>
+#include <stepper.hpp>
+#include <euler_integrator.hpp>
+#include <pilot.hpp>
+#include <simulation.hpp>
+
+/**
+ * Episodes of the benchmarks of 'test/'
+ * The glider starts 500 m high in the scenario of 'config/' and is stepped by an Euler integrator.
+ * The pilots run by 'run_episode' and 'closed_loop' are owned by the caller and are not set in
+ * 'simulation::pl'.
+ */
+
+namespace bench {
+
+const std::string sc_path = "config/fz_scenario.csv";
+const std::string envt_cfg_path = "config/fz_config.csv";
+
+/** @brief Initial state of an episode */
+inline L2Fsim::beeler_glider_state initial_state(double x=0., double y=0., double khi=90*L2Fsim::TO_RAD) {
+    return L2Fsim::beeler_glider_state(x,y,500.,14.,-1.5*L2Fsim::TO_RAD,khi,0.,0.,0.,40*L2Fsim::TO_RAD);
+}
+
+/** @brief Initial state of an episode, at a random position and heading drawn from its indice */
+inline L2Fsim::beeler_glider_state random_initial_state(unsigned int episode) {
+    std::mt19937 gen(episode);
+    std::uniform_real_distribution<double> pos(-1000.,1000.), khi(-180.,180.);
+    double x = pos(gen);
+    double y = pos(gen);
+    return initial_state(x,y,khi(gen)*L2Fsim::TO_RAD);
+}
+
+/** @brief Set up a simulation for an episode, the flight zone is loaded if null */
+inline void setup(L2Fsim::simulation &sim, const L2Fsim::beeler_glider_state &s, double time_step_width=.1) {
+    if(!sim.fz) {
+        sim.fz.reset(new L2Fsim::flat_thermal_soaring_zone(sc_path,envt_cfg_path));
+    }
+    sim.ac.reset(new L2Fsim::beeler_glider(s,L2Fsim::beeler_glider_command()));
+    sim.st.reset(new L2Fsim::euler_integrator(time_step_width));
+}
+
+/**
+ * @brief Run an episode set up with 'setup'
+ * @return {unsigned int} number of time steps
+ */
+inline unsigned int run_episode(L2Fsim::simulation &sim, L2Fsim::pilot &pl, double duration, double time_step_width=.1) {
+    double t = 0.;
+    bool eos = false;
+    unsigned int nb_steps = 0;
+    while(!eos && t < duration) {
+        (*sim.st)(*sim.fz,*sim.ac,pl,t,time_step_width,eos);
+        ++nb_steps;
+    }
+    return nb_steps;
+}
+
+/**
+ * @brief Mean final altitude of a pilot over episodes from random initial states
+ * @param {double *} cpu_ms; if not null, CPU time per time step (ms)
+ */
+inline double closed_loop(
+    L2Fsim::pilot &pl,
+    unsigned int first_episode,
+    unsigned int nb_episodes,
+    double duration,
+    double time_step_width=.1,
+    double *cpu_ms=nullptr)
+{
+    L2Fsim::simulation sim;
+    double z = 0.;
+    unsigned int nb_steps = 0;
+    std::clock_t start = std::clock();
+    for(unsigned int e=first_episode; e<first_episode+nb_episodes; ++e) {
+        setup(sim,random_initial_state(e),time_step_width);
+        nb_steps += run_episode(sim,pl,duration,time_step_width);
+        z += sim.ac->get_state().getz() / nb_episodes;
+    }
+    if(cpu_ms) {*cpu_ms = (double) (std::clock() - start) / CLOCKS_PER_SEC / nb_steps * 1e3;}
+    return z;
+}
+
+}
+
+#endif
@@ -0,0 +1,66 @@
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <cassert>
+#include <ctime>
+#include "bench_fixture.hpp"
+#include <q_learning/lspi_solver.hpp>
+
+/**
+ * Sample efficiency of 'lspi_solver.hpp'
+ * The linear Q-function of 'q_learning_pilot' is learned either online (stochastic updates) or
+ * by LSPI from the transitions recorded by an exploring pilot, for increasing numbers of simulated
+ * transitions. Each resulting greedy policy is evaluated without learning on a few episodes of the
+ * scenario of 'config/' and its mean final altitude is printed.
+ */
+
+using namespace L2Fsim;
+
+const double episode_duration = 200.;
+const double time_step_width = .1;
+const double discount_factor = .9; ///< LSPI oscillates between policies with .99 on this problem
+
+/** @brief Run episodes, return the mean final altitude */
+double run(q_learning_pilot &pl, unsigned int nb_episodes) {
+    simulation sim;
+    double z = 0.;
+    for(unsigned int e=0; e<nb_episodes; ++e) {
+        bench::setup(sim,bench::initial_state(),time_step_width);
+        pl.begin_episode();
+        bench::run_episode(sim,pl,episode_duration,time_step_width);
+        z += sim.ac->get_state().getz() / nb_episodes;
+    }
+    return z;
+}
+
+/** @brief Mean final altitude of the greedy policy of some parameters */
+double evaluate(const q_learning_pilot::parameters_type &parameters) {
+    q_learning_pilot pl(2*TO_RAD,.01,0.,0.,discount_factor,0);
+    pl.parameters = parameters;
+    return run(pl,4);
+}
+
+int main() {
+    unsigned int steps_per_episode = (unsigned int) (episode_duration / time_step_width);
+    std::cout << std::fixed << std::setprecision(1);
+    for(unsigned int nb_episodes : {1u, 4u, 16u}) {
+        unsigned int n = nb_episodes * steps_per_episode;
+        q_learning_pilot online(2*TO_RAD,.01,.1,.001,discount_factor,0);
+        run(online,nb_episodes);
+
+        q_learning_pilot explorer(2*TO_RAD,.01,.5,0.,discount_factor,0,0,"zdot",8,16,1.,n,0);
+        run(explorer,nb_episodes);
+        lspi_solver solver;
+        solver.add(explorer.replay);
+        std::clock_t c = std::clock();
+        double change = solver.solve(explorer);
+        double solve_time = (double) (std::clock() - c) / CLOCKS_PER_SEC;
+        for(double w : explorer.parameters) {assert(std::isfinite(w));}
+
+        std::cout << std::setw(6) << n << " transitions: online " << std::setw(6) << evaluate(online.parameters)
+                  << " m, LSPI " << std::setw(6) << evaluate(explorer.parameters) << " m ("
+                  << solver.nb_iterations << " iterations, last change " << std::setprecision(3) << change
+                  << ", " << solve_time << " s)" << std::setprecision(1) << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,72 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include "bench_fixture.hpp"
+#include <optimistic/optimistic_pilot.hpp>
+#include <lookup_table/lut_distiller.hpp>
+
+/**
+ * Distillation of 'optimistic_pilot' into a 'lookup_table_pilot' ('lut_distiller.hpp')
+ * The states visited by the planner from random initial positions and headings are labelled by
+ * the planner, in parallel, the even episodes fitting the table and the odd ones measuring its
+ * agreement with the planner. The decision times of both pilots and their mean final altitudes
+ * in closed loop are printed, and the table is saved as 'lookup_table.bin' (see 'pilot_io.hpp').
+ */
+
+using namespace L2Fsim;
+
+const double arm = 2. * TO_RAD;
+const double kdalpha = .01;
+const double time_step_width = .1;
+const double episode_duration = 100.;
+const unsigned int budget = 200;
+
+void setup(simulation &sim, unsigned int episode) {
+    bench::setup(sim,bench::random_initial_state(episode),time_step_width);
+}
+
+std::unique_ptr<pilot> make_planner() {
+    beeler_glider ac_model(bench::random_initial_state(0),beeler_glider_command());
+    return std::unique_ptr<pilot>(new optimistic_pilot(ac_model,bench::sc_path,bench::envt_cfg_path,0.,arm,kdalpha,time_step_width,time_step_width,.9,budget));
+}
+
+int main() {
+    typedef std::chrono::steady_clock clock;
+    unsigned int nb_threads = std::max(1u,std::thread::hardware_concurrency());
+    state_grid grid("x:-1500:1500:24,y:-1500:1500:24,khi:-3.1416:3.1416:12,sigma:-.7:.7:8");
+    lut_distiller fit_set(grid), test_set(grid);
+    std::unique_ptr<pilot> behaviour = make_planner();
+    for(unsigned int e=0; e<16; ++e) { // even episodes fit, odd ones test
+        (e % 2 == 0 ? fit_set : test_set).sample_states(*behaviour,[e](simulation &sim, unsigned int) {setup(sim,e);},1,episode_duration,time_step_width);
+    }
+
+    clock::time_point start = clock::now();
+    fit_set.label(make_planner,nb_threads);
+    test_set.label(make_planner,nb_threads);
+    double label_time = std::chrono::duration<double>(clock::now() - start).count();
+    std::size_t nb_labelled = fit_set.states.size() + test_set.states.size();
+
+    lookup_table_pilot table(arm,kdalpha);
+    fit_set.fit(table);
+    save_pilot_parameters(table,"lookup_table.bin");
+
+    volatile unsigned int sink = 0;
+    start = clock::now();
+    const unsigned int nb_rounds = 200;
+    for(unsigned int r=0; r<nb_rounds; ++r) {
+        for(const auto &s : test_set.states) {sink += table.table_action(s);}
+    }
+    double table_ns = std::chrono::duration<double>(clock::now() - start).count() / (nb_rounds * test_set.states.size()) * 1e9;
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << grid.size() << " cells, " << nb_labelled << " labelled states (" << nb_threads << " threads, "
+              << label_time / nb_labelled * 1e3 << " ms per planner decision)" << std::endl;
+    std::cout << "table decision: " << std::setprecision(1) << table_ns << " ns" << std::endl;
+    std::cout << "agreement: fit states " << std::setprecision(3) << lut_distiller::agreement(table,fit_set.states,fit_set.labels)
+              << ", held-out states " << lut_distiller::agreement(table,test_set.states,test_set.labels) << std::endl;
+    std::unique_ptr<pilot> planner = make_planner();
+    std::cout << std::setprecision(1) << "mean final altitude over 8 new episodes: planner " << bench::closed_loop(*planner,100,8,episode_duration,time_step_width)
+              << " m, table " << bench::closed_loop(table,100,8,episode_duration,time_step_width) << " m" << std::endl;
+    return 0;
+}
@@ -0,0 +1,43 @@
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <cassert>
+#include <thread>
+#include "bench_fixture.hpp"
+#include <q_learning/q_learning_trainer.hpp>
+
+/**
+ * Throughput of 'q_learning_trainer.hpp'
+ * The Q-learning pilots are trained on 1, 2, 4... simulations run concurrently, up to twice the
+ * number of cores, for a few seconds each. The number of learned transitions per second is
+ * printed with its ratio to the single simulation case. The simulations use the scenario of
+ * 'config/' and start from the same state, the first episode of a worker loads the scenario.
+ */
+
+using namespace L2Fsim;
+
+void setup(simulation &sim, unsigned int worker, unsigned int episode) {
+    (void) worker;
+    (void) episode;
+    bench::setup(sim,bench::initial_state());
+}
+
+int main() {
+    double duration = 3.;
+    unsigned int nb_cores = std::max(1u,std::thread::hardware_concurrency());
+    q_learning_pilot prototype(2*TO_RAD,.01,.01,.001,.99,0);
+    double ref = 0.;
+    std::cout << nb_cores << " cores, " << duration << " s per training" << std::endl;
+    for(unsigned int n=1; n<=2*nb_cores; n*=2) {
+        q_learning_trainer trainer(prototype,setup,n,.1,200.);
+        double rate = trainer.train(duration);
+        if(n == 1) {ref = rate;}
+        q_learning_pilot pl;
+        trainer.get_parameters(pl);
+        for(double w : pl.parameters) {assert(std::isfinite(w));}
+        std::cout << "  " << std::setw(3) << n << " simulations: " << std::fixed << std::setprecision(0)
+                  << std::setw(9) << rate << " transitions/s (x" << std::setprecision(2) << rate / ref << "), "
+                  << trainer.nb_episodes << " episodes" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,166 @@
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cassert>
+#include <sstream>
+#include <flight_zone.hpp>
+#include <flat_zone.hpp>
+#include <flat_thermal_soaring_zone.hpp>
+#include <beeler_glider/beeler_glider.hpp>
+#include <beeler_glider/beeler_glider_jacobian.hpp>
+#include <euler_integrator.hpp>
+#include <rk4_integrator.hpp>
+
+/**
+ * Compare the forward-mode derivatives of the wind models and of the transitions of Beeler's glider
+ * with central finite differences.
+ * Run from the root of the repository (the flight zone is read in 'config/').
+ */
+
+using namespace L2Fsim;
+
+const double tolerance = 1e-5;
+
+/** @brief Maximum relative error between two Jacobians */
+double max_error(const std::vector<double> &ad, const std::vector<double> &fd) {
+    assert(ad.size() == fd.size());
+    double e = 0.;
+    for(unsigned int i=0; i<ad.size(); ++i) {
+        e = std::max(e, std::fabs(ad[i] - fd[i]) / (1. + std::fabs(fd[i])));
+    }
+    return e;
+}
+
+/** @brief Variables of a state in the order of the Jacobians */
+double & variable(beeler_glider_state &s, unsigned int i) {
+    double *v[9] = {&s.x, &s.y, &s.z, &s.V, &s.gamma, &s.khi, &s.alpha, &s.beta, &s.sigma};
+    return *v[i];
+}
+
+double & variable(beeler_glider_command &u, unsigned int i) {
+    double *v[3] = {&u.dalpha, &u.dbeta, &u.dsigma};
+    return *v[i];
+}
+
+/** @brief Transition of the double precision glider */
+beeler_glider_state next_state(
+    flight_zone &fz,
+    unsigned int integrator_selector,
+    const beeler_glider_state &s,
+    const beeler_glider_command &u,
+    double t, double Dt, double sdt)
+{
+    beeler_glider ac(s,u);
+    if(integrator_selector == 0) {euler_integrator::transition_function(ac,fz,t,Dt,sdt);}
+    else {rk4_integrator::transition_function(ac,fz,t,Dt,sdt);}
+    return ac.s;
+}
+
+/** @brief Wind derivatives of the thermal models */
+void test_thermal_models() {
+    const double h = 1e-4;
+    for(int model=1; model<=5; ++model) {
+        std_thermal th(model,3.4,1375.74,-500.,3000.,50.,500.,0.,.673731);
+        th.set_horizontal_wind(0.,0.);
+        double p[3] = {62., 489., 300.};
+        std::vector<double> w = {.5, -.3, .1};
+        std::vector<double> dw(9,0.);
+        th.wind_derivatives(p[0],p[1],p[2],0.,w,dw);
+
+        std::vector<double> fd(9), wp(3), wm(3);
+        for(unsigned int j=0; j<3; ++j) {
+            double pj = p[j];
+            wp = {.5, -.3, .1};
+            wm = {.5, -.3, .1};
+            p[j] = pj + h; th.wind(p[0],p[1],p[2],0.,wp);
+            p[j] = pj - h; th.wind(p[0],p[1],p[2],0.,wm);
+            p[j] = pj;
+            for(unsigned int i=0; i<3; ++i) {fd[3*i+j] = (wp[i] - wm[i]) / (2. * h);}
+        }
+        std::vector<double> w0 = {.5, -.3, .1};
+        th.wind(p[0],p[1],p[2],0.,w0);
+        double e = max_error(dw,fd);
+        std::cout << "thermal model " << model << ": max error " << e << std::endl;
+        assert(e < tolerance);
+        for(unsigned int i=0; i<3; ++i) {assert(w[i] == w0[i]);}
+    }
+}
+
+/** @brief Jacobians of the dynamics and of the transitions */
+void test_glider(flight_zone &fz) {
+    const double t = 0., Dt = 1., sdt = .1;
+    std::vector<beeler_glider_state> states = {
+        beeler_glider_state(40.,470.,300.,14.,-.05,.4,.05,.01,.3),
+        beeler_glider_state(100.,450.,500.,12.,-.1,-2.,.1,-.02,-.2),
+        beeler_glider_state(55.,505.,200.,15.,0.,0.,.02,0.,0.) // wings-level, flying north
+    };
+    beeler_glider_command u(.01,-.005,.02);
+    beeler_glider ac(states[0],u);
+
+    for(auto &s : states) {
+        // dynamics
+        beeler_glider_jacobian jac(ac);
+        std::vector<double> f, F, fd(6*9);
+        jac.dynamics(fz,t,s,f,F);
+        for(unsigned int j=0; j<9; ++j) {
+            const double h = 1e-6;
+            beeler_glider_state sp(s), sm(s);
+            variable(sp,j) += h;
+            variable(sm,j) -= h;
+            beeler_glider acp(sp,u), acm(sm,u);
+            acp.update_state_dynamic(fz,t,acp.s);
+            acm.update_state_dynamic(fz,t,acm.s);
+            double rp[6] = {acp.s.xdot, acp.s.ydot, acp.s.zdot, acp.s.Vdot, acp.s.gammadot, acp.s.khidot};
+            double rm[6] = {acm.s.xdot, acm.s.ydot, acm.s.zdot, acm.s.Vdot, acm.s.gammadot, acm.s.khidot};
+            for(unsigned int i=0; i<6; ++i) {fd[i*9+j] = (rp[i] - rm[i]) / (2. * h);}
+        }
+        double e = max_error(F,fd);
+        std::cout << "dynamics: max error " << e << std::endl;
+        assert(e < tolerance);
+
+        // transitions
+        for(unsigned int integrator=0; integrator<2; ++integrator) {
+            beeler_glider_jacobian jac(ac,integrator);
+            beeler_glider_state s_next;
+            std::vector<double> A, B;
+            jac.transition(fz,t,Dt,sdt,s,u,s_next,A,B);
+
+            beeler_glider_state s_ref = next_state(fz,integrator,s,u,t,Dt,sdt);
+            for(unsigned int i=0; i<9; ++i) {assert(std::fabs(variable(s_next,i) - variable(s_ref,i)) < 1e-9);}
+
+            const double h = 1e-6;
+            std::vector<double> A_fd(9*9), B_fd(9*3);
+            for(unsigned int j=0; j<9; ++j) {
+                beeler_glider_state sp(s), sm(s);
+                variable(sp,j) += h;
+                variable(sm,j) -= h;
+                beeler_glider_state np = next_state(fz,integrator,sp,u,t,Dt,sdt);
+                beeler_glider_state nm = next_state(fz,integrator,sm,u,t,Dt,sdt);
+                for(unsigned int i=0; i<9; ++i) {A_fd[i*9+j] = (variable(np,i) - variable(nm,i)) / (2. * h);}
+            }
+            for(unsigned int j=0; j<3; ++j) {
+                beeler_glider_command up(u), um(u);
+                variable(up,j) += h;
+                variable(um,j) -= h;
+                beeler_glider_state np = next_state(fz,integrator,s,up,t,Dt,sdt);
+                beeler_glider_state nm = next_state(fz,integrator,s,um,t,Dt,sdt);
+                for(unsigned int i=0; i<9; ++i) {B_fd[i*3+j] = (variable(np,i) - variable(nm,i)) / (2. * h);}
+            }
+            double eA = max_error(A,A_fd);
+            double eB = max_error(B,B_fd);
+            std::cout << (integrator ? "rk4" : "euler") << " transition: max error A " << eA << " B " << eB << std::endl;
+            assert(eA < tolerance);
+            assert(eB < tolerance);
+        }
+    }
+}
+
+int main() {
+    test_thermal_models();
+    flat_thermal_soaring_zone fz("config/fz_scenario.csv","config/fz_config.csv");
+    test_glider(fz);
+    flat_zone fz_calm(2.,-1.); // default finite differences of the wind
+    test_glider(fz_calm);
+    std::cout << "test_jacobian: passed" << std::endl;
+    return 0;
+}